@@ -0,0 +1,372 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "aggregate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/invalid_sql_exception.h"
+#include "file_iterator.h"
+#include "key_hash.h"
+#include "page_iterator.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+const int HashAggregateOperator::DEFAULT_NUM_BUF_PAGES;
+const int HashAggregateOperator::MAX_PARTITION_LEVELS;
+
+string Aggregate::getOutputName() const {
+  static const char* const names[] = {"COUNT", "SUM", "MIN", "MAX", "AVG"};
+  if (attrName.empty())
+    return names[function];
+  return string(names[function]) + "_" + attrName;
+}
+
+TableSchema HashAggregateOperator::createResultSchema(
+    const TableSchema& inputSchema,
+    const vector<string>& groupAttrNames,
+    const vector<Aggregate>& aggregates) {
+  vector<Attribute> attrs;
+  for (const string& attrName : groupAttrNames) {
+    int num = inputSchema.getAttrNum(attrName);
+    if (num < 0)
+      throw InvalidSQLException(attrName, "unknown GROUP BY attribute");
+    attrs.push_back(Attribute(attrName, inputSchema.getAttrType(num),
+                              inputSchema.getAttrMaxSize(num)));
+  }
+  for (const Aggregate& aggregate : aggregates) {
+    if (!aggregate.attrName.empty()) {
+      int num = inputSchema.getAttrNum(aggregate.attrName);
+      if (num < 0)
+        throw InvalidSQLException(aggregate.getOutputName(),
+                                  "unknown aggregated attribute");
+      if (aggregate.function != AGG_COUNT &&
+          inputSchema.getAttrType(num) != INT)
+        throw InvalidSQLException(aggregate.getOutputName(),
+                                  "aggregate of a non-INT attribute");
+    } else if (aggregate.function != AGG_COUNT) {
+      throw InvalidSQLException(aggregate.getOutputName(),
+                                "only COUNT may omit its attribute");
+    }
+    attrs.push_back(Attribute(aggregate.getOutputName(), INT, 4));
+  }
+  return TableSchema("TEMP_TABLE", attrs, true);
+}
+
+HashAggregateOperator::HashAggregateOperator(
+    unique_ptr<Operator> input,
+    const vector<string>& groupAttrNames,
+    const vector<Aggregate>& aggregates,
+    BufMgr* bufMgr)
+    : Operator(createResultSchema(input->getSchema(), groupAttrNames,
+                                  aggregates),
+               bufMgr),
+      input(std::move(input)),
+      inputLayout(this->input->getSchema()),
+      aggregates(aggregates),
+      numStates(0),
+      slots(inputLayout.getAttrCount()),
+      tableBytes(0),
+      passLevel(0),
+      passSeed(0),
+      partitions(bufMgr),
+      numPartitionFiles(0),
+      numAvailableBufPages(DEFAULT_NUM_BUF_PAGES),
+      numUsedBufPages(0),
+      numGroups(0),
+      nextGroup(0) {
+  const TableSchema& input_schema = this->input->getSchema();
+  for (const string& attrName : groupAttrNames) {
+    groupAttrs.push_back(input_schema.getAttrNum(attrName));
+  }
+  for (const Aggregate& aggregate : aggregates) {
+    aggregateAttrs.push_back(aggregate.attrName.empty()
+                                 ? -1
+                                 : input_schema.getAttrNum(aggregate.attrName));
+    stateOffsets.push_back(numStates);
+    numStates += aggregate.function == AGG_AVG ? 2 : 1;
+  }
+  recordStates.resize(numStates);
+}
+
+void HashAggregateOperator::clearTable() {
+  groupTuples.clear();
+  groupOffsets.assign(1, 0);
+  groupHashes.clear();
+  groupStates.clear();
+  hashSlots.assign(16, 0);
+  tableBytes = hashSlots.size() * sizeof(std::uint32_t);
+  nextGroup = 0;
+}
+
+int HashAggregateOperator::findGroup(const char* group,
+                                     int length,
+                                     std::uint64_t hash) const {
+  const size_t mask = hashSlots.size() - 1;
+  for (size_t pos = hash & mask; hashSlots[pos] != 0; pos = (pos + 1) & mask) {
+    std::uint32_t num = hashSlots[pos] - 1;
+    if (groupHashes[num] == hash &&
+        groupOffsets[num + 1] - groupOffsets[num] == (std::uint32_t)length &&
+        memcmp(&groupTuples[groupOffsets[num]], group, length) == 0)
+      return num;
+  }
+  return -1;
+}
+
+void HashAggregateOperator::insertGroup(const char* group,
+                                        int length,
+                                        std::uint64_t hash,
+                                        const std::int64_t* states) {
+  const std::uint32_t num = groupHashes.size();
+  groupTuples.append(group, length);
+  groupOffsets.push_back(groupTuples.size());
+  groupHashes.push_back(hash);
+  groupStates.insert(groupStates.end(), states, states + numStates);
+  tableBytes += length + sizeof(std::uint32_t) + sizeof(std::uint64_t) +
+                numStates * sizeof(std::int64_t);
+  if ((size_t)(num + 1) * 2 > hashSlots.size()) {
+    // keep the table at most half full, rehashing the groups
+    tableBytes += hashSlots.size() * sizeof(std::uint32_t);
+    hashSlots.assign(hashSlots.size() * 2, 0);
+    const size_t mask = hashSlots.size() - 1;
+    for (std::uint32_t i = 0; i < num; ++i) {
+      size_t pos = groupHashes[i] & mask;
+      while (hashSlots[pos] != 0) {
+        pos = (pos + 1) & mask;
+      }
+      hashSlots[pos] = i + 1;
+    }
+  }
+  const size_t mask = hashSlots.size() - 1;
+  size_t pos = hash & mask;
+  while (hashSlots[pos] != 0) {
+    pos = (pos + 1) & mask;
+  }
+  hashSlots[pos] = num + 1;
+}
+
+void HashAggregateOperator::mergeStates(std::int64_t* states,
+                                        const std::int64_t* record) const {
+  for (size_t i = 0; i < aggregates.size(); ++i) {
+    const int s = stateOffsets[i];
+    switch (aggregates[i].function) {
+      case AGG_COUNT:
+      case AGG_SUM:
+        states[s] += record[s];
+        break;
+      case AGG_MIN:
+        states[s] = min(states[s], record[s]);
+        break;
+      case AGG_MAX:
+        states[s] = max(states[s], record[s]);
+        break;
+      case AGG_AVG:
+        states[s] += record[s];
+        states[s + 1] += record[s + 1];
+        break;
+    }
+  }
+}
+
+void HashAggregateOperator::addRecord(const char* record,
+                                      int size,
+                                      bool isPartial) {
+  const char* group;
+  int length;
+  const std::int64_t* states = recordStates.data();
+  if (isPartial) {
+    // the group attributes, then the states
+    length = size - numStates * (int)sizeof(std::int64_t);
+    group = record;
+    memcpy(recordStates.data(), record + length,
+           numStates * sizeof(std::int64_t));
+  } else {
+    inputLayout.locate(record, &slots[0]);
+    recordGroup.clear();
+    for (int num : groupAttrs) {
+      inputLayout.appendStored(record, slots[num], num, recordGroup);
+    }
+    group = recordGroup.data();
+    length = recordGroup.size();
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+      const int s = stateOffsets[i];
+      const int num = aggregateAttrs[i];
+      std::int64_t value = 1;
+      if (aggregates[i].function != AGG_COUNT)
+        value = TupleLayout::decodeInt(record + slots[num].offset);
+      recordStates[s] = value;
+      if (aggregates[i].function == AGG_AVG)
+        recordStates[s + 1] = 1;
+    }
+  }
+
+  const std::uint64_t hash = KeyHash::hash(group, length, passSeed);
+  if (partitions.isOpen()) {
+    writePartial(group, length, hash, states);
+    return;
+  }
+  int num = findGroup(group, length, hash);
+  if (num >= 0) {
+    mergeStates(&groupStates[(size_t)num * numStates], states);
+    return;
+  }
+  // a new group, which may not fit in the table
+  const size_t capacity = (size_t)(numAvailableBufPages - 1) * Page::DATA_SIZE;
+  const size_t group_bytes = length + sizeof(std::uint32_t) * 3 +
+                             sizeof(std::uint64_t) +
+                             numStates * sizeof(std::int64_t);
+  if (tableBytes + group_bytes > capacity &&
+      passLevel < MAX_PARTITION_LEVELS) {
+    startPartitioning();
+    writePartial(group, length, hash, states);
+    return;
+  }
+  insertGroup(group, length, hash, states);
+}
+
+void HashAggregateOperator::startPartitioning() {
+  // one output page per partition and one input page
+  const int num_partitions = numAvailableBufPages - 1;
+  partitions.create(input->getSchema().getTableName() + "_HA",
+                    num_partitions);
+  numPartitionFiles += num_partitions;
+  numUsedBufPages = max(numUsedBufPages, num_partitions + 1);
+
+  // the groups aggregated so far go into the partitions as they are
+  for (size_t num = 0; num < groupHashes.size(); ++num) {
+    writePartial(&groupTuples[groupOffsets[num]],
+                 groupOffsets[num + 1] - groupOffsets[num], groupHashes[num],
+                 &groupStates[num * numStates]);
+  }
+  clearTable();
+}
+
+void HashAggregateOperator::writePartial(const char* group,
+                                         int length,
+                                         std::uint64_t hash,
+                                         const std::int64_t* states) {
+  string partial(group, length);
+  partial.append((const char*)states, numStates * sizeof(std::int64_t));
+  partitions.append(KeyHash::toBucket(hash, partitions.getNumFiles()), partial);
+}
+
+void HashAggregateOperator::finishPass() {
+  numUsedBufPages =
+      max<int>(numUsedBufPages,
+               (tableBytes + Page::DATA_SIZE - 1) / Page::DATA_SIZE + 1);
+  if (!partitions.isOpen())
+    return;
+  partitions.close();
+  for (int i = 0; i < partitions.getNumFiles(); ++i) {
+    numIOs += partitions.getNumPages(i);
+    if (partitions.getNumPages(i) > 0)
+      pendingPartitions.push_back({partitions.getFilename(i), passLevel + 1});
+    else
+      File::remove(partitions.getFilename(i));
+  }
+}
+
+void HashAggregateOperator::aggregatePartition(const Partition& partition) {
+  clearTable();
+  passLevel = partition.level;
+  passSeed = KeyHash::seedOf(passLevel);
+  {
+    File file = File::open(partition.filename);
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      Page* page;
+      bufMgr->readPage(&file, iter.page_number(), page);
+      numIOs++;
+      try {
+        for (PageIterator page_iter = page->begin(); page_iter != page->end();
+             ++page_iter) {
+          std::uint16_t length;
+          const char* record = page_iter.data(length);
+          addRecord(record, length, true);
+        }
+      } catch (...) {
+        bufMgr->unPinPage(&file, iter.page_number(), false);
+        throw;
+      }
+      bufMgr->unPinPage(&file, iter.page_number(), false);
+    }
+    bufMgr->flushFile(&file);
+  }
+  File::remove(partition.filename);
+  finishPass();
+}
+
+void HashAggregateOperator::open() {
+  close();
+  numUsedBufPages = 0;
+  numGroups = 0;
+  numPartitionFiles = 0;
+  if (numAvailableBufPages < 3)
+    throw BufferExceededException();
+  clearTable();
+  passLevel = 0;
+  passSeed = KeyHash::seedOf(passLevel);
+  TupleView tuple;
+  input->open();
+  while (input->next(tuple)) {
+    addRecord(tuple.data, tuple.size, false);
+  }
+  input->close();
+  finishPass();
+}
+
+bool HashAggregateOperator::next(TupleView& tuple) {
+  while ((size_t)nextGroup == groupHashes.size()) {
+    if (pendingPartitions.empty())
+      return false;
+    Partition partition = pendingPartitions.front();
+    pendingPartitions.pop_front();
+    aggregatePartition(partition);
+  }
+  const int num = nextGroup++;
+  outputTuple.assign(&groupTuples[groupOffsets[num]],
+                     groupOffsets[num + 1] - groupOffsets[num]);
+  const std::int64_t* states = &groupStates[(size_t)num * numStates];
+  for (size_t i = 0; i < aggregates.size(); ++i) {
+    const int s = stateOffsets[i];
+    std::int64_t value = states[s];
+    if (aggregates[i].function == AGG_AVG)
+      value = states[s] / states[s + 1];
+    // 4 bytes, most significant byte first
+    for (int j = 3; j >= 0; --j) {
+      outputTuple += (char)(value >> (8 * j));
+    }
+  }
+  numGroups++;
+  tuple = TupleView(outputTuple);
+  return true;
+}
+
+void HashAggregateOperator::close() {
+  input->close();
+  // partitions left over by an error or an unfinished scan
+  partitions.remove();
+  for (const Partition& partition : pendingPartitions) {
+    File::remove(partition.filename);
+  }
+  pendingPartitions.clear();
+  groupTuples.clear();
+  groupOffsets.assign(1, 0);
+  groupHashes.clear();
+  groupStates.clear();
+  nextGroup = 0;
+}
+
+void HashAggregateOperator::printRunningStats() const {
+  cout << "# Result Tuples: " << numGroups << endl;
+  cout << "# Used Buffer Pages: " << numUsedBufPages << endl;
+  cout << "# I/Os: " << getNumIOs() << endl;
+  cout << "# Partition Files: " << numPartitionFiles << endl;
+}
+
+}  // namespace badgerdb
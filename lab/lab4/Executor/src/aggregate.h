@@ -0,0 +1,317 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "operator.h"
+#include "partition_files.h"
+#include "schema.h"
+#include "tuple.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Aggregate functions, prefixed so as not to clash with MIN and MAX macros
+ */
+enum AggregateFunction { AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG };
+
+/**
+ * Aggregate function of an attribute, e.g. AVG(Grade)
+ */
+struct Aggregate {
+  AggregateFunction function;
+
+  /**
+   * Aggregated attribute, an INT; empty for COUNT(*)
+   */
+  string attrName;
+
+  /**
+   * Constructor
+   */
+  Aggregate(AggregateFunction function, const string& attrName = "")
+      : function(function), attrName(attrName) {
+    // nothing
+  }
+
+  /**
+   * Get the name of the output attribute, e.g. AVG_Grade, or COUNT for
+   * COUNT(*)
+   */
+  string getOutputName() const;
+};
+
+/**
+ * Hash aggregation: groups the input tuples on a list of attributes and
+ * computes aggregate functions of every group, like
+ * SELECT Cno, AVG(Grade) FROM SC GROUP BY Cno. An output tuple holds the
+ * group attributes, then one INT per aggregate; AVG is the sum divided by
+ * the count, truncated, as there is no other numeric type. Without group
+ * attributes the whole input is one group, unless it is empty.
+ *
+ * The groups are kept in an open-addressing hash table in operator memory,
+ * keyed by the stored bytes of their group attributes, with the running
+ * state of every aggregate. If the table outgrows numAvailableBufPages - 1
+ * pages, the operator turns to Grace partitioning: the groups in the table
+ * and every later tuple are written as partial aggregates into
+ * numAvailableBufPages - 1 partition files through the buffer pool, by a
+ * hash of the group, and each partition is aggregated on its own
+ * afterwards, partitioned again one level deeper with a new seed if need
+ * be. A partition at the last level is aggregated in memory regardless.
+ */
+class HashAggregateOperator : public Operator {
+ private:
+  /**
+   * A partition file waiting to be aggregated
+   */
+  struct Partition {
+    string filename;
+    int level;
+  };
+
+  /**
+   * Input operator
+   */
+  unique_ptr<Operator> input;
+
+  /**
+   * Layout of the input tuples
+   */
+  TupleLayout inputLayout;
+
+  /**
+   * Input attribute number of every group attribute
+   */
+  vector<int> groupAttrs;
+
+  /**
+   * Aggregates, the input attribute number of each, -1 for COUNT(*), and
+   * the position of its first state in the states of a group
+   */
+  vector<Aggregate> aggregates;
+  vector<int> aggregateAttrs;
+  vector<int> stateOffsets;
+
+  /**
+   * Number of states of a group: two for AVG, the sum and the count, one
+   * for the other functions
+   */
+  int numStates;
+
+  /**
+   * Attribute locations in the current input tuple
+   */
+  vector<AttrSlot> slots;
+
+  /**
+   * Group attributes of the current tuple, as stored, and its states
+   */
+  string recordGroup;
+  vector<std::int64_t> recordStates;
+
+  /**
+   * Groups of the table: their group attributes back to back, where each
+   * one starts followed by the end of the last one, their hashes and their
+   * states, numStates per group
+   */
+  string groupTuples;
+  vector<std::uint32_t> groupOffsets;
+  vector<std::uint64_t> groupHashes;
+  vector<std::int64_t> groupStates;
+
+  /**
+   * Open-addressing hash table with linear probing, a power of two slots
+   * at most half full: every slot is a group number plus one, or 0 if empty
+   */
+  vector<std::uint32_t> hashSlots;
+
+  /**
+   * Bytes of operator memory taken by the table
+   */
+  size_t tableBytes;
+
+  /**
+   * Partitioning level of the current pass, whose seed hashes the groups
+   */
+  int passLevel;
+  std::uint64_t passSeed;
+
+  /**
+   * Partition files of the current pass, open only once it has turned to
+   * partitioning
+   */
+  PartitionFiles partitions;
+
+  /**
+   * Partitions written, not aggregated yet
+   */
+  deque<Partition> pendingPartitions;
+
+  /**
+   * Number of partition files created, also naming them
+   */
+  int numPartitionFiles;
+
+  /**
+   * Number of buffer pages the operator may use, and actually used
+   */
+  int numAvailableBufPages;
+  int numUsedBufPages;
+
+  /**
+   * Number of groups produced
+   */
+  int numGroups;
+
+  /**
+   * Next group of the table to produce
+   */
+  int nextGroup;
+
+  /**
+   * Current output tuple
+   */
+  string outputTuple;
+
+  /**
+   * Empty the table
+   */
+  void clearTable();
+
+  /**
+   * Find the group with the given attributes and hash in the table
+   * @return Group number, or -1 if there is none
+   */
+  int findGroup(const char* group, int length, std::uint64_t hash) const;
+
+  /**
+   * Add a group to the table with the states of a record
+   */
+  void insertGroup(const char* group,
+                   int length,
+                   std::uint64_t hash,
+                   const std::int64_t* states);
+
+  /**
+   * Fold the states of a record into those of a group
+   */
+  void mergeStates(std::int64_t* states, const std::int64_t* record) const;
+
+  /**
+   * Aggregate an input tuple, or a partial aggregate read from a partition
+   */
+  void addRecord(const char* record, int size, bool isPartial);
+
+  /**
+   * Turn the current pass to partitioning: create the partition files and
+   * move the groups of the table into them
+   */
+  void startPartitioning();
+
+  /**
+   * Write a group and its states into the partition of its hash
+   */
+  void writePartial(const char* group,
+                    int length,
+                    std::uint64_t hash,
+                    const std::int64_t* states);
+
+  /**
+   * Close the partition files of the current pass, if any, and queue them
+   */
+  void finishPass();
+
+  /**
+   * Aggregate a partition file into the table, then remove it
+   */
+  void aggregatePartition(const Partition& partition);
+
+ public:
+  /**
+   * Number of buffer pages used unless set otherwise
+   */
+  static const int DEFAULT_NUM_BUF_PAGES = 100;
+
+  /**
+   * Max number of times a group is partitioned. The tuples of one group
+   * fold into one entry of the table, so unlike a join key a frequent group
+   * never keeps a partition from fitting; only the number of groups decides
+   * the depth.
+   */
+  static const int MAX_PARTITION_LEVELS = 8;
+
+  /**
+   * Constructor
+   * @param groupAttrNames Attributes to group on, in output order; empty
+   *                       for a single group
+   */
+  HashAggregateOperator(unique_ptr<Operator> input,
+                        const vector<string>& groupAttrNames,
+                        const vector<Aggregate>& aggregates,
+                        BufMgr* bufMgr);
+
+  /**
+   * Destructor
+   */
+  ~HashAggregateOperator() { close(); }
+
+  string getOperatorName() const { return "HASH_AGGREGATE"; }
+
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close();
+
+  int getNumIOs() const { return numIOs + input->getNumIOs(); }
+
+  int getEstimatedPages() const { return input->getEstimatedPages(); }
+
+  /**
+   * Set the number of buffer pages the operator may use, at least 3
+   */
+  void setNumAvailableBufPages(int numAvailableBufPages) {
+    this->numAvailableBufPages = numAvailableBufPages;
+  }
+
+  /**
+   * Get the number of buffer pages used
+   */
+  int getNumUsedBufPages() const { return numUsedBufPages; }
+
+  /**
+   * Get the number of groups produced
+   */
+  int getNumGroups() const { return numGroups; }
+
+  /**
+   * Get the number of partition files written
+   */
+  int getNumPartitionFiles() const { return numPartitionFiles; }
+
+  /**
+   * Print the running statistics of the operator
+   */
+  void printRunningStats() const;
+
+  /**
+   * Create the schema of the output: the group attributes, then an INT per
+   * aggregate
+   */
+  static TableSchema createResultSchema(const TableSchema& inputSchema,
+                                        const vector<string>& groupAttrNames,
+                                        const vector<Aggregate>& aggregates);
+};
+
+}  // namespace badgerdb
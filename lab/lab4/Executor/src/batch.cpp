@@ -0,0 +1,572 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "batch.h"
+
+#include <cstring>
+
+#include "executor.h"
+#include "key_hash.h"
+#include "simd_scan.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Compact a selection vector to the rows satisfying a predicate. The row is
+ * always written and the output position only advanced on a match, so the
+ * loop has no data-dependent branch.
+ */
+template <typename Condition>
+static int selectRows(std::uint16_t* selection,
+                      int numSelected,
+                      Condition condition) {
+  int num = 0;
+  for (int i = 0; i < numSelected; ++i) {
+    std::uint16_t row = selection[i];
+    selection[num] = row;
+    num += condition(row) ? 1 : 0;
+  }
+  return num;
+}
+
+/**
+ * Hash numKeys keys of width bytes stored one after the other, up to
+ * KeyHash::MAX_BATCH of them together
+ */
+static void hashKeys(const char* keys,
+                     int numKeys,
+                     int width,
+                     std::uint64_t* hashes) {
+  const std::uint64_t seed = KeyHash::seedOf(0);
+  const void* batch_keys[KeyHash::MAX_BATCH];
+  for (int first = 0; first < numKeys; first += KeyHash::MAX_BATCH) {
+    int num = min(KeyHash::MAX_BATCH, numKeys - first);
+    for (int k = 0; k < num; ++k) {
+      batch_keys[k] = keys + (size_t)(first + k) * width;
+    }
+    KeyHash::hashBatch(batch_keys, num, width, seed, hashes + first);
+  }
+}
+
+void RowBatch::reset(const TableSchema& tableSchema) {
+  columns.resize(tableSchema.getAttrCount());
+  for (int i = 0; i < tableSchema.getAttrCount(); ++i) {
+    columns[i].type = tableSchema.getAttrType(i);
+  }
+  numRows = 0;
+  numSelected = 0;
+}
+
+void RowBatch::resize(int num) {
+  numRows = num;
+  for (ColumnVector& column : columns) {
+    if (column.type == INT) {
+      column.ints.resize(num);
+    } else {
+      column.chars.resize(num);
+      column.lengths.resize(num);
+    }
+  }
+}
+
+void RowBatch::selectAll() {
+  selection.resize(numRows);
+  for (int i = 0; i < numRows; ++i) {
+    selection[i] = i;
+  }
+  numSelected = numRows;
+}
+
+void RowBatch::appendTuple(int row,
+                           const TableSchema& tableSchema,
+                           string& tuple) const {
+  for (int i = 0; i < (int)columns.size(); ++i) {
+    const ColumnVector& column = columns[i];
+    switch (column.type) {
+      case INT: {  // 4 bytes, most significant byte first
+        unsigned value = column.ints[row];
+        for (int j = 3; j >= 0; --j) {
+          tuple += (char)(value >> (8 * j));
+        }
+        break;
+      }
+      case CHAR: {  // already padded up to the max length
+        int max_len = tableSchema.getAttrMaxSize(i);
+        tuple.append(column.chars[row], column.lengths[row]);
+        tuple.append((4 - (max_len % 4)) % 4, '0');
+        break;
+      }
+      case VARCHAR: {
+        int length = column.lengths[row];
+        tuple += (char)length;
+        tuple.append(column.chars[row], length);
+        tuple.append((4 - ((length + 1) % 4)) % 4, '0');
+        break;
+      }
+    }
+  }
+}
+
+long long BatchOperator::count() {
+  long long num_tuples = 0;
+  RowBatch batch;
+  open();
+  while (nextBatch(batch)) {
+    num_tuples += batch.numSelected;
+  }
+  close();
+  return num_tuples;
+}
+
+void BatchScanOperator::releasePages() {
+  for (PageId page_number : retiredPages) {
+    bufMgr->unPinPage(&file, page_number, false);
+  }
+  retiredPages.clear();
+}
+
+void BatchScanOperator::open() {
+  close();
+  fileIter = file.begin();
+}
+
+bool BatchScanOperator::nextBatch(RowBatch& batch) {
+  // the last batch is no longer used
+  releasePages();
+
+  // collect the tuples of the batch, keeping their pages pinned
+  rows.clear();
+  while ((int)rows.size() < RowBatch::CAPACITY) {
+    if (currentPage != nullptr) {
+      if (pageIter != currentPage->end()) {
+        std::uint16_t length;
+        rows.push_back(pageIter.data(length));
+        ++pageIter;
+        continue;
+      }
+      // the page is used up, but this batch may still point into it
+      retiredPages.push_back(fileIter.page_number());
+      currentPage = nullptr;
+      ++fileIter;
+      if (rows.empty())
+        releasePages();  // no tuple of the batch is in it
+      else if ((int)retiredPages.size() >= MAX_BATCH_PAGES)
+        break;  // the batch pins as many pages as it may
+    }
+    if (fileIter.page_number() == Page::INVALID_NUMBER)
+      break;  // end of the file, or not opened
+    bufMgr->readPage(&file, fileIter.page_number(), currentPage);
+    numIOs++;
+    pageIter = currentPage->begin();
+  }
+
+  int num_rows = rows.size();
+  int num_attrs = layout.getAttrCount();
+  batch.reset(schema);
+  batch.resize(num_rows);
+  if (num_rows == 0)
+    return false;
+
+  // attributes after a VARCHAR have to be located tuple by tuple
+  bool all_fixed = layout.getFixedOffset(num_attrs - 1) >= 0;
+  if (!all_fixed) {
+    slots.resize(num_rows * num_attrs);
+    for (int r = 0; r < num_rows; ++r) {
+      layout.locate(rows[r], &slots[r * num_attrs]);
+    }
+  }
+
+  // decode one column at a time
+  const char* const* row_data = rows.data();
+  for (int i = 0; i < num_attrs; ++i) {
+    ColumnVector& column = batch.columns[i];
+    int offset = layout.getFixedOffset(i);
+    switch (column.type) {
+      case INT: {
+        std::int32_t* values = column.ints.data();
+        if (offset >= 0) {
+          for (int r = 0; r < num_rows; ++r) {
+            values[r] = TupleLayout::decodeInt(row_data[r] + offset);
+          }
+        } else {
+          for (int r = 0; r < num_rows; ++r) {
+            values[r] = TupleLayout::decodeInt(
+                row_data[r] + slots[r * num_attrs + i].offset);
+          }
+        }
+        break;
+      }
+      case CHAR: {
+        std::uint16_t max_len = schema.getAttrMaxSize(i);
+        for (int r = 0; r < num_rows; ++r) {
+          column.chars[r] =
+              row_data[r] +
+              (offset >= 0 ? offset : slots[r * num_attrs + i].offset);
+          column.lengths[r] = max_len;
+        }
+        break;
+      }
+      case VARCHAR: {
+        for (int r = 0; r < num_rows; ++r) {
+          const AttrSlot* slot = all_fixed ? nullptr : &slots[r * num_attrs + i];
+          int value_offset = offset >= 0 ? offset + 1 : slot->offset;
+          column.chars[r] = row_data[r] + value_offset;
+          column.lengths[r] = (unsigned char)row_data[r][value_offset - 1];
+        }
+        break;
+      }
+    }
+  }
+  batch.selectAll();
+  return true;
+}
+
+void BatchScanOperator::close() {
+  releasePages();
+  if (currentPage != nullptr) {
+    bufMgr->unPinPage(&file, fileIter.page_number(), false);
+    currentPage = nullptr;
+  }
+  // the frames are keyed by this operator's file handle
+  bufMgr->flushFile(&file);
+  fileIter = FileIterator();
+}
+
+int BatchScanOperator::getEstimatedPages() const {
+  return HeapFileManager::getNumPages(file, catalog);
+}
+
+BatchFilterOperator::BatchFilterOperator(unique_ptr<BatchOperator> input,
+                                         const string& attrName,
+                                         CompareOp op,
+                                         const string& value,
+                                         BufMgr* bufMgr)
+    : BatchOperator(input->getSchema(), bufMgr),
+      input(std::move(input)),
+      attrNum(schema.getAttrNum(attrName)),
+      op(op),
+      intValue(0) {
+  // encoded as the row operators' predicates encode it
+  Predicate::makeKey(schema, attrNum, value, &charValue);
+  if (schema.getAttrType(attrNum) == INT) {
+    intValue = TupleLayout::decodeInt(charValue.data());
+    charValue.clear();
+  }
+}
+
+bool BatchFilterOperator::nextBatch(RowBatch& batch) {
+  while (input->nextBatch(batch)) {
+    const ColumnVector& column = batch.columns[attrNum];
+    std::uint16_t* selection = batch.selection.data();
+    int num = batch.numSelected;
+    if (column.type == INT) {
+      // compare every row with the kernels, then keep the selected ones
+      bitmap.resize(IntScanKernels::getBitmapWords(batch.numRows));
+      const std::uint64_t* bits = bitmap.data();
+      IntScanKernels::selectColumn(column.ints.data(), batch.numRows, op,
+                                   intValue, bitmap.data());
+      if (num == batch.numRows) {
+        num = IntScanKernels::toSelection(bits, batch.numRows, selection);
+      } else {
+        num = selectRows(selection, num, [bits](std::uint16_t row) {
+          return (bits[row / 64] >> (row % 64)) & 1;
+        });
+      }
+    } else {
+      const char* const* chars = column.chars.data();
+      const std::uint16_t* lengths = column.lengths.data();
+      const string& value = charValue;
+      CompareOp compare_op = op;
+      num = selectRows(selection, num, [&](std::uint16_t row) {
+        return Predicate::satisfies(
+            compare_op,
+            Predicate::compareChars(chars[row], lengths[row], value));
+      });
+    }
+    batch.numSelected = num;
+    if (num > 0)
+      return true;
+  }
+  return false;
+}
+
+BatchProjectOperator::BatchProjectOperator(unique_ptr<BatchOperator> input,
+                                           const vector<string>& attrNames,
+                                           BufMgr* bufMgr)
+    : BatchOperator(input->getSchema(), bufMgr), input(std::move(input)) {
+  vector<Attribute> attrs;
+  for (const string& attrName : attrNames) {
+    const TableSchema& input_schema = this->input->getSchema();
+    int num = input_schema.getAttrNum(attrName);
+    attrNums.push_back(num);
+    attrs.push_back(Attribute(
+        attrName, input_schema.getAttrType(num), input_schema.getAttrMaxSize(num),
+        input_schema.isAttrNotNull(num), input_schema.isAttrUnique(num)));
+  }
+  schema = TableSchema("TEMP_TABLE", attrs, true);
+}
+
+bool BatchProjectOperator::nextBatch(RowBatch& batch) {
+  if (!input->nextBatch(inputBatch))
+    return false;
+  batch.columns.resize(attrNums.size());
+  for (int j = 0; j < (int)attrNums.size(); ++j) {
+    batch.columns[j] = inputBatch.columns[attrNums[j]];
+  }
+  batch.numRows = inputBatch.numRows;
+  batch.selection = inputBatch.selection;
+  batch.numSelected = inputBatch.numSelected;
+  return true;
+}
+
+BatchHashJoinOperator::BatchHashJoinOperator(
+    unique_ptr<BatchOperator> leftInput,
+    unique_ptr<BatchOperator> rightInput,
+    BufMgr* bufMgr)
+    : BatchOperator(
+          JoinOperator::createResultTableSchema(leftInput->getSchema(),
+                                                rightInput->getSchema()),
+          bufMgr),
+      leftInput(std::move(leftInput)),
+      rightInput(std::move(rightInput)),
+      keyWidth(0),
+      numBuildRows(0),
+      numBuckets(0),
+      probePos(0),
+      chainPos(-1) {
+  const TableSchema& left_schema = this->leftInput->getSchema();
+  const TableSchema& right_schema = this->rightInput->getSchema();
+  buildLeft = this->leftInput->getEstimatedPages() <
+              this->rightInput->getEstimatedPages();
+
+  // join on the attributes with the same name and type, with keys wide
+  // enough for the longer of the two values
+  vector<int> left_keys, right_keys;
+  vector<bool> right_common(right_schema.getAttrCount(), false);
+  for (int j = 0; j < left_schema.getAttrCount(); ++j) {
+    for (int i = 0; i < right_schema.getAttrCount(); ++i) {
+      if (left_schema.getAttrType(j) == right_schema.getAttrType(i) &&
+          left_schema.getAttrName(j) == right_schema.getAttrName(i)) {
+        int width = left_schema.getAttrType(j) == INT
+                        ? 4
+                        : max(left_schema.getAttrMaxSize(j),
+                              right_schema.getAttrMaxSize(i));
+        left_keys.push_back(j);
+        right_keys.push_back(i);
+        keyAttrWidths.push_back(width);
+        keyWidth += width;
+        right_common[i] = true;
+      }
+    }
+  }
+  buildKeyAttrs = buildLeft ? left_keys : right_keys;
+  probeKeyAttrs = buildLeft ? right_keys : left_keys;
+
+  // the result has the left attributes, then the other right attributes
+  for (int j = 0; j < left_schema.getAttrCount(); ++j) {
+    ColumnSource source = {buildLeft, j};
+    outputSources.push_back(source);
+  }
+  for (int i = 0; i < right_schema.getAttrCount(); ++i) {
+    if (!right_common[i]) {
+      ColumnSource source = {!buildLeft, i};
+      outputSources.push_back(source);
+    }
+  }
+}
+
+void BatchHashJoinOperator::encodeKeys(const RowBatch& batch,
+                                       const vector<int>& keyAttrs,
+                                       vector<char>& keys) const {
+  int num = batch.numSelected;
+  const std::uint16_t* selection = batch.selection.data();
+  keys.assign((size_t)num * keyWidth, 0);
+  int key_offset = 0;
+  for (int k = 0; k < (int)keyAttrs.size(); ++k) {
+    const ColumnVector& column = batch.columns[keyAttrs[k]];
+    int width = keyAttrWidths[k];
+    char* out = keys.data() + key_offset;
+    if (column.type == INT) {
+      const std::int32_t* values = column.ints.data();
+      for (int i = 0; i < num; ++i) {
+        memcpy(out + (size_t)i * keyWidth, &values[selection[i]], 4);
+      }
+    } else {
+      for (int i = 0; i < num; ++i) {
+        std::uint16_t row = selection[i];
+        memcpy(out + (size_t)i * keyWidth, column.chars[row],
+               min<int>(column.lengths[row], width));
+      }
+    }
+    key_offset += width;
+  }
+}
+
+void BatchHashJoinOperator::build() {
+  BatchOperator* input = buildLeft ? leftInput.get() : rightInput.get();
+  buildColumns.assign(input->getSchema().getAttrCount(), BuildColumn());
+  buildKeys.clear();
+  numBuildRows = 0;
+
+  RowBatch batch;
+  vector<char> keys;
+  while (input->nextBatch(batch)) {
+    encodeKeys(batch, buildKeyAttrs, keys);
+    buildKeys.insert(buildKeys.end(), keys.begin(), keys.end());
+    int num = batch.numSelected;
+    const std::uint16_t* selection = batch.selection.data();
+    for (int c = 0; c < (int)buildColumns.size(); ++c) {
+      const ColumnVector& column = batch.columns[c];
+      BuildColumn& build_column = buildColumns[c];
+      if (column.type == INT) {
+        for (int i = 0; i < num; ++i) {
+          build_column.ints.push_back(column.ints[selection[i]]);
+        }
+      } else {  // copy the characters, the pages will be unpinned
+        for (int i = 0; i < num; ++i) {
+          std::uint16_t row = selection[i];
+          build_column.offsets.push_back(build_column.arena.size());
+          build_column.lengths.push_back(column.lengths[row]);
+          build_column.arena.append(column.chars[row], column.lengths[row]);
+        }
+      }
+    }
+    numBuildRows += num;
+  }
+
+  // about one row per bucket
+  numBuckets = max(numBuildRows, 1);
+  bucketHeads.assign(numBuckets, -1);
+  chainNext.assign(numBuildRows, -1);
+  vector<std::uint64_t> hashes(numBuildRows);
+  hashKeys(buildKeys.data(), numBuildRows, keyWidth, hashes.data());
+  // insert backwards, so that the chains keep the input order
+  for (int r = numBuildRows - 1; r >= 0; --r) {
+    std::uint32_t bucket = KeyHash::toBucket(hashes[r], numBuckets);
+    chainNext[r] = bucketHeads[bucket];
+    bucketHeads[bucket] = r;
+  }
+}
+
+void BatchHashJoinOperator::open() {
+  close();
+  BatchOperator* build_input = buildLeft ? leftInput.get() : rightInput.get();
+  BatchOperator* probe_input = buildLeft ? rightInput.get() : leftInput.get();
+  build_input->open();
+  build();
+  build_input->close();
+  probe_input->open();
+}
+
+bool BatchHashJoinOperator::nextBatch(RowBatch& batch) {
+  BatchOperator* probe_input = buildLeft ? rightInput.get() : leftInput.get();
+  matchProbeRows.clear();
+  matchBuildRows.clear();
+  while ((int)matchProbeRows.size() < RowBatch::CAPACITY) {
+    if (probePos >= probeBatch.numSelected) {
+      if (!matchProbeRows.empty())
+        break;  // the matches still point into the current probe batch
+      if (numBuildRows == 0 || !probe_input->nextBatch(probeBatch))
+        break;
+      encodeKeys(probeBatch, probeKeyAttrs, probeKeys);
+      probeHashes.resize(probeBatch.numSelected);
+      hashKeys(probeKeys.data(), probeBatch.numSelected, keyWidth,
+               probeHashes.data());
+      probePos = 0;
+      if (probeBatch.numSelected > 0)
+        chainPos = bucketHeads[KeyHash::toBucket(probeHashes[0], numBuckets)];
+      continue;
+    }
+
+    // follow the chain of the current probe row, possibly across calls
+    const char* key = probeKeys.data() + (size_t)probePos * keyWidth;
+    std::uint16_t probe_row = probeBatch.selection[probePos];
+    while (chainPos >= 0 &&
+           (int)matchProbeRows.size() < RowBatch::CAPACITY) {
+      if (memcmp(buildKeys.data() + (size_t)chainPos * keyWidth, key,
+                 keyWidth) == 0) {
+        matchProbeRows.push_back(probe_row);
+        matchBuildRows.push_back(chainPos);
+      }
+      chainPos = chainNext[chainPos];
+    }
+    if (chainPos < 0 && ++probePos < probeBatch.numSelected)
+      chainPos =
+          bucketHeads[KeyHash::toBucket(probeHashes[probePos], numBuckets)];
+  }
+
+  // gather the output columns
+  int num = matchProbeRows.size();
+  batch.reset(schema);
+  batch.resize(num);
+  for (int j = 0; j < (int)outputSources.size(); ++j) {
+    const ColumnSource& source = outputSources[j];
+    ColumnVector& column = batch.columns[j];
+    if (source.fromBuild) {
+      const BuildColumn& build_column = buildColumns[source.column];
+      if (column.type == INT) {
+        for (int i = 0; i < num; ++i) {
+          column.ints[i] = build_column.ints[matchBuildRows[i]];
+        }
+      } else {
+        for (int i = 0; i < num; ++i) {
+          std::int32_t row = matchBuildRows[i];
+          column.chars[i] = build_column.arena.data() + build_column.offsets[row];
+          column.lengths[i] = build_column.lengths[row];
+        }
+      }
+    } else {
+      const ColumnVector& probe_column = probeBatch.columns[source.column];
+      if (column.type == INT) {
+        for (int i = 0; i < num; ++i) {
+          column.ints[i] = probe_column.ints[matchProbeRows[i]];
+        }
+      } else {
+        for (int i = 0; i < num; ++i) {
+          std::uint16_t row = matchProbeRows[i];
+          column.chars[i] = probe_column.chars[row];
+          column.lengths[i] = probe_column.lengths[row];
+        }
+      }
+    }
+  }
+  batch.selectAll();
+  return num > 0;
+}
+
+void BatchHashJoinOperator::close() {
+  leftInput->close();
+  rightInput->close();
+  buildColumns.clear();
+  buildKeys.clear();
+  bucketHeads.clear();
+  chainNext.clear();
+  numBuildRows = 0;
+  probeBatch.numSelected = 0;
+  probePos = 0;
+  chainPos = -1;
+}
+
+void BatchToRowOperator::open() {
+  input->open();
+  batch.numSelected = 0;
+  batchPos = 0;
+}
+
+bool BatchToRowOperator::next(TupleView& tuple) {
+  while (batchPos >= batch.numSelected) {
+    if (!input->nextBatch(batch))
+      return false;
+    batchPos = 0;
+  }
+  this->tuple.clear();
+  batch.appendTuple(batch.selection[batchPos++], schema, this->tuple);
+  tuple = TupleView(this->tuple);
+  return true;
+}
+
+}  // namespace badgerdb
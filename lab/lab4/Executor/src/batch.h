@@ -0,0 +1,565 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "catalog.h"
+#include "file.h"
+#include "file_iterator.h"
+#include "operator.h"
+#include "page_iterator.h"
+#include "predicate.h"
+#include "schema.h"
+#include "tuple.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Values of one attribute for the rows of a RowBatch
+ */
+struct ColumnVector {
+  /**
+   * Attribute type
+   */
+  DataType type;
+
+  /**
+   * INT values
+   */
+  vector<std::int32_t> ints;
+
+  /**
+   * CHAR and VARCHAR values: first character, pointing into a pinned page or
+   * into the memory of an operator
+   */
+  vector<const char*> chars;
+
+  /**
+   * CHAR and VARCHAR values: number of characters
+   */
+  vector<std::uint16_t> lengths;
+};
+
+/**
+ * Batch of tuples decoded into one column vector per attribute. Operators
+ * hand whole batches to each other; filters only shrink the selection
+ * vector, the column values are not moved.
+ */
+class RowBatch {
+ public:
+  /**
+   * Max number of rows
+   */
+  static const int CAPACITY = 1024;
+
+  /**
+   * One column per attribute
+   */
+  vector<ColumnVector> columns;
+
+  /**
+   * Number of rows
+   */
+  int numRows;
+
+  /**
+   * Rows that passed the filters so far, in increasing order
+   */
+  vector<std::uint16_t> selection;
+
+  /**
+   * Number of valid entries in selection
+   */
+  int numSelected;
+
+  /**
+   * Constructor
+   */
+  RowBatch() : numRows(0), numSelected(0) {
+    // nothing
+  }
+
+  /**
+   * Set up empty columns for the attributes of a schema, keeping the memory
+   * of earlier batches
+   */
+  void reset(const TableSchema& tableSchema);
+
+  /**
+   * Set the number of rows and size the columns for them
+   */
+  void resize(int numRows);
+
+  /**
+   * Select all rows
+   */
+  void selectAll();
+
+  /**
+   * Append a row as a tuple in the layout of tableSchema
+   */
+  void appendTuple(int row, const TableSchema& tableSchema, string& tuple) const;
+};
+
+/**
+ * Operator of the batch (vectorized) engine. Like Operator, but next
+ * produces a RowBatch of up to RowBatch::CAPACITY tuples per call, which
+ * pays for the virtual call and the schema interpretation once per batch
+ * instead of once per tuple.
+ */
+class BatchOperator {
+ protected:
+  /**
+   * Schema of the output tuples
+   */
+  TableSchema schema;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Number of I/Os carried out by this operator itself
+   */
+  int numIOs;
+
+ public:
+  /**
+   * Constructor
+   */
+  BatchOperator(const TableSchema& schema, BufMgr* bufMgr)
+      : schema(schema), bufMgr(bufMgr), numIOs(0) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  virtual ~BatchOperator() {
+    // nothing
+  }
+
+  /**
+   * Get the operator's name
+   */
+  virtual string getOperatorName() const = 0;
+
+  /**
+   * Get the schema of the output tuples
+   */
+  const TableSchema& getSchema() const { return schema; }
+
+  /**
+   * Prepare to produce batches from the beginning
+   */
+  virtual void open() = 0;
+
+  /**
+   * Produce the next batch
+   * @param batch Set to the batch, valid until the next call to nextBatch()
+   *              or close()
+   * @return False if there are no more tuples
+   */
+  virtual bool nextBatch(RowBatch& batch) = 0;
+
+  /**
+   * Release the resources taken by open()
+   */
+  virtual void close() = 0;
+
+  /**
+   * Get the number of I/Os carried out by this operator and its inputs
+   */
+  virtual int getNumIOs() const { return numIOs; }
+
+  /**
+   * Get the estimated number of pages of the output
+   */
+  virtual int getEstimatedPages() const = 0;
+
+  /**
+   * Run the operator and count its output tuples
+   */
+  long long count();
+};
+
+/**
+ * Sequential scan decoding the tuples of a table file into batches. The
+ * pages referenced by a batch stay pinned until the next batch is produced,
+ * so a batch ends at a page boundary once it spans MAX_BATCH_PAGES pages,
+ * even if it holds fewer than RowBatch::CAPACITY tuples.
+ */
+class BatchScanOperator : public BatchOperator {
+ private:
+  /**
+   * Own handle of the table file, the buffer pool frames are keyed by it
+   */
+  File file;
+
+  /**
+   * System catalog, used for page estimates if not null
+   */
+  const Catalog* catalog;
+
+  /**
+   * Layout of the tuples
+   */
+  TupleLayout layout;
+
+  /**
+   * Current page in the file
+   */
+  FileIterator fileIter;
+
+  /**
+   * Current tuple in the current page
+   */
+  PageIterator pageIter;
+
+  /**
+   * Current page, or null
+   */
+  Page* currentPage;
+
+  /**
+   * Used up pages still referenced by the last batch
+   */
+  vector<PageId> retiredPages;
+
+  /**
+   * Tuples of the batch being decoded
+   */
+  vector<const char*> rows;
+
+  /**
+   * Attribute locations of the batch being decoded, if some attribute
+   * follows a VARCHAR
+   */
+  vector<AttrSlot> slots;
+
+  /**
+   * Unpin the retired pages
+   */
+  void releasePages();
+
+ public:
+  /**
+   * Max number of pages a batch spans, all of them pinned
+   */
+  static const int MAX_BATCH_PAGES = 8;
+
+  /**
+   * Constructor
+   */
+  BatchScanOperator(const File& tableFile,
+                    const TableSchema& tableSchema,
+                    BufMgr* bufMgr,
+                    const Catalog* catalog = nullptr)
+      : BatchOperator(tableSchema, bufMgr),
+        file(tableFile),
+        catalog(catalog),
+        layout(tableSchema),
+        currentPage(nullptr) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  ~BatchScanOperator() { close(); }
+
+  string getOperatorName() const { return "BATCH_SCAN"; }
+
+  void open();
+
+  bool nextBatch(RowBatch& batch);
+
+  void close();
+
+  int getEstimatedPages() const;
+};
+
+/**
+ * Selection comparing an attribute with a constant, one batch at a time
+ */
+class BatchFilterOperator : public BatchOperator {
+ private:
+  /**
+   * Input operator
+   */
+  unique_ptr<BatchOperator> input;
+
+  /**
+   * Compared attribute
+   */
+  int attrNum;
+
+  /**
+   * Comparison
+   */
+  CompareOp op;
+
+  /**
+   * Constant of an INT attribute
+   */
+  std::int32_t intValue;
+
+  /**
+   * Constant of a CHAR or VARCHAR attribute, as stored
+   */
+  string charValue;
+
+  /**
+   * Selection bitmap of a batch, for an INT attribute
+   */
+  vector<std::uint64_t> bitmap;
+
+ public:
+  /**
+   * Constructor. The value is given as in an SQL statement, e.g. 42 or 'abc'.
+   */
+  BatchFilterOperator(unique_ptr<BatchOperator> input,
+                      const string& attrName,
+                      CompareOp op,
+                      const string& value,
+                      BufMgr* bufMgr);
+
+  string getOperatorName() const { return "BATCH_FILTER"; }
+
+  void open() { input->open(); }
+
+  bool nextBatch(RowBatch& batch);
+
+  void close() { input->close(); }
+
+  int getNumIOs() const { return numIOs + input->getNumIOs(); }
+
+  int getEstimatedPages() const { return input->getEstimatedPages(); }
+};
+
+/**
+ * Projection, copying whole column vectors
+ */
+class BatchProjectOperator : public BatchOperator {
+ private:
+  /**
+   * Input operator
+   */
+  unique_ptr<BatchOperator> input;
+
+  /**
+   * Input attribute number of every output attribute
+   */
+  vector<int> attrNums;
+
+  /**
+   * Batch produced by the input
+   */
+  RowBatch inputBatch;
+
+ public:
+  /**
+   * Constructor
+   */
+  BatchProjectOperator(unique_ptr<BatchOperator> input,
+                       const vector<string>& attrNames,
+                       BufMgr* bufMgr);
+
+  string getOperatorName() const { return "BATCH_PROJECT"; }
+
+  void open() { input->open(); }
+
+  bool nextBatch(RowBatch& batch);
+
+  void close() { input->close(); }
+
+  int getNumIOs() const { return numIOs + input->getNumIOs(); }
+
+  int getEstimatedPages() const { return input->getEstimatedPages(); }
+};
+
+/**
+ * In-memory hash join on the common attributes of its inputs. The smaller
+ * input is copied into column arrays and a chained hash table over
+ * fixed-width keys; the other input is probed a batch at a time.
+ */
+class BatchHashJoinOperator : public BatchOperator {
+ private:
+  /**
+   * Build side column: INT values, or characters in an arena
+   */
+  struct BuildColumn {
+    vector<std::int32_t> ints;
+    string arena;
+    vector<std::uint32_t> offsets;
+    vector<std::uint16_t> lengths;
+  };
+
+  /**
+   * Where an output column comes from
+   */
+  struct ColumnSource {
+    bool fromBuild;
+    int column;
+  };
+
+  /**
+   * Inputs
+   */
+  unique_ptr<BatchOperator> leftInput;
+  unique_ptr<BatchOperator> rightInput;
+
+  /**
+   * Is the left input the build side?
+   */
+  bool buildLeft;
+
+  /**
+   * Join attributes of the build and the probe side
+   */
+  vector<int> buildKeyAttrs;
+  vector<int> probeKeyAttrs;
+
+  /**
+   * Width of each join attribute in a key, and of a whole key, in bytes
+   */
+  vector<int> keyAttrWidths;
+  int keyWidth;
+
+  /**
+   * Build side rows
+   */
+  vector<BuildColumn> buildColumns;
+  int numBuildRows;
+  vector<char> buildKeys;
+
+  /**
+   * Hash table: first build row per bucket and next build row per row,
+   * -1 ends a chain. Keys are hashed by KeyHash.
+   */
+  vector<std::int32_t> bucketHeads;
+  vector<std::int32_t> chainNext;
+  std::uint32_t numBuckets;
+
+  /**
+   * Current probe batch, its keys and hashes
+   */
+  RowBatch probeBatch;
+  vector<char> probeKeys;
+  vector<std::uint64_t> probeHashes;
+
+  /**
+   * Position in the probe batch and in the chain of the current probe row
+   */
+  int probePos;
+  std::int32_t chainPos;
+
+  /**
+   * Sources of the output columns
+   */
+  vector<ColumnSource> outputSources;
+
+  /**
+   * Matches gathered into the output batch
+   */
+  vector<std::uint16_t> matchProbeRows;
+  vector<std::int32_t> matchBuildRows;
+
+  /**
+   * Write the keys of the selected rows of a batch
+   */
+  void encodeKeys(const RowBatch& batch,
+                  const vector<int>& keyAttrs,
+                  vector<char>& keys) const;
+
+  /**
+   * Read the build input into memory
+   */
+  void build();
+
+ public:
+  /**
+   * Constructor
+   */
+  BatchHashJoinOperator(unique_ptr<BatchOperator> leftInput,
+                        unique_ptr<BatchOperator> rightInput,
+                        BufMgr* bufMgr);
+
+  string getOperatorName() const { return "BATCH_HASH_JOIN"; }
+
+  void open();
+
+  bool nextBatch(RowBatch& batch);
+
+  void close();
+
+  int getNumIOs() const {
+    return numIOs + leftInput->getNumIOs() + rightInput->getNumIOs();
+  }
+
+  int getEstimatedPages() const {
+    return leftInput->getEstimatedPages() + rightInput->getEstimatedPages();
+  }
+};
+
+/**
+ * Turns the batches of a BatchOperator back into tuples, so that batch plans
+ * can feed row operators, be printed or be materialized
+ */
+class BatchToRowOperator : public Operator {
+ private:
+  /**
+   * Input operator
+   */
+  unique_ptr<BatchOperator> input;
+
+  /**
+   * Current batch
+   */
+  RowBatch batch;
+
+  /**
+   * Next selected row of the batch
+   */
+  int batchPos;
+
+  /**
+   * Current tuple
+   */
+  string tuple;
+
+ public:
+  /**
+   * Constructor
+   */
+  BatchToRowOperator(unique_ptr<BatchOperator> input, BufMgr* bufMgr)
+      : Operator(input->getSchema(), bufMgr),
+        input(std::move(input)),
+        batchPos(0) {
+    // nothing
+  }
+
+  string getOperatorName() const { return "BATCH_TO_ROW"; }
+
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close() { input->close(); }
+
+  int getNumIOs() const { return numIOs + input->getNumIOs(); }
+
+  int getEstimatedPages() const { return input->getEstimatedPages(); }
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,36 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "bloom_filter.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace badgerdb {
+
+void BloomFilter::reset(size_t numBits) {
+  numBlocks = getNumBytesFor(numBits) / (BLOCK_WORDS * sizeof(std::uint64_t));
+  words.assign(numBlocks * BLOCK_WORDS, 0);
+}
+
+size_t BloomFilter::getNumBytesFor(size_t numBits) {
+  const size_t block_bits = BLOCK_WORDS * 64;
+  size_t num_blocks = max<size_t>((numBits + block_bits - 1) / block_bits, 1);
+  return num_blocks * BLOCK_WORDS * sizeof(std::uint64_t);
+}
+
+void BloomFilter::merge(const BloomFilter& other) {
+  for (size_t i = 0; i < words.size() && i < other.words.size(); ++i) {
+    words[i] |= other.words[i];
+  }
+}
+
+void BloomFilter::clear() {
+  words.clear();
+  words.shrink_to_fit();
+  numBlocks = 0;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,124 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Blocked Bloom filter over 64-bit key hashes. A key sets NUM_PROBES bits in
+ * a single cache-line block chosen by its hash, so a lookup touches one
+ * cache line. A key that was inserted is always found; another key is found
+ * with a small probability, about 1% at 10 bits per key.
+ */
+class BloomFilter {
+ private:
+  /**
+   * Blocks of BLOCK_WORDS words
+   */
+  vector<std::uint64_t> words;
+
+  /**
+   * Number of blocks
+   */
+  std::uint64_t numBlocks;
+
+  /**
+   * First word of the block of a hash
+   */
+  size_t blockOf(std::uint64_t hash) const {
+    return (size_t)(((hash >> 32) * numBlocks) >> 32) * BLOCK_WORDS;
+  }
+
+  /**
+   * Bits to set in the block of a hash, NUM_PROBES times 9 bits, remixed so
+   * that they do not depend on the bits that picked the block
+   */
+  static std::uint64_t probeBits(std::uint64_t hash) {
+    hash = (hash ^ (hash >> 31)) * 0xbf58476d1ce4e5b9ULL;
+    return hash ^ (hash >> 29);
+  }
+
+ public:
+  /**
+   * Words of a block, a 64-byte cache line
+   */
+  static const int BLOCK_WORDS = 8;
+
+  /**
+   * Bits set per key
+   */
+  static const int NUM_PROBES = 6;
+
+  /**
+   * Constructor of an empty filter, which contains no key
+   */
+  BloomFilter() : numBlocks(0) {
+    // nothing
+  }
+
+  /**
+   * Clear the filter and size it to about numBits bits, at least a block
+   */
+  void reset(size_t numBits);
+
+  /**
+   * Is the filter sized, i.e. not empty?
+   */
+  bool isEnabled() const { return numBlocks > 0; }
+
+  /**
+   * Get the size in bytes
+   */
+  size_t getNumBytes() const { return words.size() * sizeof(std::uint64_t); }
+
+  /**
+   * Get the size in bytes of a filter reset to numBits bits
+   */
+  static size_t getNumBytesFor(size_t numBits);
+
+  /**
+   * Add a key hash
+   */
+  void insert(std::uint64_t hash) {
+    std::uint64_t* block = &words[blockOf(hash)];
+    std::uint64_t bits = probeBits(hash);
+    for (int i = 0; i < NUM_PROBES; ++i) {
+      std::uint32_t bit = (bits >> (9 * i)) & 511;
+      block[bit >> 6] |= (std::uint64_t)1 << (bit & 63);
+    }
+  }
+
+  /**
+   * May a key hash have been inserted?
+   */
+  bool mayContain(std::uint64_t hash) const {
+    const std::uint64_t* block = &words[blockOf(hash)];
+    std::uint64_t bits = probeBits(hash);
+    for (int i = 0; i < NUM_PROBES; ++i) {
+      std::uint32_t bit = (bits >> (9 * i)) & 511;
+      if ((block[bit >> 6] & ((std::uint64_t)1 << (bit & 63))) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * Add the keys of another filter of the same size
+   */
+  void merge(const BloomFilter& other);
+
+  /**
+   * Release the memory; the filter is disabled
+   */
+  void clear();
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,549 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "btree.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "exceptions/bad_index_info_exception.h"
+#include "file_iterator.h"
+#include "index_page.h"
+#include "page_iterator.h"
+#include "predicate.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Marks the meta page of an index file
+ */
+static const std::uint32_t META_MAGIC = 0x42545245;  // "BTRE"
+
+/**
+ * Bytes of the meta record: magic, attribute type, key width, root, height
+ * and number of entries
+ */
+static const int META_BYTES = 28;
+
+/**
+ * Bytes of a record ID in an entry
+ */
+static const int RID_BYTES = 6;
+
+/**
+ * Node types, in the first byte of a node
+ */
+static const char INNER_NODE = 0;
+static const char LEAF_NODE = 1;
+
+/**
+ * First entry of a leaf not below entry
+ */
+static int lowerBound(const char* node, int width, const char* entry) {
+  const char* entries = node + BTreeIndex::NODE_HEADER_BYTES;
+  int low = 0, high = IndexPage::getCount(node);
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (memcmp(entries + (size_t)mid * width, entry, width) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/**
+ * Child of an inner node whose range holds entry: the number of separators
+ * not above it
+ */
+static int childIndex(const char* node, int width, const char* entry) {
+  const char* separators = node + BTreeIndex::NODE_HEADER_BYTES;
+  const int stride = width + sizeof(PageId);
+  int low = 0, high = IndexPage::getCount(node);
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (memcmp(separators + (size_t)mid * stride, entry, width) <= 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+static PageId childAt(const char* node, int width, int index) {
+  if (index == 0)
+    return IndexPage::getLink(node);
+  return IndexPage::readWord(node + BTreeIndex::NODE_HEADER_BYTES +
+                             (size_t)(index - 1) * (width + sizeof(PageId)) +
+                             width);
+}
+
+BTreeIndex::BTreeIndex(const string& indexFilename,
+                       const TableSchema& tableSchema,
+                       const string& attrName,
+                       BufMgr* bufMgr)
+    : file(File::exists(indexFilename) ? File::open(indexFilename)
+                                       : File::create(indexFilename)),
+      bufMgr(bufMgr),
+      layout(tableSchema),
+      attrNum(tableSchema.getAttrNum(attrName)),
+      attrType(tableSchema.getAttrType(attrNum)),
+      tableSchema(tableSchema),
+      keyWidth(layout.getNormalizedWidth(attrNum)),
+      entryWidth(keyWidth + RID_BYTES),
+      leafCapacity((NODE_BYTES - NODE_HEADER_BYTES) / entryWidth),
+      innerCapacity((NODE_BYTES - NODE_HEADER_BYTES) /
+                    (entryWidth + (int)sizeof(PageId))),
+      metaPageNumber(Page::INVALID_NUMBER),
+      rootPageNumber(Page::INVALID_NUMBER),
+      height(0),
+      numEntries(0),
+      numNodeReads(0) {
+  metaPageNumber = file.begin().page_number();
+  if (metaPageNumber != Page::INVALID_NUMBER) {
+    readMeta();
+    return;
+  }
+  // a new index: the meta page, then an empty root leaf
+  Page* page;
+  bufMgr->allocPage(&file, metaPageNumber, page);
+  page->insertRecord(string(META_BYTES, '\0'));
+  bufMgr->unPinPage(&file, metaPageNumber, true);
+  rootPageNumber = allocateNode(emptyLeaf());
+  writeMeta();
+}
+
+BTreeIndex::~BTreeIndex() {
+  flush();
+}
+
+string BTreeIndex::makeEntry(const string& key, const RecordId& rid) const {
+  string entry = key;
+  entry.resize(keyWidth, '\0');
+  // big-endian, so that memcmp orders equal keys by record ID
+  entry += (char)(rid.page_number >> 24);
+  entry += (char)(rid.page_number >> 16);
+  entry += (char)(rid.page_number >> 8);
+  entry += (char)rid.page_number;
+  entry += (char)(rid.slot_number >> 8);
+  entry += (char)rid.slot_number;
+  return entry;
+}
+
+RecordId BTreeIndex::entryRecordId(const char* entry, int keyWidth) {
+  const unsigned char* bytes = (const unsigned char*)entry + keyWidth;
+  RecordId rid;
+  rid.page_number = ((PageId)bytes[0] << 24) | ((PageId)bytes[1] << 16) |
+                    ((PageId)bytes[2] << 8) | (PageId)bytes[3];
+  rid.slot_number = (SlotId)((bytes[4] << 8) | bytes[5]);
+  return rid;
+}
+
+void BTreeIndex::readNode(PageId pageNumber, string& node) {
+  Page* page;
+  bufMgr->readPage(&file, pageNumber, page);
+  std::uint16_t length;
+  const char* data = page->getRecordData({pageNumber, 1}, length);
+  node.assign(data, length);
+  bufMgr->unPinPage(&file, pageNumber, false);
+  numNodeReads++;
+}
+
+void BTreeIndex::writeNode(PageId pageNumber, const string& node) {
+  Page* page;
+  bufMgr->readPage(&file, pageNumber, page);
+  if ((int)node.size() == NODE_BYTES) {
+    page->updateRecord({pageNumber, 1}, node);
+  } else {
+    string padded = node;
+    padded.resize(NODE_BYTES, '\0');
+    page->updateRecord({pageNumber, 1}, padded);
+  }
+  bufMgr->unPinPage(&file, pageNumber, true);
+}
+
+PageId BTreeIndex::allocateNode(const string& node) {
+  PageId pageNumber;
+  Page* page;
+  bufMgr->allocPage(&file, pageNumber, page);
+  string padded = node;
+  padded.resize(NODE_BYTES, '\0');
+  page->insertRecord(padded);
+  bufMgr->unPinPage(&file, pageNumber, true);
+  return pageNumber;
+}
+
+string BTreeIndex::emptyLeaf() const {
+  string node(NODE_BYTES, '\0');
+  node[0] = LEAF_NODE;
+  IndexPage::setLink(node, Page::INVALID_NUMBER);
+  return node;
+}
+
+void BTreeIndex::writeMeta() {
+  string meta(META_BYTES, '\0');
+  IndexPage::writeWord(&meta[0], META_MAGIC);
+  IndexPage::writeWord(&meta[4], attrType);
+  IndexPage::writeWord(&meta[8], keyWidth);
+  IndexPage::writeWord(&meta[12], rootPageNumber);
+  IndexPage::writeWord(&meta[16], height);
+  memcpy(&meta[20], &numEntries, sizeof(numEntries));
+  Page* page;
+  bufMgr->readPage(&file, metaPageNumber, page);
+  page->updateRecord({metaPageNumber, 1}, meta);
+  bufMgr->unPinPage(&file, metaPageNumber, true);
+}
+
+void BTreeIndex::readMeta() {
+  Page* page;
+  bufMgr->readPage(&file, metaPageNumber, page);
+  std::uint16_t length;
+  const char* meta = page->getRecordData({metaPageNumber, 1}, length);
+  bool is_index =
+      length == META_BYTES && IndexPage::readWord(meta) == META_MAGIC;
+  std::uint32_t type = is_index ? IndexPage::readWord(meta + 4) : 0;
+  std::uint32_t width = is_index ? IndexPage::readWord(meta + 8) : 0;
+  if (is_index) {
+    rootPageNumber = IndexPage::readWord(meta + 12);
+    height = IndexPage::readWord(meta + 16);
+    memcpy(&numEntries, meta + 20, sizeof(numEntries));
+  }
+  bufMgr->unPinPage(&file, metaPageNumber, false);
+  if (!is_index)
+    throw BadIndexInfoException(file.filename(), "not a B+ tree index");
+  if (type != (std::uint32_t)attrType || (int)width != keyWidth)
+    throw BadIndexInfoException(file.filename(),
+                                "indexes another attribute type or width");
+}
+
+PageId BTreeIndex::findLeaf(const string& entry) {
+  PageId pageNumber = rootPageNumber;
+  for (int level = height; level > 0; --level) {
+    Page* page;
+    bufMgr->readPage(&file, pageNumber, page);
+    std::uint16_t length;
+    const char* node = page->getRecordData({pageNumber, 1}, length);
+    PageId child =
+        childAt(node, entryWidth, childIndex(node, entryWidth, entry.data()));
+    bufMgr->unPinPage(&file, pageNumber, false);
+    numNodeReads++;
+    pageNumber = child;
+  }
+  return pageNumber;
+}
+
+bool BTreeIndex::insertInto(PageId pageNumber,
+                            int level,
+                            const string& entry,
+                            string& separator,
+                            PageId& newPageNumber) {
+  string node;
+  readNode(pageNumber, node);
+  int count = IndexPage::getCount(node.data());
+  if (level == 0) {
+    int pos = lowerBound(node.data(), entryWidth, entry.data());
+    node.insert(NODE_HEADER_BYTES + (size_t)pos * entryWidth, entry);
+    count++;
+    if (count <= leafCapacity) {
+      IndexPage::setCount(node, count);
+      node.resize(NODE_BYTES);
+      writeNode(pageNumber, node);
+      return false;
+    }
+    // move the upper half to a new leaf after this one
+    int left_count = count / 2;
+    string right = emptyLeaf();
+    IndexPage::setLink(right, IndexPage::getLink(node.data()));
+    IndexPage::setCount(right, count - left_count);
+    const char* moved = node.data() + NODE_HEADER_BYTES +
+                        (size_t)left_count * entryWidth;
+    right.replace(NODE_HEADER_BYTES, (size_t)(count - left_count) * entryWidth,
+                  moved, (size_t)(count - left_count) * entryWidth);
+    separator.assign(moved, entryWidth);
+    newPageNumber = allocateNode(right);
+    IndexPage::setLink(node, newPageNumber);
+    IndexPage::setCount(node, left_count);
+    node.resize(NODE_BYTES);
+    writeNode(pageNumber, node);
+    return true;
+  }
+
+  int index = childIndex(node.data(), entryWidth, entry.data());
+  PageId child = childAt(node.data(), entryWidth, index);
+  string child_separator;
+  PageId new_child;
+  if (!insertInto(child, level - 1, entry, child_separator, new_child))
+    return false;
+
+  // the new child follows the split one
+  const int stride = entryWidth + sizeof(PageId);
+  string link(sizeof(PageId), '\0');
+  IndexPage::writeWord(&link[0], new_child);
+  node.insert(NODE_HEADER_BYTES + (size_t)index * stride,
+              child_separator + link);
+  count++;
+  if (count <= innerCapacity) {
+    IndexPage::setCount(node, count);
+    node.resize(NODE_BYTES);
+    writeNode(pageNumber, node);
+    return false;
+  }
+  // the middle separator moves up, the ones after it to a new node
+  int mid = count / 2;
+  const char* middle = node.data() + NODE_HEADER_BYTES + (size_t)mid * stride;
+  separator.assign(middle, entryWidth);
+  string right(NODE_BYTES, '\0');
+  right[0] = INNER_NODE;
+  IndexPage::setLink(right, IndexPage::readWord(middle + entryWidth));
+  IndexPage::setCount(right, count - mid - 1);
+  right.replace(NODE_HEADER_BYTES, (size_t)(count - mid - 1) * stride,
+                middle + stride, (size_t)(count - mid - 1) * stride);
+  newPageNumber = allocateNode(right);
+  IndexPage::setCount(node, mid);
+  node.resize(NODE_BYTES);
+  writeNode(pageNumber, node);
+  return true;
+}
+
+string BTreeIndex::getKey(const char* tuple) const {
+  string key;
+  layout.appendNormalized(tuple, layout.locate(tuple, attrNum), attrNum, key);
+  return key;
+}
+
+string BTreeIndex::makeKey(const string& value) const {
+  return Predicate::makeKey(tableSchema, attrNum, value);
+}
+
+void BTreeIndex::insert(const string& key, const RecordId& rid) {
+  string separator;
+  PageId new_page;
+  if (insertInto(rootPageNumber, height, makeEntry(key, rid), separator,
+                 new_page)) {
+    // the root was split, grow a new one above it
+    string root(NODE_BYTES, '\0');
+    root[0] = INNER_NODE;
+    IndexPage::setLink(root, rootPageNumber);
+    IndexPage::setCount(root, 1);
+    root.replace(NODE_HEADER_BYTES, entryWidth, separator);
+    IndexPage::writeWord(&root[NODE_HEADER_BYTES + entryWidth], new_page);
+    rootPageNumber = allocateNode(root);
+    height++;
+    writeMeta();
+  }
+  numEntries++;
+}
+
+bool BTreeIndex::remove(const string& key, const RecordId& rid) {
+  string entry = makeEntry(key, rid);
+  PageId leaf_page = findLeaf(entry);
+  string leaf;
+  readNode(leaf_page, leaf);
+  int count = IndexPage::getCount(leaf.data());
+  int pos = lowerBound(leaf.data(), entryWidth, entry.data());
+  size_t offset = NODE_HEADER_BYTES + (size_t)pos * entryWidth;
+  if (pos == count || memcmp(leaf.data() + offset, entry.data(), entryWidth))
+    return false;
+  leaf.erase(offset, entryWidth);
+  IndexPage::setCount(leaf, count - 1);
+  writeNode(leaf_page, leaf);
+  numEntries--;
+  return true;
+}
+
+bool BTreeIndex::lookup(const string& key, RecordId& rid) {
+  // the first entry of the key, past the leaves emptied by deletes
+  string low = makeEntry(key, RecordId{0, 0});
+  PageId leaf_page = findLeaf(low);
+  while (leaf_page != Page::INVALID_NUMBER) {
+    Page* page;
+    bufMgr->readPage(&file, leaf_page, page);
+    std::uint16_t length;
+    const char* leaf = page->getRecordData({leaf_page, 1}, length);
+    numNodeReads++;
+    int pos = lowerBound(leaf, entryWidth, low.data());
+    if (pos < IndexPage::getCount(leaf)) {
+      const char* entry =
+          leaf + NODE_HEADER_BYTES + (size_t)pos * entryWidth;
+      bool found = memcmp(entry, low.data(), keyWidth) == 0;
+      if (found)
+        rid = entryRecordId(entry, keyWidth);
+      bufMgr->unPinPage(&file, leaf_page, false);
+      return found;
+    }
+    PageId next = IndexPage::getLink(leaf);
+    bufMgr->unPinPage(&file, leaf_page, false);
+    leaf_page = next;
+  }
+  return false;
+}
+
+int BTreeIndex::lookupAll(const string& key, vector<RecordId>& rids) {
+  string low = makeEntry(key, RecordId{0, 0});
+  PageId leaf_page = findLeaf(low);
+  int num_found = 0;
+  while (leaf_page != Page::INVALID_NUMBER) {
+    Page* page;
+    bufMgr->readPage(&file, leaf_page, page);
+    std::uint16_t length;
+    const char* leaf = page->getRecordData({leaf_page, 1}, length);
+    numNodeReads++;
+    int count = IndexPage::getCount(leaf);
+    for (int pos = lowerBound(leaf, entryWidth, low.data()); pos < count;
+         ++pos) {
+      const char* entry =
+          leaf + NODE_HEADER_BYTES + (size_t)pos * entryWidth;
+      if (memcmp(entry, low.data(), keyWidth) != 0) {
+        bufMgr->unPinPage(&file, leaf_page, false);
+        return num_found;
+      }
+      rids.push_back(entryRecordId(entry, keyWidth));
+      num_found++;
+    }
+    // the key may go on in the next leaf
+    PageId next = IndexPage::getLink(leaf);
+    bufMgr->unPinPage(&file, leaf_page, false);
+    leaf_page = next;
+  }
+  return num_found;
+}
+
+BTreeIndex::ScanIterator BTreeIndex::scan(const string& low,
+                                          bool lowInclusive,
+                                          const string& high,
+                                          bool highInclusive) {
+  // record IDs of all zeros or ones sort before or after every real one
+  string low_entry = low;
+  low_entry.resize(keyWidth, '\0');
+  low_entry.append(RID_BYTES, lowInclusive ? '\0' : '\xff');
+  ScanIterator iter;
+  iter.index = this;
+  iter.highEntry = high;
+  iter.highEntry.resize(keyWidth, '\0');
+  iter.highEntry.append(RID_BYTES, highInclusive ? '\xff' : '\0');
+  readNode(findLeaf(low_entry), iter.leaf);
+  iter.position = lowerBound(iter.leaf.data(), entryWidth, low_entry.data());
+  iter.done = false;
+  return iter;
+}
+
+bool BTreeIndex::ScanIterator::next(string& key, RecordId& rid) {
+  while (!done) {
+    if (position < IndexPage::getCount(leaf.data())) {
+      const char* entry = leaf.data() + NODE_HEADER_BYTES +
+                          (size_t)position * index->entryWidth;
+      if (memcmp(entry, highEntry.data(), index->entryWidth) >= 0)
+        break;
+      key.assign(entry, index->keyWidth);
+      rid = entryRecordId(entry, index->keyWidth);
+      position++;
+      return true;
+    }
+    PageId next_leaf = IndexPage::getLink(leaf.data());
+    if (next_leaf == Page::INVALID_NUMBER)
+      break;
+    index->readNode(next_leaf, leaf);
+    position = 0;
+  }
+  done = true;
+  return false;
+}
+
+void BTreeIndex::bulkLoad(const vector<pair<string, RecordId>>& sortedEntries) {
+  if (numEntries > 0 || height > 0)
+    throw BadIndexInfoException(file.filename(),
+                                "bulk loading needs an empty index");
+  if (sortedEntries.empty())
+    return;
+  vector<string> entries;
+  entries.reserve(sortedEntries.size());
+  for (const auto& sorted_entry : sortedEntries) {
+    entries.push_back(makeEntry(sorted_entry.first, sorted_entry.second));
+  }
+  // equal keys must also be ordered by record ID
+  if (!is_sorted(entries.begin(), entries.end()))
+    sort(entries.begin(), entries.end());
+
+  // the leaves, from the empty root on, with the first entry of each
+  const int leaf_fill = max(1, leafCapacity * BULK_LOAD_FILL_PERCENT / 100);
+  vector<pair<string, PageId>> nodes;
+  PageId page_number = rootPageNumber;
+  string leaf = emptyLeaf();
+  int count = 0;
+  for (const string& entry : entries) {
+    if (count == leaf_fill) {
+      PageId next_page = allocateNode(emptyLeaf());
+      IndexPage::setLink(leaf, next_page);
+      IndexPage::setCount(leaf, count);
+      writeNode(page_number, leaf);
+      page_number = next_page;
+      leaf = emptyLeaf();
+      count = 0;
+    }
+    if (count == 0)
+      nodes.push_back(make_pair(entry, page_number));
+    leaf.replace(NODE_HEADER_BYTES + (size_t)count * entryWidth, entryWidth,
+                 entry);
+    count++;
+  }
+  IndexPage::setCount(leaf, count);
+  writeNode(page_number, leaf);
+
+  // then the inner levels, up to a single root
+  const int inner_fill =
+      max(2, innerCapacity * BULK_LOAD_FILL_PERCENT / 100 + 1);
+  const int stride = entryWidth + sizeof(PageId);
+  while (nodes.size() > 1) {
+    vector<pair<string, PageId>> parents;
+    for (size_t first = 0; first < nodes.size(); first += inner_fill) {
+      size_t last = min(nodes.size(), first + inner_fill);
+      string node(NODE_BYTES, '\0');
+      node[0] = INNER_NODE;
+      IndexPage::setLink(node, nodes[first].second);
+      IndexPage::setCount(node, last - first - 1);
+      for (size_t i = first + 1; i < last; ++i) {
+        size_t offset = NODE_HEADER_BYTES + (i - first - 1) * stride;
+        node.replace(offset, entryWidth, nodes[i].first);
+        IndexPage::writeWord(&node[offset + entryWidth], nodes[i].second);
+      }
+      parents.push_back(make_pair(nodes[first].first, allocateNode(node)));
+    }
+    nodes.swap(parents);
+    height++;
+  }
+  rootPageNumber = nodes[0].second;
+  numEntries = entries.size();
+  writeMeta();
+}
+
+void BTreeIndex::loadTable(File& tableFile) {
+  vector<pair<string, RecordId>> entries;
+  for (FileIterator iter = tableFile.begin();
+       iter.page_number() != Page::INVALID_NUMBER; ++iter) {
+    PageId page_number = iter.page_number();
+    Page* page;
+    bufMgr->readPage(&tableFile, page_number, page);
+    PageIterator records(page);
+    for (SlotId slot = records.getNextUsedSlot(Page::INVALID_SLOT);
+         slot != Page::INVALID_SLOT; slot = records.getNextUsedSlot(slot)) {
+      std::uint16_t length;
+      const char* tuple = page->getRecordData({page_number, slot}, length);
+      entries.push_back(
+          make_pair(getKey(tuple), RecordId{page_number, slot}));
+    }
+    bufMgr->unPinPage(&tableFile, page_number, false);
+  }
+  // the frames are keyed by the caller's file handle
+  bufMgr->flushFile(&tableFile);
+  bulkLoad(entries);
+}
+
+void BTreeIndex::flush() {
+  writeMeta();
+  bufMgr->flushFile(&file);
+}
+
+}  // namespace badgerdb
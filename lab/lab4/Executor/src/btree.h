@@ -0,0 +1,346 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "schema.h"
+#include "tuple.h"
+#include "types.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Disk-based B+ tree mapping the values of an INT, CHAR or VARCHAR attribute
+ * of a table to the record IDs of its tuples. The tree lives in a file of its
+ * own, one node per page, read and written through the buffer pool.
+ *
+ * Values are indexed as normalized keys (see TupleLayout). Internally every
+ * entry is the key followed by the record ID in big-endian order, so that
+ * entries are unique and ordered by memcmp even with duplicate keys, and a
+ * deleted entry is found by its path. Deletes do not merge nodes: a node
+ * may become underfull or, for a leaf, empty, which scans skip.
+ */
+class BTreeIndex {
+ private:
+  /**
+   * Index file, the buffer pool frames are keyed by its address
+   */
+  File file;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Layout of the indexed table
+   */
+  TupleLayout layout;
+
+  /**
+   * Number of the indexed attribute
+   */
+  int attrNum;
+
+  /**
+   * Type of the indexed attribute
+   */
+  DataType attrType;
+
+  /**
+   * Schema of the table, to normalize constants of the indexed attribute
+   */
+  TableSchema tableSchema;
+
+  /**
+   * Width of a normalized key
+   */
+  int keyWidth;
+
+  /**
+   * Width of an entry: the key and the record ID
+   */
+  int entryWidth;
+
+  /**
+   * Max number of entries of a leaf and of separators of an inner node
+   */
+  int leafCapacity;
+  int innerCapacity;
+
+  /**
+   * Page holding the meta data of the tree
+   */
+  PageId metaPageNumber;
+
+  /**
+   * Root node
+   */
+  PageId rootPageNumber;
+
+  /**
+   * Number of inner levels, 0 if the root is a leaf
+   */
+  int height;
+
+  /**
+   * Number of entries
+   */
+  std::uint64_t numEntries;
+
+  /**
+   * Number of node pages read
+   */
+  std::uint64_t numNodeReads;
+
+  /**
+   * Make an entry of a key and a record ID
+   */
+  string makeEntry(const string& key, const RecordId& rid) const;
+
+  /**
+   * Get the record ID of an entry
+   */
+  static RecordId entryRecordId(const char* entry, int keyWidth);
+
+  /**
+   * Copy a node into node
+   */
+  void readNode(PageId pageNumber, string& node);
+
+  /**
+   * Overwrite a node
+   */
+  void writeNode(PageId pageNumber, const string& node);
+
+  /**
+   * Allocate a page for a new node and write the node into it
+   */
+  PageId allocateNode(const string& node);
+
+  /**
+   * Create an empty leaf with no next leaf
+   */
+  string emptyLeaf() const;
+
+  /**
+   * Write the meta data into the meta page
+   */
+  void writeMeta();
+
+  /**
+   * Read the meta data from the meta page
+   */
+  void readMeta();
+
+  /**
+   * Descend from the root to the leaf whose range holds an entry
+   */
+  PageId findLeaf(const string& entry);
+
+  /**
+   * Insert an entry into the subtree of a node at the given level, counted
+   * from the leaves
+   * @param separator Receives the first entry of the new right node if the
+   *                  node was split
+   * @param newPageNumber Receives the new right node if the node was split
+   * @return True if the node was split
+   */
+  bool insertInto(PageId pageNumber,
+                  int level,
+                  const string& entry,
+                  string& separator,
+                  PageId& newPageNumber);
+
+ public:
+  /**
+   * Iterator over the entries of a key range, in key order
+   */
+  class ScanIterator {
+   private:
+    /**
+     * Index scanned
+     */
+    BTreeIndex* index;
+
+    /**
+     * Copy of the current leaf
+     */
+    string leaf;
+
+    /**
+     * Next entry in the leaf
+     */
+    int position;
+
+    /**
+     * Entries above this one end the scan
+     */
+    string highEntry;
+
+    /**
+     * Has the scan ended?
+     */
+    bool done;
+
+    friend class BTreeIndex;
+
+   public:
+    /**
+     * Constructor of an ended scan
+     */
+    ScanIterator() : index(nullptr), position(0), done(true) {
+      // nothing
+    }
+
+    /**
+     * Get the next entry in range
+     * @param key Receives the normalized key
+     * @param rid Receives the record ID
+     * @return False if there are no entries left
+     */
+    bool next(string& key, RecordId& rid);
+  };
+
+  /**
+   * Bytes of the node record of a page
+   */
+  static const int NODE_BYTES = Page::DATA_SIZE - sizeof(PageSlot);
+
+  /**
+   * Bytes of a node header: type, number of entries and next leaf or first
+   * child
+   */
+  static const int NODE_HEADER_BYTES = 8;
+
+  /**
+   * Percentage of a node filled by bulk loading, the rest is left for
+   * inserts
+   */
+  static const int BULK_LOAD_FILL_PERCENT = 90;
+
+  /**
+   * Constructor. Opens the index in the file, or creates an empty one.
+   * @throws BadIndexInfoException If the file holds an index on another
+   *                               attribute type or width
+   */
+  BTreeIndex(const string& indexFilename,
+             const TableSchema& tableSchema,
+             const string& attrName,
+             BufMgr* bufMgr);
+
+  /**
+   * Not copyable, the buffer pool frames are keyed by the file's address
+   */
+  BTreeIndex(const BTreeIndex&) = delete;
+  BTreeIndex& operator=(const BTreeIndex&) = delete;
+
+  /**
+   * Destructor. Writes the meta data and flushes the file.
+   */
+  ~BTreeIndex();
+
+  /**
+   * Get the normalized key of the indexed attribute of a tuple
+   */
+  string getKey(const char* tuple) const;
+
+  /**
+   * Get the normalized key of a value in the syntax of INSERT, e.g. 42 or
+   * 'abc'
+   */
+  string makeKey(const string& value) const;
+
+  /**
+   * Get the width of a normalized key
+   */
+  int getKeyWidth() const { return keyWidth; }
+
+  /**
+   * Get the number of the indexed attribute in the table schema
+   */
+  int getAttrNum() const { return attrNum; }
+
+  /**
+   * Get the name of the index file
+   */
+  const string& getFilename() const { return file.filename(); }
+
+  /**
+   * Add an entry
+   */
+  void insert(const string& key, const RecordId& rid);
+
+  /**
+   * Remove an entry
+   * @return False if there is no such entry
+   */
+  bool remove(const string& key, const RecordId& rid);
+
+  /**
+   * Find a tuple with a key
+   * @param rid Receives its record ID
+   * @return False if there is none
+   */
+  bool lookup(const string& key, RecordId& rid);
+
+  /**
+   * Find all tuples with a key
+   * @param rids Receives their record IDs, appended in record ID order
+   * @return Number of tuples found
+   */
+  int lookupAll(const string& key, vector<RecordId>& rids);
+
+  /**
+   * Scan the entries whose keys lie between low and high
+   */
+  ScanIterator scan(const string& low,
+                    bool lowInclusive,
+                    const string& high,
+                    bool highInclusive);
+
+  /**
+   * Build the tree bottom-up from entries sorted by key, filling every node
+   * to BULK_LOAD_FILL_PERCENT. Entries out of order are sorted first.
+   * @throws BadIndexInfoException If the tree is not empty
+   */
+  void bulkLoad(const vector<pair<string, RecordId>>& sortedEntries);
+
+  /**
+   * Bulk load the tuples of a heap file of the indexed table
+   */
+  void loadTable(File& tableFile);
+
+  /**
+   * Write the meta data and the nodes back to the file
+   */
+  void flush();
+
+  /**
+   * Get the number of entries
+   */
+  std::uint64_t getNumEntries() const { return numEntries; }
+
+  /**
+   * Get the number of inner levels, 0 if the root is a leaf
+   */
+  int getHeight() const { return height; }
+
+  /**
+   * Get the number of node pages read
+   */
+  std::uint64_t getNumNodeReads() const { return numNodeReads; }
+};
+
+}  // namespace badgerdb
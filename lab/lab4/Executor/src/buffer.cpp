@@ -110,6 +110,7 @@ void BufMgr::allocBuf(FrameId & frame)
 	
 void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	FrameId pos;
 	bufStats.accesses++;
 
@@ -137,6 +138,7 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
 
 void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) 
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	FrameId pos;
 
 	try{
@@ -158,6 +160,7 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty)
 
 void BufMgr::flushFile(const File* file) 
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	for(FrameId i=0;i<numBufs;++i){
 		if(bufDescTable[i].file==file){
 			if(bufDescTable[i].pinCnt>0){
@@ -178,6 +181,7 @@ void BufMgr::flushFile(const File* file)
 
 void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	Page now=file->allocatePage();
 	PageId nowid=now.page_number();
 
@@ -194,6 +198,7 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page)
 
 void BufMgr::disposePage(File* file, const PageId PageNo)
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	FrameId pos;
 	try{
 		hashTable->lookup(file,PageNo,pos);
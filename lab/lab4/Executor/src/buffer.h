@@ -9,6 +9,7 @@
 #pragma once
 
 #include <iostream>
+#include <mutex>
 
 #include "bufHashTbl.h"
 #include "file.h"
@@ -172,6 +173,12 @@ class BufMgr {
    */
   BufStats bufStats;
 
+  /**
+   * Serializes the calls of threads sharing the buffer pool, and with them
+   * the file accesses made on their behalf
+   */
+  std::mutex mutex;
+
   /**
    * Advance clock to next frame in the buffer pool
    */
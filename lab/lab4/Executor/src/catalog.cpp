@@ -0,0 +1,279 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "catalog.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "exceptions/badgerdb_exception.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Catalog file layout, all integers in native byte order:
+ *
+ *   magic, version, nextTableId, number of tables
+ *   per table:
+ *     id, name, filename, isTemp, number of attributes
+ *     per attribute: name, type, maxSize, isNotNull, isUnique
+ *     length of the statistics block, statistics block
+ *
+ * Strings are stored as their length followed by their characters. The
+ * statistics block is length-prefixed so that fields appended to it later do
+ * not break older readers.
+ */
+static const std::uint32_t CATALOG_MAGIC = 0x43424442;  // "BDBC"
+static const std::uint32_t CATALOG_VERSION = 1;
+
+static void putU8(string& out, std::uint8_t value) {
+  out += (char)value;
+}
+
+static void putU32(string& out, std::uint32_t value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putU64(string& out, std::uint64_t value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putString(string& out, const string& value) {
+  putU32(out, value.size());
+  out += value;
+}
+
+/**
+ * Cursor over the bytes of a catalog file
+ */
+class CatalogReader {
+ private:
+  const char* pos;
+  const char* end;
+
+  void need(size_t size) {
+    if ((size_t)(end - pos) < size)
+      throw BadgerDbException("Corrupted catalog file: unexpected end");
+  }
+
+ public:
+  CatalogReader(const char* begin, const char* end) : pos(begin), end(end) {
+    // nothing
+  }
+
+  std::uint8_t getU8() {
+    need(1);
+    return (std::uint8_t)*pos++;
+  }
+
+  std::uint32_t getU32() {
+    std::uint32_t value;
+    need(sizeof(value));
+    memcpy(&value, pos, sizeof(value));
+    pos += sizeof(value);
+    return value;
+  }
+
+  std::uint64_t getU64() {
+    std::uint64_t value;
+    need(sizeof(value));
+    memcpy(&value, pos, sizeof(value));
+    pos += sizeof(value);
+    return value;
+  }
+
+  string getString() {
+    std::uint32_t size = getU32();
+    need(size);
+    string value(pos, size);
+    pos += size;
+    return value;
+  }
+
+  /**
+   * Split off the next size bytes into their own reader
+   */
+  CatalogReader getBlock(size_t size) {
+    need(size);
+    CatalogReader block(pos, pos + size);
+    pos += size;
+    return block;
+  }
+
+  bool atEnd() const { return pos == end; }
+};
+
+static void putDouble(string& out, double value) {
+  std::uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putU64(out, bits);
+}
+
+static double getDouble(CatalogReader& in) {
+  std::uint64_t bits = in.getU64();
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static void writeTableStats(string& out, const TableStats& stats) {
+  putU32(out, stats.numPages);
+  putU64(out, stats.numTuples);
+  putU64(out, stats.numTupleBytes);
+  putU32(out, stats.attrStats.size());
+  for (const AttrStats& attrStats : stats.attrStats) {
+    putString(out, attrStats.minValue);
+    putString(out, attrStats.maxValue);
+    putDouble(out, attrStats.numDistinct);
+    const vector<std::uint8_t>& registers = attrStats.sketch.getRegisters();
+    putString(out, string(registers.begin(), registers.end()));
+    const vector<string>& bounds = attrStats.histogram.getBounds();
+    putU32(out, bounds.size());
+    for (const string& bound : bounds) {
+      putString(out, bound);
+    }
+  }
+}
+
+static TableStats readTableStats(CatalogReader& in) {
+  TableStats stats;
+  if (in.atEnd())
+    return stats;
+  stats.numPages = in.getU32();
+  stats.numTuples = in.getU64();
+  if (in.atEnd())
+    return stats;  // written before tuple sizes and ANALYZE were recorded
+  stats.numTupleBytes = in.getU64();
+  stats.attrStats.resize(in.getU32());
+  for (AttrStats& attrStats : stats.attrStats) {
+    attrStats.minValue = in.getString();
+    attrStats.maxValue = in.getString();
+    attrStats.numDistinct = getDouble(in);
+    string registers = in.getString();
+    attrStats.sketch.setRegisters(
+        vector<std::uint8_t>(registers.begin(), registers.end()));
+    vector<string> bounds(in.getU32());
+    for (string& bound : bounds) {
+      bound = in.getString();
+    }
+    attrStats.histogram.setBounds(bounds);
+  }
+  return stats;
+}
+
+void Catalog::save() const {
+  string out;
+  putU32(out, CATALOG_MAGIC);
+  putU32(out, CATALOG_VERSION);
+  putU32(out, nextTableId);
+  putU32(out, tableSchemas.size());
+  for (const auto& entry : tableSchemas) {
+    const TableId id = entry.first;
+    const TableSchema& schema = entry.second;
+    putU32(out, id);
+    putString(out, schema.getTableName());
+    putString(out, tableFilenames.at(id));
+    putU8(out, schema.isTempTable());
+    putU32(out, schema.getAttrCount());
+    for (int i = 0; i < schema.getAttrCount(); ++i) {
+      putString(out, schema.getAttrName(i));
+      putU8(out, schema.getAttrType(i));
+      putU32(out, schema.getAttrMaxSize(i));
+      putU8(out, schema.isAttrNotNull(i));
+      putU8(out, schema.isAttrUnique(i));
+    }
+    string stats;
+    writeTableStats(stats, tableStats.at(id));
+    putString(out, stats);
+  }
+
+  // write a new file and move it over the old one, so that a crash in the
+  // middle of saving leaves the previous catalog intact
+  const string filename = getCatalogFilename();
+  const string tmpFilename = filename + ".tmp";
+  {
+    ofstream file(tmpFilename, ios::binary | ios::trunc);
+    file.write(out.data(), out.size());
+    if (!file.flush())
+      throw BadgerDbException("Cannot write catalog file " + tmpFilename);
+  }
+  if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    throw BadgerDbException("Cannot replace catalog file " + filename);
+
+  // a zone map file left by a dropped zone map would be stale when loaded
+  for (const auto& entry : tableFilenames) {
+    const string zoneMapFilename = ZoneMap::getFilename(entry.second);
+    auto it = zoneMaps.find(entry.first);
+    if (it != zoneMaps.end())
+      it->second.save(zoneMapFilename);
+    else
+      std::remove(zoneMapFilename.c_str());
+  }
+}
+
+bool Catalog::load() {
+  ifstream file(getCatalogFilename(), ios::binary | ios::ate);
+  if (!file)
+    return false;
+  string buffer(file.tellg(), '\0');
+  file.seekg(0, ios::beg);
+  file.read(&buffer[0], buffer.size());
+
+  CatalogReader in(buffer.data(), buffer.data() + buffer.size());
+  if (in.getU32() != CATALOG_MAGIC)
+    throw BadgerDbException("Not a catalog file: " + getCatalogFilename());
+  if (in.getU32() > CATALOG_VERSION)
+    throw BadgerDbException("Unsupported catalog version: " +
+                            getCatalogFilename());
+
+  tableIds.clear();
+  tableIdsByFilename.clear();
+  tableSchemas.clear();
+  tableFilenames.clear();
+  tableStats.clear();
+  nextTableId = in.getU32();
+  std::uint32_t numTables = in.getU32();
+  tableIds.reserve(numTables);
+  tableIdsByFilename.reserve(numTables);
+  for (std::uint32_t t = 0; t < numTables; ++t) {
+    TableId id = in.getU32();
+    string tableName = in.getString();
+    string tableFilename = in.getString();
+    bool isTemp = in.getU8();
+    std::uint32_t attrCount = in.getU32();
+    vector<Attribute> attrs;
+    attrs.reserve(attrCount);
+    for (std::uint32_t i = 0; i < attrCount; ++i) {
+      string attrName = in.getString();
+      DataType attrType = (DataType)in.getU8();
+      int maxSize = in.getU32();
+      Attribute attr(attrName, attrType, maxSize);
+      attr.isNotNull = in.getU8();
+      attr.isUnique = in.getU8();
+      attrs.push_back(attr);
+    }
+    CatalogReader stats = in.getBlock(in.getU32());
+
+    tableIds.insert(pair<string, TableId>(tableName, id));
+    tableSchemas.insert(
+        pair<TableId, TableSchema>(id, TableSchema(tableName, attrs, isTemp)));
+    tableFilenames.insert(pair<TableId, string>(id, tableFilename));
+    tableIdsByFilename.insert(pair<string, TableId>(tableFilename, id));
+    tableStats.insert(pair<TableId, TableStats>(id, readTableStats(stats)));
+  }
+
+  zoneMaps.clear();
+  for (const auto& entry : tableFilenames) {
+    ZoneMap zoneMap(tableSchemas.at(entry.first));
+    if (zoneMap.load(ZoneMap::getFilename(entry.second)))
+      zoneMaps.insert(pair<TableId, ZoneMap>(entry.first, zoneMap));
+  }
+  return true;
+}
+
+}  // namespace badgerdb
@@ -8,9 +8,12 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "schema.h"
+#include "statistics.h"
+#include "zone_map.h"
 
 using namespace std;
 
@@ -34,7 +37,12 @@ class Catalog {
   /**
    * Mapping table name to table Id
    */
-  map<string, TableId> tableIds;
+  unordered_map<string, TableId> tableIds;
+
+  /**
+   * Mapping table filename to table Id
+   */
+  unordered_map<string, TableId> tableIdsByFilename;
 
   /**
    * Mapping table Id to table schema
@@ -46,6 +54,16 @@ class Catalog {
    */
   map<TableId, string> tableFilenames;
 
+  /**
+   * Mapping table id to table statistics
+   */
+  map<TableId, TableStats> tableStats;
+
+  /**
+   * Mapping table id to the zone map of the table, if it has one
+   */
+  map<TableId, ZoneMap> zoneMaps;
+
   /**
    * Next available table Id
    */
@@ -55,7 +73,7 @@ class Catalog {
   /**
    * Constructor
    */
-  Catalog(const string& dbName) : dbName(std::move(dbName)), nextTableId(0) {
+  Catalog(const string& dbName) : dbName(dbName), nextTableId(0) {
     // nothing
   }
 
@@ -78,6 +96,25 @@ class Catalog {
     return tableIds.at(tableName);
   }
 
+  /**
+   * Is there a table with the name?
+   */
+  bool hasTable(const string& tableName) const {
+    return tableIds.find(tableName) != tableIds.end();
+  }
+
+  /**
+   * Find the table stored in a file
+   * @return false if no table is stored in the file
+   */
+  bool getTableIdByFilename(const string& tableFilename, TableId& id) const {
+    auto it = tableIdsByFilename.find(tableFilename);
+    if (it == tableIdsByFilename.end())
+      return false;
+    id = it->second;
+    return true;
+  }
+
   /**
    * Get table schema
    */
@@ -85,6 +122,11 @@ class Catalog {
     return tableSchemas.at(id);
   }
 
+  /**
+   * Get number of tables
+   */
+  int getTableCount() const { return tableSchemas.size(); }
+
   /**
    * Get table file
    */
@@ -101,6 +143,8 @@ class Catalog {
         pair<string, TableId>(tableSchema.getTableName(), nextTableId));
     tableSchemas.insert(pair<TableId, TableSchema>(nextTableId, tableSchema));
     tableFilenames.insert(pair<TableId, string>(nextTableId, tableFilename));
+    tableIdsByFilename.insert(pair<string, TableId>(tableFilename, nextTableId));
+    tableStats.insert(pair<TableId, TableStats>(nextTableId, TableStats()));
     return nextTableId++;
   }
 
@@ -109,8 +153,11 @@ class Catalog {
    */
   void deleteTableSchema(const TableId& id) {
     tableIds.erase(getTableSchema(id).getTableName());
+    tableIdsByFilename.erase(getTableFilename(id));
     tableSchemas.erase(id);
     tableFilenames.erase(id);
+    tableStats.erase(id);
+    zoneMaps.erase(id);
   }
 
   /**
@@ -119,6 +166,76 @@ class Catalog {
   void setTableSchema(const TableId& id, const TableSchema& tableSchema) {
     tableSchemas.at(id) = tableSchema;
   }
+
+  /**
+   * Get table statistics
+   */
+  const TableStats& getTableStats(const TableId& id) const {
+    return tableStats.at(id);
+  }
+
+  /**
+   * Get table statistics for updating them in place
+   */
+  TableStats& getTableStats(const TableId& id) { return tableStats.at(id); }
+
+  /**
+   * Update table statistics
+   */
+  void setTableStats(const TableId& id, const TableStats& stats) {
+    tableStats.at(id) = stats;
+  }
+
+  /**
+   * Get the zone map of a table
+   * @return Null if the table has none
+   */
+  const ZoneMap* getZoneMap(const TableId& id) const {
+    auto it = zoneMaps.find(id);
+    return it == zoneMaps.end() ? nullptr : &it->second;
+  }
+
+  /**
+   * Get the zone map of a table for updating it in place
+   * @return Null if the table has none
+   */
+  ZoneMap* getZoneMap(const TableId& id) {
+    auto it = zoneMaps.find(id);
+    return it == zoneMaps.end() ? nullptr : &it->second;
+  }
+
+  /**
+   * Set or replace the zone map of a table
+   */
+  void setZoneMap(const TableId& id, const ZoneMap& zoneMap) {
+    zoneMaps.erase(id);
+    zoneMaps.insert(pair<TableId, ZoneMap>(id, zoneMap));
+  }
+
+  /**
+   * Drop the zone map of a table
+   */
+  void deleteZoneMap(const TableId& id) { zoneMaps.erase(id); }
+
+  /**
+   * Get the name of the file the catalog is persisted in
+   */
+  string getCatalogFilename() const { return dbName + ".cat"; }
+
+  /**
+   * Write the tables, their filenames, schemas and statistics to the catalog
+   * file, and the zone maps next to their table files. Changes to the
+   * catalog are only persisted by calling save().
+   */
+  void save() const;
+
+  /**
+   * Replace the contents of the catalog by the catalog file, which is read
+   * with a single sequential read, and the zone map files
+   * @return false if there is no catalog file yet
+   * @throws BadgerDbException If the catalog file is corrupted
+   */
+  bool load();
 };
 
 }  // namespace badgerdb
\ No newline at end of file
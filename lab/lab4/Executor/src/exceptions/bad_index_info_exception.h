@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when an index file does not hold an
+ *        index on the requested attribute.
+ */
+class BadIndexInfoException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a bad index info exception for the given index file.
+   *
+   * @param name    Name of the index file.
+   * @param reason  What does not match.
+   */
+  BadIndexInfoException(const std::string& name, const std::string& reason);
+
+  /**
+   * Returns the name of the index file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+ protected:
+  /**
+   * Name of the index file that caused this exception.
+   */
+  const std::string filename_;
+};
+
+}
@@ -0,0 +1,20 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "invalid_sql_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+InvalidSQLException::InvalidSQLException(const std::string& statement,
+                                         const std::string& reason)
+    : BadgerDbException(""), statement_(statement) {
+  std::stringstream ss;
+  ss << "Invalid SQL (" << reason << "): " << statement_.substr(0, 80);
+  message_.assign(ss.str());
+}
+
+}
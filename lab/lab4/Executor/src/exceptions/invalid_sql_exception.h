@@ -0,0 +1,39 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when an SQL statement cannot be parsed or
+ *        uses a feature that BadgerDB does not support.
+ */
+class InvalidSQLException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid SQL exception for the given statement.
+   *
+   * @param statement Statement which could not be handled.
+   * @param reason    Why the statement was rejected.
+   */
+  InvalidSQLException(const std::string& statement, const std::string& reason);
+
+  /**
+   * Returns the statement that caused this exception.
+   */
+  virtual const std::string& statement() const { return statement_; }
+
+ protected:
+  /**
+   * Statement that caused this exception.
+   */
+  const std::string statement_;
+};
+
+}
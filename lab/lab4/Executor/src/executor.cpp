@@ -7,14 +7,20 @@
 #include "executor.h"
 
 #include <exceptions/buffer_exceeded_exception.h>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <ctime>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 
+#include "exceptions/bad_index_info_exception.h"
 #include "file_iterator.h"
+#include "key_hash.h"
 #include "page_iterator.h"
 #include "storage.h"
 
@@ -83,18 +89,37 @@ JoinOperator::JoinOperator(File& leftTableFile,
                            const TableSchema& rightTableSchema,
                            const Catalog* catalog,
                            BufMgr* bufMgr)
-    : leftTableFile(leftTableFile),
-      rightTableFile(rightTableFile),
-      leftTableSchema(leftTableSchema),
-      rightTableSchema(rightTableSchema),
-      resultTableSchema(
-          createResultTableSchema(leftTableSchema, rightTableSchema)),
-      catalog(catalog),
-      bufMgr(bufMgr),
-      isComplete(false) {
+    : JoinOperator(unique_ptr<Operator>(new TableScanOperator(
+                       leftTableFile, leftTableSchema, bufMgr, catalog)),
+                   unique_ptr<Operator>(new TableScanOperator(
+                       rightTableFile, rightTableSchema, bufMgr, catalog)),
+                   catalog,
+                   bufMgr) {
   // nothing
 }
 
+JoinOperator::JoinOperator(unique_ptr<Operator> leftInput,
+                           unique_ptr<Operator> rightInput,
+                           const Catalog* catalog,
+                           BufMgr* bufMgr)
+    : Operator(createResultTableSchema(leftInput->getSchema(),
+                                       rightInput->getSchema()),
+               bufMgr),
+      leftInput(std::move(leftInput)),
+      rightInput(std::move(rightInput)),
+      leftTableSchema(this->leftInput->getSchema()),
+      rightTableSchema(this->rightInput->getSchema()),
+      leftLayout(leftTableSchema),
+      rightLayout(rightTableSchema),
+      keyWidth(0),
+      catalog(catalog),
+      numAvailableBufPages(DEFAULT_NUM_BUF_PAGES),
+      isComplete(false),
+      numResultTuples(0),
+      numUsedBufPages(0) {
+  bindAttributes();
+}
+
 TableSchema JoinOperator::createResultTableSchema(
     const TableSchema& leftTableSchema,
     const TableSchema& rightTableSchema) {
@@ -133,329 +158,1744 @@ TableSchema JoinOperator::createResultTableSchema(
 void JoinOperator::printRunningStats() const {
   cout << "# Result Tuples: " << numResultTuples << endl;
   cout << "# Used Buffer Pages: " << numUsedBufPages << endl;
-  cout << "# I/Os: " << numIOs << endl;
+  cout << "# I/Os: " << getNumIOs() << endl;
 }
 
-vector<Attribute> JoinOperator::getCommonAttributes(
-    const TableSchema& leftTableSchema,
-    const TableSchema& rightTableSchema) const {
-  vector<Attribute> common_attrs;
+void JoinOperator::bindAttributes() {
+  // the common attributes have the same name and type, their keys are wide
+  // enough for the longer of the two values
   for (int i = 0; i < rightTableSchema.getAttrCount(); ++i) {
+    bool has_same = false;
     for (int j = 0; j < leftTableSchema.getAttrCount(); ++j) {
       if ((leftTableSchema.getAttrType(j) == rightTableSchema.getAttrType(i)) &&
           (leftTableSchema.getAttrName(j) == rightTableSchema.getAttrName(i))) {
-        Attribute new_attr = Attribute(rightTableSchema.getAttrName(i),
-                                       rightTableSchema.getAttrType(i),
-                                       rightTableSchema.getAttrMaxSize(i),
-                                       rightTableSchema.isAttrNotNull(i),
-                                       rightTableSchema.isAttrUnique(i));
-        common_attrs.push_back(new_attr);
+        int max_len = max(leftTableSchema.getAttrMaxSize(j),
+                          rightTableSchema.getAttrMaxSize(i));
+        int width = 4;
+        if (rightTableSchema.getAttrType(i) == CHAR)
+          width = max_len;
+        else if (rightTableSchema.getAttrType(i) == VARCHAR)
+          width = 1 + max_len;  // the length byte, then the characters
+        leftKeyAttrs.push_back(j);
+        rightKeyAttrs.push_back(i);
+        keyAttrWidths.push_back(width);
+        keyWidth += width;
+        has_same = true;
       }
     }
+    if (!has_same)
+      rightOutputAttrs.push_back(i);
+  }
+  // keys are padded to whole 4-byte words, to be compared a word at a time
+  keyWidth = (keyWidth + 3) / 4 * 4;
+  keyKernels = KeyKernels::forWords(keyWidth / 4);
+  if (leftKeyAttrs.size() == 1 &&
+      leftLayout.getFixedOffset(leftKeyAttrs[0]) >= 0 &&
+      rightLayout.getFixedOffset(rightKeyAttrs[0]) >= 0) {
+    // a single key attribute at a fixed offset, as in most joins
+    DataType type = leftLayout.getAttrType(leftKeyAttrs[0]);
+    leftKeyWriter = KeyWriter::forAttr(
+        type, leftLayout.getFixedOffset(leftKeyAttrs[0]),
+        leftLayout.getNormalizedWidth(leftKeyAttrs[0]), keyAttrWidths[0],
+        keyWidth);
+    rightKeyWriter = KeyWriter::forAttr(
+        type, rightLayout.getFixedOffset(rightKeyAttrs[0]),
+        rightLayout.getNormalizedWidth(rightKeyAttrs[0]), keyAttrWidths[0],
+        keyWidth);
+  }
+
+  // the right attributes in front of the first VARCHAR are copied as runs
+  // of bytes
+  for (int num : rightOutputAttrs) {
+    int offset = rightLayout.getFixedOffset(num);
+    if (offset < 0 || rightLayout.getAttrType(num) == VARCHAR) {
+      rightOutputRuns.clear();
+      break;
+    }
+    int length = 4;
+    if (rightLayout.getAttrType(num) == CHAR) {
+      int max_len = rightTableSchema.getAttrMaxSize(num);
+      length = max_len + (4 - (max_len % 4)) % 4;
+    }
+    if (!rightOutputRuns.empty() &&
+        rightOutputRuns.back().first + rightOutputRuns.back().second == offset)
+      rightOutputRuns.back().second += length;
+    else
+      rightOutputRuns.push_back(make_pair(offset, length));
   }
-  return common_attrs;
 }
 
-/**
- * use the original key to generate the search key
- * @param key
- * @param common_attrs
- * @param TableSchema
- * @return
- */
-string construct_search_key(string key,
-                            vector<Attribute>& common_attrs,
-                            const TableSchema& TableSchema) {
-  string search_key;
-  int current_index = 0;
-  int current_attr_index = 0;
-  for (int i = 0; i < TableSchema.getAttrCount(); ++i) {
-    switch (TableSchema.getAttrType(i)) {
-      case INT: {
-        if (TableSchema.getAttrName(i) ==
-                common_attrs[current_attr_index].attrName &&
-            TableSchema.getAttrType(i) ==
-                common_attrs[current_attr_index].attrType) {
-          search_key += std::string(key, current_index, 4);
-          current_attr_index++;
-        }
-        current_index += 4;
-        break;
-      }
-      case CHAR: {
-        int max_len = TableSchema.getAttrMaxSize(i);
-        if (TableSchema.getAttrName(i) ==
-                common_attrs[current_attr_index].attrName &&
-            TableSchema.getAttrType(i) ==
-                common_attrs[current_attr_index].attrType) {
-          search_key += std::string(key, current_index, max_len);
-          current_attr_index++;
-        }
-        current_index += max_len;
-        current_index += (4 - (max_len % 4)) % 4;
-        ;  // align to the multiple of 4
-        break;
-      }
-      case VARCHAR: {
-        int actual_len = key[current_index];
-        current_index++;
-        if (TableSchema.getAttrName(i) ==
-                common_attrs[current_attr_index].attrName &&
-            TableSchema.getAttrType(i) ==
-                common_attrs[current_attr_index].attrType) {
-          search_key += std::string(key, current_index, actual_len);
-          current_attr_index++;
-        }
-        current_index += actual_len;
-        current_index +=
-            (4 - ((actual_len + 1) % 4)) % 4;  // align to the multiple of 4
-        break;
-      }
+void JoinOperator::writeAnyJoinKey(const char* tuple,
+                                   bool isLeft,
+                                   char* key) const {
+  const TupleLayout& layout = isLeft ? leftLayout : rightLayout;
+  const vector<int>& key_attrs = isLeft ? leftKeyAttrs : rightKeyAttrs;
+  memset(key, 0, keyWidth);
+  for (size_t k = 0; k < key_attrs.size(); ++k) {
+    int num = key_attrs[k];
+    int width = keyAttrWidths[k];
+    AttrSlot slot = layout.locate(tuple, num);
+    int length = min(slot.length, width);
+    if (layout.getAttrType(num) == VARCHAR) {
+      *key++ = (char)slot.length;
+      width--;
+      length = min(length, width);
+    }
+    memcpy(key, tuple + slot.offset, length);
+    key += width;
+  }
+}
+
+void JoinOperator::joinTuples(const char* leftTuple,
+                              int leftSize,
+                              const char* rightTuple,
+                              string& result) const {
+  // all the left attributes, then the ones only owned by the right table
+  result.assign(leftTuple, leftSize);
+  if (!rightOutputRuns.empty() || rightOutputAttrs.empty()) {
+    for (const pair<int, int>& run : rightOutputRuns) {
+      result.append(rightTuple + run.first, run.second);
+    }
+    return;
+  }
+  for (int num : rightOutputAttrs) {
+    rightLayout.appendStored(rightTuple, rightLayout.locate(rightTuple, num),
+                             num, result);
+  }
+}
+
+bool JoinOperator::execute(int numAvailableBufPages, File& resultFile) {
+  if (isComplete)
+    return true;
+
+  setNumAvailableBufPages(numAvailableBufPages);
+  try {
+    materialize(resultFile);
+  } catch (BufferExceededException& e) {
+    close();
+    return false;
+  }
+
+  isComplete = true;
+  return true;
+}
+
+bool OnePassJoinOperator::readBuildInput(Operator& buildInput,
+                                         int capacityPages,
+                                         TupleView& overflow) {
+  const size_t capacity = (size_t)max(capacityPages, 0) * Page::DATA_SIZE;
+  vector<std::uint32_t> key(keyWidth / 4);
+  TupleView tuple;
+  buildData.clear();
+  buildOffsets.clear();
+  buildHashes.clear();
+  buildBytes = 0;
+  hashTable.reset(keyWidth / 4);
+  while (buildInput.next(tuple)) {
+    if (buildBytes + tuple.size + sizeof(PageSlot) > capacity) {
+      overflow = tuple;
+      return false;
+    }
+    buildBytes += tuple.size + sizeof(PageSlot);
+    if (keyWidth > 0)
+      writeJoinKey(tuple.data, buildLeft, (char*)key.data());
+    buildOffsets.push_back(buildData.size());
+    buildData.append(tuple.data, tuple.size);
+    hashTable.insert(key.data());
+    buildHashes.push_back(
+        keyKernels.hash(key.data(), keyWidth / 4));
+  }
+  return true;
+}
+
+void OnePassJoinOperator::buildTable(int capacityPages) {
+  const size_t capacity = (size_t)max(capacityPages, 0) * Page::DATA_SIZE;
+  buildOffsets.push_back(buildData.size());
+  hashTable.build();
+
+  // the Bloom filter takes the memory left, if enough
+  size_t used_bytes = buildBytes;
+  size_t filter_bits = buildHashes.size() * BLOOM_FILTER_BITS_PER_TUPLE;
+  if (keyWidth > 0 &&
+      used_bytes + BloomFilter::getNumBytesFor(filter_bits) <= capacity) {
+    bloomFilter.reset(filter_bits);
+    for (std::uint64_t hash : buildHashes) {
+      bloomFilter.insert(hash);
+    }
+    used_bytes += bloomFilter.getNumBytes();
+  } else {
+    bloomFilter.clear();
+  }
+  buildHashes.clear();
+  numFilteredTuples = 0;
+  numUsedBufPages =
+      max<int>(numUsedBufPages,
+               (used_bytes + Page::DATA_SIZE - 1) / Page::DATA_SIZE + 1);
+  matches.clear();
+  nextMatch = 0;
+}
+
+void OnePassJoinOperator::open() {
+  numResultTuples = 0;
+  numUsedBufPages = 0;
+
+  // the smaller input has to fit in M - 1 pages, next to one page of the
+  // other input
+  buildLeft =
+      leftInput->getEstimatedPages() <= rightInput->getEstimatedPages();
+  Operator& build_input = buildLeft ? *leftInput : *rightInput;
+  TupleView overflow;
+  build_input.open();
+  bool fits = readBuildInput(build_input, numAvailableBufPages - 1, overflow);
+  build_input.close();
+  if (!fits) {
+    close();
+    throw BufferExceededException();
+  }
+  buildTable(numAvailableBufPages - 1);
+  (buildLeft ? rightInput : leftInput)->open();
+}
+
+bool OnePassJoinOperator::probeBatch() {
+  Operator& probe_input = buildLeft ? *rightInput : *leftInput;
+  const int key_words = keyWidth / 4;
+  probeData.clear();
+  probeOffsets.clear();
+  probeKeys.resize((size_t)PROBE_BATCH_SIZE * key_words);
+  probeHashes.clear();
+  TupleView probe;
+  bool has_more = true;
+  while ((int)probeHashes.size() < PROBE_BATCH_SIZE &&
+         (has_more = probe_input.next(probe))) {
+    std::uint32_t* key = probeKeys.data() + probeHashes.size() * key_words;
+    if (keyWidth > 0)
+      writeJoinKey(probe.data, !buildLeft, (char*)key);
+    std::uint64_t hash = keyKernels.hash(key, key_words);
+    if (bloomFilter.isEnabled() && !bloomFilter.mayContain(hash)) {
+      numFilteredTuples++;  // cannot have a match
+      continue;
     }
-    if (current_attr_index >= common_attrs.size())
+    probeOffsets.push_back(probeData.size());
+    probeData.append(probe.data, probe.size);
+    probeHashes.push_back((std::uint32_t)hash);
+  }
+  probeOffsets.push_back(probeData.size());
+  if (probeHashes.empty() && !has_more)
+    return false;
+
+  // overlap the cache misses of the batch: buckets, then entries, then the
+  // lookups
+  for (std::uint32_t hash : probeHashes) {
+    hashTable.prefetchBucket(hash);
+  }
+  for (std::uint32_t hash : probeHashes) {
+    hashTable.prefetchEntries(hash);
+  }
+  matches.clear();
+  nextMatch = 0;
+  switch (key_words) {
+    case 1:  // a single INT or short string
+      findBatchMatches<1>();
+      break;
+    case 2:
+      findBatchMatches<2>();
+      break;
+    case 3:
+      findBatchMatches<3>();
+      break;
+    case 4:
+      findBatchMatches<4>();
+      break;
+    default:
+      findBatchMatches<0>();
       break;
   }
-  return search_key;
+  return true;
 }
 
-string JoinOperator::joinTuples(string leftTuple,
-                                string rightTuple,
-                                const TableSchema& leftTableSchema,
-                                const TableSchema& rightTableSchema) const {
-  int cur_right_index = 0;  // current substring index in the right table key
-  string result_tuple = leftTuple;
+template <int WORDS>
+void OnePassJoinOperator::findBatchMatches() {
+  const int key_words = keyWidth / 4;
+  for (std::uint32_t i = 0; i < probeHashes.size(); ++i) {
+    const std::uint32_t* key = probeKeys.data() + (size_t)i * key_words;
+    const RadixHashTable::Entry* entry;
+    const RadixHashTable::Entry* last;
+    hashTable.bucket(probeHashes[i], entry, last);
+    for (; entry != last; ++entry) {
+      if (entry->hash == probeHashes[i] &&
+          hashTable.keyEquals<WORDS>(entry->row, key))
+        matches.push_back(make_pair(i, entry->row));
+    }
+  }
+}
 
-  for (int i = 0; i < rightTableSchema.getAttrCount(); ++i) {
-    bool has_same = false;
-    for (int j = 0; j < leftTableSchema.getAttrCount(); ++j) {
-      if ((leftTableSchema.getAttrType(j) == rightTableSchema.getAttrType(i)) &&
-          (leftTableSchema.getAttrName(j) == rightTableSchema.getAttrName(i))) {
-        has_same = true;
-      }
+bool OnePassJoinOperator::next(TupleView& tuple) {
+  while (nextMatch == matches.size()) {
+    if (!probeBatch())
+      return false;
+  }
+  std::uint32_t probe = matches[nextMatch].first;
+  std::uint32_t build = matches[nextMatch].second;
+  const char* probe_tuple = probeData.data() + probeOffsets[probe];
+  int probe_size = probeOffsets[probe + 1] - probeOffsets[probe];
+  const char* build_tuple = buildData.data() + buildOffsets[build];
+  int build_size = buildOffsets[build + 1] - buildOffsets[build];
+  if (buildLeft)
+    joinTuples(build_tuple, build_size, probe_tuple, resultTuple);
+  else
+    joinTuples(probe_tuple, probe_size, build_tuple, resultTuple);
+  ++nextMatch;
+  numResultTuples++;
+  tuple = TupleView(resultTuple);
+  return true;
+}
+
+void OnePassJoinOperator::close() {
+  (buildLeft ? rightInput : leftInput)->close();
+  buildData.clear();
+  buildOffsets.clear();
+  buildHashes.clear();
+  hashTable.clear();
+  bloomFilter.clear();
+  probeData.clear();
+  matches.clear();
+  nextMatch = 0;
+}
+
+void NestedLoopJoinOperator::loadBlock() {
+  Operator& outer_input = outerLeft ? *leftInput : *rightInput;
+  const size_t capacity =
+      (size_t)max(numAvailableBufPages - numInnerBufPages, 1) *
+      Page::DATA_SIZE;
+  size_t used_bytes = 0;
+  blockData.clear();
+  blockOffsets.clear();
+  if (hasPendingTuple) {
+    blockOffsets.push_back(0);
+    blockData = pendingTuple;
+    used_bytes += pendingTuple.size() + sizeof(PageSlot);
+    hasPendingTuple = false;
+  }
+  TupleView tuple;
+  while (outer_input.next(tuple)) {
+    used_bytes += tuple.size + sizeof(PageSlot);
+    if (used_bytes > capacity && !blockOffsets.empty()) {
+      // the block is full, this tuple starts the next one
+      pendingTuple = tuple.toString();
+      hasPendingTuple = true;
+      used_bytes -= tuple.size + sizeof(PageSlot);
+      break;
     }
-    // if the key is only owned by right table, add it to the result tuple
-    switch (rightTableSchema.getAttrType(i)) {
-      case INT: {
-        if (!has_same) {
-          result_tuple += std::string(rightTuple, cur_right_index, 4);
-        }
-        cur_right_index += 4;
-        break;
-      }
-      case CHAR: {
-        int max_len = rightTableSchema.getAttrMaxSize(i);
-        if (!has_same) {
-          result_tuple += std::string(rightTuple, cur_right_index, max_len);
-        }
-        cur_right_index += max_len;
-        unsigned align_ = (4 - (max_len % 4)) % 4;  // align to the multiple of
-                                                    // 4
-        for (int k = 0; k < align_; ++k) {
-          result_tuple += "0";
-          cur_right_index++;
-        }
-        break;
+    blockOffsets.push_back(blockData.size());
+    blockData.append(tuple.data, tuple.size);
+  }
+  numBlockTuples = blockOffsets.size();
+  blockOffsets.push_back(blockData.size());
+
+  // decode the join keys once per block
+  const int key_words = keyWidth / 4;
+  blockKeys.resize((size_t)numBlockTuples * key_words);
+  for (int i = 0; i < numBlockTuples && key_words > 0; ++i) {
+    writeJoinKey(blockData.data() + blockOffsets[i], outerLeft,
+                 (char*)&blockKeys[(size_t)i * key_words]);
+  }
+  hashBlock();
+  numUsedBufPages = max<int>(
+      numUsedBufPages,
+      (used_bytes + Page::DATA_SIZE - 1) / Page::DATA_SIZE + numInnerBufPages);
+}
+
+void NestedLoopJoinOperator::hashBlock() {
+  const int key_words = keyWidth / 4;
+  blockBuckets.clear();
+  blockChain.clear();
+  if (key_words == 0)
+    return;  // no common attributes, every pair joins
+  // a power of two buckets, about one outer tuple per bucket
+  std::uint32_t num_buckets = 1;
+  while ((int)num_buckets < numBlockTuples) {
+    num_buckets <<= 1;
+  }
+  blockBucketMask = num_buckets - 1;
+  blockBuckets.assign(num_buckets, numBlockTuples);
+  blockChain.assign(numBlockTuples, numBlockTuples);
+  // insert backwards, so that the chains keep the block order
+  for (int i = numBlockTuples - 1; i >= 0; --i) {
+    std::uint32_t bucket =
+        (std::uint32_t)keyKernels.hash(&blockKeys[(size_t)i * key_words],
+                                       key_words) &
+        blockBucketMask;
+    blockChain[i] = blockBuckets[bucket];
+    blockBuckets[bucket] = i;
+  }
+}
+
+int NestedLoopJoinOperator::firstPosition(const std::uint32_t* key) const {
+  if (blockChain.empty())
+    return 0;  // no common attributes, every pair joins
+  // only the outer tuples in the bucket of the key can match
+  return blockBuckets[(std::uint32_t)keyKernels.hash(key, keyWidth / 4) &
+                      blockBucketMask];
+}
+
+int NestedLoopJoinOperator::findMatch(const std::uint32_t* key,
+                                      int from) const {
+  switch (keyWidth / 4) {
+    case 0:
+      return from;  // no common attributes, every pair joins
+    case 1:  // a single INT or short string
+      return findMatchOf<1>(key, from);
+    case 2:
+      return findMatchOf<2>(key, from);
+    case 3:
+      return findMatchOf<3>(key, from);
+    case 4:
+      return findMatchOf<4>(key, from);
+    default:
+      return findMatchOf<0>(key, from);
+  }
+}
+
+template <int WORDS>
+int NestedLoopJoinOperator::findMatchOf(const std::uint32_t* key,
+                                        int from) const {
+  const int key_words = keyWidth / 4;
+  int i = from;
+  while (i < numBlockTuples &&
+         !KeyWords<WORDS>::equals(&blockKeys[(size_t)i * key_words], key,
+                                  key_words)) {
+    i = blockChain[i];
+  }
+  return i;
+}
+
+void NestedLoopJoinOperator::open() {
+  numResultTuples = 0;
+  numUsedBufPages = 0;
+
+  // I/O: B(S) + B(R)B(S)/(M-1), so the smaller input is the outer one
+  outerLeft =
+      leftInput->getEstimatedPages() <= rightInput->getEstimatedPages();
+  hasPendingTuple = false;
+  hasInnerTuple = false;
+  innerKey.assign(keyWidth / 4, 0);
+  (outerLeft ? leftInput : rightInput)->open();
+  loadBlock();
+  if (numBlockTuples > 0)
+    (outerLeft ? rightInput : leftInput)->open();
+}
+
+bool NestedLoopJoinOperator::next(TupleView& tuple) {
+  Operator& inner_input = outerLeft ? *rightInput : *leftInput;
+  while (numBlockTuples > 0) {
+    // match the current inner tuple with the rest of the block
+    if (hasInnerTuple) {
+      int i = findMatch(innerKey.data(), blockPos);
+      if (i < numBlockTuples) {
+        const char* outer_tuple = blockData.data() + blockOffsets[i];
+        int outer_size = blockOffsets[i + 1] - blockOffsets[i];
+        if (outerLeft)
+          joinTuples(outer_tuple, outer_size, innerTuple.data, resultTuple);
+        else
+          joinTuples(innerTuple.data, innerTuple.size, outer_tuple,
+                     resultTuple);
+        blockPos = nextPosition(i);
+        numResultTuples++;
+        tuple = TupleView(resultTuple);
+        return true;
       }
-      case VARCHAR: {
-        int actual_len = rightTuple[cur_right_index];
-        result_tuple += std::string(rightTuple, cur_right_index, 1);
-        cur_right_index++;
-        if (!has_same) {
-          result_tuple += std::string(rightTuple, cur_right_index, actual_len);
-        }
-        cur_right_index += actual_len;
-        unsigned align_ =
-            (4 - ((actual_len + 1) % 4)) % 4;  // align to the multiple of 4
-        for (int k = 0; k < align_; ++k) {
-          result_tuple += "0";
-          cur_right_index++;
+    }
+    // the inner tuple stays valid until the next call on the inner input
+    if (inner_input.next(innerTuple)) {
+      if (keyWidth > 0)
+        writeJoinKey(innerTuple.data, !outerLeft, (char*)&innerKey[0]);
+      hasInnerTuple = true;
+      blockPos = firstPosition(innerKey.data());
+      continue;
+    }
+    // the inner input is used up, rescan it for the next block
+    inner_input.close();
+    hasInnerTuple = false;
+    loadBlock();
+    if (numBlockTuples > 0)
+      inner_input.open();
+  }
+  return false;
+}
+
+void NestedLoopJoinOperator::close() {
+  leftInput->close();
+  rightInput->close();
+  blockData.clear();
+  blockOffsets.clear();
+  blockKeys.clear();
+  blockBuckets.clear();
+  blockChain.clear();
+  numBlockTuples = 0;
+  hasPendingTuple = false;
+  hasInnerTuple = false;
+}
+
+void WorkerPool::runThread(int worker) {
+  std::uint64_t last_round = 0;
+  while (true) {
+    {
+      unique_lock<mutex> guard(lock);
+      roundStarted.wait(guard,
+                        [&]() { return stopping || round != last_round; });
+      if (stopping)
+        return;
+      last_round = round;
+    }
+    job(worker);
+    lock_guard<mutex> guard(lock);
+    if (--numBusyThreads == 0)
+      roundDone.notify_one();
+  }
+}
+
+void WorkerPool::start(int numWorkers, function<void(int)> job) {
+  stop();
+  this->job = std::move(job);
+  stopping = false;
+  round = 0;
+  for (int w = 1; w < numWorkers; ++w) {
+    threads.push_back(thread(&WorkerPool::runThread, this, w));
+  }
+}
+
+void WorkerPool::run() {
+  {
+    lock_guard<mutex> guard(lock);
+    numBusyThreads = threads.size();
+    round++;
+  }
+  roundStarted.notify_all();
+  job(0);
+  unique_lock<mutex> guard(lock);
+  roundDone.wait(guard, [&]() { return numBusyThreads == 0; });
+}
+
+void WorkerPool::stop() {
+  {
+    lock_guard<mutex> guard(lock);
+    stopping = true;
+  }
+  roundStarted.notify_all();
+  for (thread& t : threads) {
+    t.join();
+  }
+  threads.clear();
+}
+
+ParallelNestedLoopJoinOperator::ParallelNestedLoopJoinOperator(
+    File& leftTableFile,
+    File& rightTableFile,
+    const TableSchema& leftTableSchema,
+    const TableSchema& rightTableSchema,
+    const Catalog* catalog,
+    BufMgr* bufMgr,
+    int numWorkers)
+    : NestedLoopJoinOperator(leftTableFile,
+                             rightTableFile,
+                             leftTableSchema,
+                             rightTableSchema,
+                             catalog,
+                             bufMgr),
+      leftFile(leftTableFile),
+      rightFile(rightTableFile),
+      numWorkers(numWorkers > 0 ? numWorkers
+                                : max<int>(thread::hardware_concurrency(), 1)),
+      numActiveWorkers(0),
+      nextInnerPage(0),
+      roundPage(0),
+      roundEndPage(0),
+      resultFiles(bufMgr),
+      resultFile(0) {
+  // nothing
+}
+
+void ParallelNestedLoopJoinOperator::probePages(int worker) {
+  WorkerOutput& output = outputs[worker];
+  File* inner_file = outerLeft ? &rightFile : &leftFile;
+  vector<std::uint32_t> key(max(keyWidth / 4, 1));
+  string result;
+  try {
+    for (size_t p = roundPage++; p < roundEndPage; p = roundPage++) {
+      Page* page;
+      bufMgr->readPage(inner_file, innerPages[p], page);
+      output.numIOs++;
+      try {
+        for (PageIterator iter = page->begin(); iter != page->end();
+             ++iter) {
+          std::uint16_t length;
+          const char* inner_tuple = iter.data(length);
+          if (keyWidth > 0)
+            writeJoinKey(inner_tuple, !outerLeft, (char*)key.data());
+          for (int i = findMatch(key.data(), firstPosition(key.data()));
+               i < numBlockTuples;
+               i = findMatch(key.data(), nextPosition(i))) {
+            const char* outer_tuple = blockData.data() + blockOffsets[i];
+            int outer_size = blockOffsets[i + 1] - blockOffsets[i];
+            if (outerLeft)
+              joinTuples(outer_tuple, outer_size, inner_tuple, result);
+            else
+              joinTuples(inner_tuple, length, outer_tuple, result);
+            resultFiles.append(worker, result);
+          }
         }
-        break;
+      } catch (...) {
+        bufMgr->unPinPage(inner_file, innerPages[p], false);
+        throw;
       }
+      bufMgr->unPinPage(inner_file, innerPages[p], false);
     }
+  } catch (...) {
+    output.error = current_exception();
   }
-  return result_tuple;
 }
 
-bool OnePassJoinOperator::execute(int numAvailableBufPages, File& resultFile) {
-  if (isComplete)
-    return true;
+void ParallelNestedLoopJoinOperator::runRound() {
+  roundEndPage =
+      min(innerPages.size(),
+          nextInnerPage + (size_t)numActiveWorkers * PAGES_PER_ROUND);
+  roundPage = nextInnerPage;
+  resultFiles.create(getPartitionPrefix("PNLJ"), numActiveWorkers);
+  resultFile = 0;
+  for (WorkerOutput& output : outputs) {
+    output.numIOs = 0;
+    output.error = nullptr;
+  }
+  workers.run();
+  nextInnerPage = roundEndPage;
 
+  resultFiles.close();
+  for (int w = 0; w < numActiveWorkers; ++w) {
+    numIOs += outputs[w].numIOs + resultFiles.getNumPages(w);
+  }
+  for (const WorkerOutput& output : outputs) {
+    if (output.error != nullptr)
+      rethrow_exception(output.error);
+  }
+}
+
+void ParallelNestedLoopJoinOperator::open() {
+  close();
   numResultTuples = 0;
   numUsedBufPages = 0;
-  numIOs = 0;
 
-  // TODO: Execute the join algorithm
+  // I/O: B(S) + B(R)B(S)/(M-2W), so the smaller input is the outer one
+  outerLeft =
+      leftInput->getEstimatedPages() <= rightInput->getEstimatedPages();
+  // a worker pins an inner page and the tail page of its result file, and
+  // the block keeps at least one page
+  if (numAvailableBufPages < 3)
+    throw BufferExceededException();
+  numActiveWorkers =
+      max(1, min(numWorkers, (numAvailableBufPages - 1) / 2));
+  numInnerBufPages = 2 * numActiveWorkers;
+  innerPages.clear();
+  File& inner_file = outerLeft ? rightFile : leftFile;
+  for (FileIterator iter = inner_file.begin(); iter != inner_file.end();
+       ++iter) {
+    innerPages.push_back(iter.page_number());
+  }
+  outputs.assign(numActiveWorkers, WorkerOutput());
+  workers.start(numActiveWorkers, [this](int w) { probePages(w); });
+  hasPendingTuple = false;
+  (outerLeft ? leftInput : rightInput)->open();
+  loadBlock();
+  nextInnerPage = 0;
+}
 
-  isComplete = true;
+bool ParallelNestedLoopJoinOperator::next(TupleView& tuple) {
+  while (true) {
+    // hand out the results of the last round
+    if (resultScan != nullptr) {
+      if (resultScan->next(tuple)) {
+        numResultTuples++;
+        return true;
+      }
+      resultScan->close();
+      numIOs += resultScan->getNumIOs();
+      resultScan.reset();
+      File::remove(resultFiles.getFilename(resultFile++));
+    }
+    if (resultFile < resultFiles.getNumFiles()) {
+      if (resultFiles.getNumPages(resultFile) == 0) {
+        File::remove(resultFiles.getFilename(resultFile++));
+        continue;
+      }
+      resultScan.reset(new TableScanOperator(
+          File::open(resultFiles.getFilename(resultFile)), schema, bufMgr));
+      resultScan->open();
+      continue;
+    }
+    if (numBlockTuples == 0)
+      return false;
+    if (nextInnerPage >= innerPages.size()) {
+      // the inner input is used up, rescan it for the next block
+      loadBlock();
+      nextInnerPage = 0;
+      continue;
+    }
+    runRound();
+  }
+}
+
+void ParallelNestedLoopJoinOperator::close() {
+  workers.stop();
+  NestedLoopJoinOperator::close();
+  outputs.clear();
+  numActiveWorkers = 0;
+  // the result files of an unfinished run; the scan references one
+  resultScan.reset();
+  resultFiles.remove();
+  resultFile = 0;
+  // the inner frames are keyed by this operator's file handles
+  bufMgr->flushFile(&leftFile);
+  bufMgr->flushFile(&rightFile);
+}
+
+IndexNestedLoopJoinOperator::IndexNestedLoopJoinOperator(
+    File& leftTableFile,
+    File& rightTableFile,
+    const TableSchema& leftTableSchema,
+    const TableSchema& rightTableSchema,
+    BTreeIndex& rightIndex,
+    const Catalog* catalog,
+    BufMgr* bufMgr)
+    : IndexNestedLoopJoinOperator(
+          unique_ptr<Operator>(new TableScanOperator(
+              leftTableFile, leftTableSchema, bufMgr, catalog)),
+          rightTableFile,
+          rightTableSchema,
+          rightIndex,
+          catalog,
+          bufMgr) {
+  // nothing
+}
+
+IndexNestedLoopJoinOperator::IndexNestedLoopJoinOperator(
+    unique_ptr<Operator> leftInput,
+    File& rightTableFile,
+    const TableSchema& rightTableSchema,
+    BTreeIndex& rightIndex,
+    const Catalog* catalog,
+    BufMgr* bufMgr)
+    : JoinOperator(std::move(leftInput),
+                   unique_ptr<Operator>(new TableScanOperator(
+                       rightTableFile, rightTableSchema, bufMgr, catalog)),
+                   catalog,
+                   bufMgr),
+      innerFile(rightTableFile),
+      innerIndex(rightIndex),
+      indexKeyAttr(-1),
+      hasPendingTuple(false),
+      nextMatch(0),
+      pinnedPage(nullptr),
+      numProbes(0) {
+  bindIndex();
+}
+
+void IndexNestedLoopJoinOperator::bindIndex() {
+  for (size_t k = 0; k < rightKeyAttrs.size(); ++k) {
+    if (rightKeyAttrs[k] == innerIndex.getAttrNum())
+      indexKeyAttr = k;
+  }
+  if (indexKeyAttr < 0)
+    throw BadIndexInfoException(innerIndex.getFilename(),
+                                "not on a join attribute");
+  innerKey.resize(keyWidth);
+}
+
+void IndexNestedLoopJoinOperator::releasePage() {
+  if (pinnedPage != nullptr) {
+    bufMgr->unPinPage(&innerFile, pinnedPage->page_number(), false);
+    pinnedPage = nullptr;
+  }
+}
+
+bool IndexNestedLoopJoinOperator::probeBlock() {
+  releasePage();
+  matches.clear();
+  nextMatch = 0;
+
+  // the block gets all pages but one for the index and one for the right
+  // table
+  const size_t capacity =
+      (size_t)(numAvailableBufPages - 2) * Page::DATA_SIZE;
+  size_t used_bytes = 0;
+  blockData.clear();
+  blockOffsets.clear();
+  if (hasPendingTuple) {
+    blockOffsets.push_back(0);
+    blockData = pendingTuple;
+    used_bytes += pendingTuple.size() + sizeof(PageSlot);
+    hasPendingTuple = false;
+  }
+  TupleView tuple;
+  while (leftInput->next(tuple)) {
+    used_bytes += tuple.size + sizeof(PageSlot);
+    if (used_bytes > capacity && !blockOffsets.empty()) {
+      // the block is full, this tuple starts the next one
+      pendingTuple = tuple.toString();
+      hasPendingTuple = true;
+      used_bytes -= tuple.size + sizeof(PageSlot);
+      break;
+    }
+    blockOffsets.push_back(blockData.size());
+    blockData.append(tuple.data, tuple.size);
+  }
+  int num_block_tuples = blockOffsets.size();
+  blockOffsets.push_back(blockData.size());
+  if (num_block_tuples == 0)
+    return false;
+  numUsedBufPages =
+      max<int>(numUsedBufPages,
+               (used_bytes + Page::DATA_SIZE - 1) / Page::DATA_SIZE + 2);
+
+  // probe the index with the left value of its attribute, fitted to the
+  // width of the right one
+  const int left_num = leftKeyAttrs[indexKeyAttr];
+  const int index_width = innerIndex.getKeyWidth();
+  std::uint64_t node_reads = innerIndex.getNumNodeReads();
+  blockKeys.resize((size_t)num_block_tuples * keyWidth);
+  vector<RecordId> rids;
+  string index_key;
+  for (int i = 0; i < num_block_tuples; ++i) {
+    const char* left_tuple = blockData.data() + blockOffsets[i];
+    writeJoinKey(left_tuple, true, &blockKeys[(size_t)i * keyWidth]);
+    index_key.clear();
+    leftLayout.appendNormalized(left_tuple,
+                                leftLayout.locate(left_tuple, left_num),
+                                left_num, index_key);
+    if ((int)index_key.size() > index_width &&
+        index_key.find_first_not_of('\0', index_width) != string::npos)
+      continue;  // longer than any right value
+    index_key.resize(index_width, '\0');
+    rids.clear();
+    innerIndex.lookupAll(index_key, rids);
+    numProbes++;
+    for (const RecordId& rid : rids) {
+      matches.push_back({rid, i});
+    }
+  }
+  numIOs += innerIndex.getNumNodeReads() - node_reads;
+
+  // fetch every right page once
+  sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+    if (a.rid.page_number != b.rid.page_number)
+      return a.rid.page_number < b.rid.page_number;
+    if (a.rid.slot_number != b.rid.slot_number)
+      return a.rid.slot_number < b.rid.slot_number;
+    return a.outer < b.outer;
+  });
   return true;
 }
 
-int getTableSize(const File &tableFile){
-  int ret=0;
-  File f = tableFile;
-  for(FileIterator it=f.begin();it!=f.end();++it)
-    ret++;
-  return ret;
+void IndexNestedLoopJoinOperator::open() {
+  close();
+  numResultTuples = 0;
+  numUsedBufPages = 0;
+  numProbes = 0;
+  if (numAvailableBufPages < 3)
+    throw BufferExceededException();
+  leftInput->open();
 }
 
-void splitTuple(const TableSchema &tableSchema, const string &raw, vector<string> &ret){
-  ret.clear();
-  for(int i=0,pos=0;i<tableSchema.getAttrCount();++i)
-  {
-    switch(tableSchema.getAttrType(i))
-    {
-      case INT:{
-        ret.push_back(string(raw,pos,4));
-        pos+=4;
-        break;
-      }
-      case CHAR:{
-        int len=tableSchema.getAttrMaxSize(i);
-        int oldpos=pos;
-        pos+=(4-(len%4))%4+len;
-        ret.push_back(string(raw,oldpos,pos-oldpos));
-        break;
-      }
-      case VARCHAR:{
-        int len=raw[pos];
-        int oldpos=pos;
-        pos+=(4-((len+1)%4))%4+len;
-        ret.push_back(string(raw,oldpos,pos-oldpos));
-        break;
+bool IndexNestedLoopJoinOperator::next(TupleView& tuple) {
+  while (true) {
+    while (nextMatch < matches.size()) {
+      const Match& match = matches[nextMatch++];
+      if (pinnedPage == nullptr ||
+          pinnedPage->page_number() != match.rid.page_number) {
+        releasePage();
+        bufMgr->readPage(&innerFile, match.rid.page_number, pinnedPage);
+        numIOs++;
       }
+      std::uint16_t length;
+      const char* right_tuple =
+          pinnedPage->getRecordData(match.rid, length);
+      // the index attribute matches, the other join attributes may not
+      writeJoinKey(right_tuple, false, &innerKey[0]);
+      const char* left_key = blockKeys.data() + (size_t)match.outer * keyWidth;
+      if (memcmp(innerKey.data(), left_key, keyWidth) != 0)
+        continue;
+      const char* left_tuple = blockData.data() + blockOffsets[match.outer];
+      joinTuples(left_tuple,
+                 blockOffsets[match.outer + 1] - blockOffsets[match.outer],
+                 right_tuple, resultTuple);
+      numResultTuples++;
+      tuple = TupleView(resultTuple);
+      return true;
     }
+    if (!probeBlock())
+      return false;
   }
 }
 
-bool NestedLoopJoinOperator::execute(int numAvailableBufPages,
-                                     File& resultFile) {
-  if (isComplete)
+void IndexNestedLoopJoinOperator::close() {
+  releasePage();
+  leftInput->close();
+  // the frames are keyed by this operator's file handle
+  bufMgr->flushFile(&innerFile);
+  blockData.clear();
+  blockOffsets.clear();
+  hasPendingTuple = false;
+  matches.clear();
+  nextMatch = 0;
+}
+
+bool GraceHashJoinOperator::partition(Operator& input,
+                                      bool isLeft,
+                                      int level,
+                                      PartitionFiles& buckets,
+                                      BloomFilter* insertInto,
+                                      const BloomFilter* filterBy) {
+  // the heavy hitters get a bucket of their own, after the others, in place
+  // of one if there is no page to spare
+  bool route_heavy_hitters = !heavyHitters.empty() && level > 0 &&
+                             numAvailableBufPages >= 4;
+  int fan_out = route_heavy_hitters
+                    ? min(numBuckets, numAvailableBufPages - 2)
+                    : numBuckets;
+  int num_files = fan_out + (route_heavy_hitters ? 1 : 0);
+
+  // one output page per bucket and one input page
+  buckets.create(getPartitionPrefix("GHJ"), num_files);
+  SpaceSavingSketch sketch;
+  vector<std::uint32_t> key(keyWidth / 4);
+  const std::uint64_t seed = KeyHash::seedOf(level);
+  TupleView view;
+  input.open();
+  while (input.next(view)) {
+    if (keyWidth > 0)
+      writeJoinKey(view.data, isLeft, (char*)key.data());
+    std::uint64_t key_hash = keyKernels.hash(key.data(), keyWidth / 4);
+    if (filterBy != nullptr && !filterBy->mayContain(key_hash)) {
+      numFilteredTuples++;  // cannot have a match
+      continue;
+    }
+    if (insertInto != nullptr)
+      insertInto->insert(key_hash);
+    sketch.add(key_hash, view.size + sizeof(PageSlot));
+    BucketId bucket;
+    if (route_heavy_hitters && heavyHitters.count(key_hash) > 0) {
+      bucket = fan_out;
+      numHeavyHitterTuples++;
+    } else {
+      bucket = KeyHash::toBucket(KeyHash::hash(key.data(), keyWidth, seed),
+                                 fan_out);
+    }
+    buckets.append(bucket, view.toString());
+  }
+  input.close();
+  buckets.close();
+  for (int i = 0; i < num_files; ++i) {
+    numIOs += buckets.getNumPages(i);
+  }
+  numUsedBufPages = max(numUsedBufPages, num_files + 1);
+
+  vector<std::uint64_t> found = sketch.getHeavyHitters(
+      (std::uint64_t)(numAvailableBufPages - 1) * Page::DATA_SIZE /
+      HEAVY_HITTER_SHARE);
+  newHeavyHitters.insert(newHeavyHitters.end(), found.begin(), found.end());
+  return route_heavy_hitters;
+}
+
+void GraceHashJoinOperator::partitionPair(Operator& leftInput,
+                                          Operator& rightInput,
+                                          int level,
+                                          int pairPages) {
+  PartitionFiles left_buckets(bufMgr), right_buckets(bufMgr);
+  bool heavy_hitter_bucket = false;
+  if (level == 0 && bloomFilter.isEnabled()) {
+    // the smaller input fills the filter, the other one is filtered
+    if (leftInput.getEstimatedPages() <= rightInput.getEstimatedPages()) {
+      partition(leftInput, true, level, left_buckets, &bloomFilter, nullptr);
+      partition(rightInput, false, level, right_buckets, nullptr,
+                &bloomFilter);
+    } else {
+      partition(rightInput, false, level, right_buckets, &bloomFilter,
+                nullptr);
+      partition(leftInput, true, level, left_buckets, nullptr, &bloomFilter);
+    }
+  } else {
+    // both inputs agree on routing the heavy hitters, which are only added
+    // after this pair
+    heavy_hitter_bucket = partition(leftInput, true, level, left_buckets);
+    partition(rightInput, false, level, right_buckets);
+  }
+  heavyHitters.insert(newHeavyHitters.begin(), newHeavyHitters.end());
+  newHeavyHitters.clear();
+  for (int i = 0; i < left_buckets.getNumFiles(); ++i) {
+    int left_pages = left_buckets.getNumPages(i);
+    int right_pages = right_buckets.getNumPages(i);
+    if (left_pages > 0 && right_pages > 0) {
+      // a bucket of heavy hitters, or one that did not shrink, cannot be
+      // split by hashing; it is joined by a nested-loop join if too large
+      int pair_level = level + 1;
+      if ((heavy_hitter_bucket && i + 1 == left_buckets.getNumFiles()) ||
+          (pairPages > 0 && min(left_pages, right_pages) >= pairPages))
+        pair_level = MAX_PARTITION_LEVELS;
+      pendingPairs.push_back({left_buckets.getFilename(i),
+                              right_buckets.getFilename(i), left_pages,
+                              right_pages, pair_level});
+    } else {
+      // nothing can join with this bucket
+      File::remove(left_buckets.getFilename(i));
+      File::remove(right_buckets.getFilename(i));
+    }
+  }
+}
+
+bool GraceHashJoinOperator::startNextPair() {
+  while (!pendingPairs.empty()) {
+    BucketPair pair = pendingPairs.back();
+    pendingPairs.pop_back();
+    unique_ptr<Operator> left_scan(new TableScanOperator(
+        File::open(pair.leftFilename), leftTableSchema, bufMgr));
+    unique_ptr<Operator> right_scan(new TableScanOperator(
+        File::open(pair.rightFilename), rightTableSchema, bufMgr));
+
+    if (min(pair.leftPages, pair.rightPages) > numAvailableBufPages - 1 &&
+        pair.level < MAX_PARTITION_LEVELS) {
+      // neither bucket fits in memory, split them again
+      partitionPair(*left_scan, *right_scan, pair.level,
+                    min(pair.leftPages, pair.rightPages));
+      numIOs += left_scan->getNumIOs() + right_scan->getNumIOs();
+      left_scan.reset();
+      right_scan.reset();
+      File::remove(pair.leftFilename);
+      File::remove(pair.rightFilename);
+      continue;
+    }
+
+    currentPair = pair;
+    if (min(pair.leftPages, pair.rightPages) <= numAvailableBufPages - 1) {
+      currentJoin.reset(new OnePassJoinOperator(
+          std::move(left_scan), std::move(right_scan), catalog, bufMgr));
+    } else {
+      // hashing does not split them any further (e.g. a single key value)
+      currentJoin.reset(new NestedLoopJoinOperator(
+          std::move(left_scan), std::move(right_scan), catalog, bufMgr));
+    }
+    currentJoin->setNumAvailableBufPages(numAvailableBufPages);
+    currentJoin->open();
+    numUsedBufPages =
+        max(numUsedBufPages, currentJoin->getNumUsedBufPages());
     return true;
+  }
+  return false;
+}
 
+void GraceHashJoinOperator::finishPair() {
+  currentJoin->close();
+  numIOs += currentJoin->getNumIOs();
+  currentJoin.reset();
+  File::remove(currentPair.leftFilename);
+  File::remove(currentPair.rightFilename);
+}
+
+void GraceHashJoinOperator::open() {
+  close();
   numResultTuples = 0;
   numUsedBufPages = 0;
-  numIOs = 0;
-
-  File sfile=leftTableFile;
-  TableSchema sschema=leftTableSchema;
-  File rfile=rightTableFile;
-  TableSchema rschema=rightTableSchema;
-  //I/O: B(S) + B(R)B(S)/(M-1)
-  //let the smaller one to be 'S'
-  if(getTableSize(leftTableFile)>getTableSize(rightTableFile))
-  {
-    sfile=rightTableFile;
-    sschema=rightTableSchema;
-    rfile=leftTableFile;
-    rschema=leftTableSchema;
-  }
-  
-  int frameAmt=numAvailableBufPages-1;
-  int frameUsed=0;
-  
-  Page* frames[frameAmt];
-  Page* rframe;
-
-  FileIterator s_it=sfile.begin();
-  while(s_it!=sfile.end())
+
+  // one input page and one output page per bucket. No more buckets are
+  // used than needed for a bucket of the smaller input to fit in memory
+  // with a page to spare, since every bucket ends in a partly filled page.
+  if (numAvailableBufPages < 3)
+    throw BufferExceededException();
+  int left_pages = leftInput->getEstimatedPages();
+  int right_pages = rightInput->getEstimatedPages();
+  int needed_buckets = (min(left_pages, right_pages) + numAvailableBufPages -
+                        3) / (numAvailableBufPages - 2);
+  numBuckets = max(2, min(numAvailableBufPages - 1, needed_buckets));
+
+  // the pages left over hold a Bloom filter on the keys of the smaller input
+  numFilteredTuples = 0;
+  numHeavyHitterTuples = 0;
+  heavyHitters.clear();
+  numFilterPages = min(numAvailableBufPages - 1 - numBuckets,
+                       (min(left_pages, right_pages) +
+                        INPUT_PAGES_PER_FILTER_PAGE - 1) /
+                           INPUT_PAGES_PER_FILTER_PAGE);
+  if (keyWidth > 0 && numFilterPages > 0)
+    bloomFilter.reset((size_t)numFilterPages * Page::DATA_SIZE * 8);
+  else
+    numFilterPages = 0;
+  partitionPair(*leftInput, *rightInput, 0);
+  numUsedBufPages = max(numUsedBufPages, numBuckets + 1 + numFilterPages);
+  bloomFilter.clear();
+}
+
+bool GraceHashJoinOperator::next(TupleView& tuple) {
+  while (true) {
+    if (currentJoin != nullptr) {
+      if (currentJoin->next(tuple)) {
+        numResultTuples++;
+        return true;
+      }
+      finishPair();
+    }
+    if (!startNextPair())
+      return false;
+  }
+}
+
+void GraceHashJoinOperator::close() {
+  if (currentJoin != nullptr)
+    finishPair();
+  for (const BucketPair& pair : pendingPairs) {
+    File::remove(pair.leftFilename);
+    File::remove(pair.rightFilename);
+  }
+  pendingPairs.clear();
+}
+
+BucketId AdaptiveHashJoinOperator::bucketOf(const std::uint32_t* key) const {
+  // every level has its own seed, so that a bucket is split again one level
+  // deeper
+  return KeyHash::toBucket(
+      KeyHash::hash(key, keyWidth, KeyHash::seedOf(level)), numBuckets);
+}
+
+void AdaptiveHashJoinOperator::partitionInto(Operator& input,
+                                             bool isLeft,
+                                             const TupleView* first,
+                                             PartitionFiles& buckets) {
+  // one output page per bucket and one input page
+  vector<std::uint32_t> key(keyWidth / 4);
+  TupleView view;
+  bool has_tuple = first != nullptr;
+  if (has_tuple)
+    view = *first;
+  else
+    has_tuple = input.next(view);
+  while (has_tuple) {
+    if (keyWidth > 0)
+      writeJoinKey(view.data, isLeft, (char*)key.data());
+    buckets.append(bucketOf(key.data()), view.toString());
+    has_tuple = input.next(view);
+  }
+}
+
+void AdaptiveHashJoinOperator::switchToPartitioned(Operator& buildInput,
+                                                   const TupleView& overflow) {
+  partitioned = true;
+  switchTuples = buildOffsets.size();
+  switchPages = (buildBytes + Page::DATA_SIZE - 1) / Page::DATA_SIZE;
+  numBuckets = numAvailableBufPages - 1;
+  const string prefix = getPartitionPrefix("AHJ" + to_string(level));
+  PartitionFiles build_buckets(bufMgr), probe_buckets(bufMgr);
+  build_buckets.create(prefix, numBuckets);
+
+  // spill the tuples in memory a bucket at a time, through the page kept
+  // free for it
+  vector<std::uint32_t> bucket_starts(numBuckets + 1, 0);
+  vector<BucketId> row_buckets(switchTuples);
+  vector<std::uint32_t> key(keyWidth / 4);
+  for (int row = 0; row < switchTuples; ++row) {
+    if (keyWidth > 0)
+      writeJoinKey(buildData.data() + buildOffsets[row], buildLeft,
+                   (char*)key.data());
+    row_buckets[row] = bucketOf(key.data());
+    bucket_starts[row_buckets[row] + 1]++;
+  }
+  for (int i = 0; i < numBuckets; ++i) {
+    bucket_starts[i + 1] += bucket_starts[i];
+  }
+  vector<std::uint32_t> rows(switchTuples);
+  vector<std::uint32_t> next_rows(bucket_starts.begin(),
+                                  bucket_starts.end() - 1);
+  for (int row = 0; row < switchTuples; ++row) {
+    rows[next_rows[row_buckets[row]]++] = row;
+  }
+  buildOffsets.push_back(buildData.size());
+  for (int i = 0; i < numBuckets; ++i) {
+    if (bucket_starts[i] == bucket_starts[i + 1])
+      continue;
+    for (std::uint32_t j = bucket_starts[i]; j < bucket_starts[i + 1]; ++j) {
+      std::uint32_t row = rows[j];
+      build_buckets.append(i, buildData.substr(
+          buildOffsets[row], buildOffsets[row + 1] - buildOffsets[row]));
+    }
+    build_buckets.flush(i);
+  }
+  string().swap(buildData);
+  vector<std::uint32_t>().swap(buildOffsets);
+  vector<std::uint64_t>().swap(buildHashes);
+  hashTable.clear();
+
+  // the rest of the smaller input, then the other input
+  partitionInto(buildInput, buildLeft, &overflow, build_buckets);
+  buildInput.close();
+  build_buckets.close();
+  Operator& probe_input = buildLeft ? *rightInput : *leftInput;
+  probe_buckets.create(prefix, numBuckets);
+  probe_input.open();
+  partitionInto(probe_input, !buildLeft, nullptr, probe_buckets);
+  probe_input.close();
+  probe_buckets.close();
+  numUsedBufPages =
+      max(numUsedBufPages, max(numBuckets + 1, switchPages + 2));
+
+  PartitionFiles& left_buckets = buildLeft ? build_buckets : probe_buckets;
+  PartitionFiles& right_buckets = buildLeft ? probe_buckets : build_buckets;
+  for (int i = 0; i < numBuckets; ++i) {
+    numIOs += build_buckets.getNumPages(i) + probe_buckets.getNumPages(i);
+    if (build_buckets.getNumPages(i) > 0 && probe_buckets.getNumPages(i) > 0) {
+      BucketPair pair;
+      pair.leftFilename = left_buckets.getFilename(i);
+      pair.rightFilename = right_buckets.getFilename(i);
+      pair.leftPages = left_buckets.getNumPages(i);
+      pair.rightPages = right_buckets.getNumPages(i);
+      pendingPairs.push_back(pair);
+    } else {
+      // nothing can join with this bucket
+      File::remove(build_buckets.getFilename(i));
+      File::remove(probe_buckets.getFilename(i));
+    }
+  }
+}
+
+bool AdaptiveHashJoinOperator::startNextPair() {
+  if (pendingPairs.empty())
+    return false;
+  currentPair = pendingPairs.back();
+  pendingPairs.pop_back();
+  unique_ptr<Operator> left_scan(new TableScanOperator(
+      File::open(currentPair.leftFilename), leftTableSchema, bufMgr));
+  unique_ptr<Operator> right_scan(new TableScanOperator(
+      File::open(currentPair.rightFilename), rightTableSchema, bufMgr));
+  if (level + 1 < MAX_PARTITION_LEVELS ||
+      min(currentPair.leftPages, currentPair.rightPages) <=
+          numAvailableBufPages - 2) {
+    currentJoin.reset(new AdaptiveHashJoinOperator(std::move(left_scan),
+                                                   std::move(right_scan),
+                                                   catalog, bufMgr, level + 1));
+  } else {
+    // hashing did not split them enough (e.g. a single key value)
+    currentJoin.reset(new NestedLoopJoinOperator(
+        std::move(left_scan), std::move(right_scan), catalog, bufMgr));
+  }
+  currentJoin->setNumAvailableBufPages(numAvailableBufPages);
+  currentJoin->open();
+  numUsedBufPages = max(numUsedBufPages, currentJoin->getNumUsedBufPages());
+  return true;
+}
+
+void AdaptiveHashJoinOperator::finishPair() {
+  currentJoin->close();
+  numIOs += currentJoin->getNumIOs();
+  numUsedBufPages = max(numUsedBufPages, currentJoin->getNumUsedBufPages());
+  currentJoin.reset();
+  File::remove(currentPair.leftFilename);
+  File::remove(currentPair.rightFilename);
+}
+
+void AdaptiveHashJoinOperator::open() {
+  close();
+  numResultTuples = 0;
+  numUsedBufPages = 0;
+  partitioned = false;
+  switchTuples = 0;
+  switchPages = 0;
+  numBuckets = 0;
+
+  // the smaller input is read into M - 2 pages, next to one page of input
+  // and one page to spill through if it turns out not to fit
+  if (numAvailableBufPages < 3)
+    throw BufferExceededException();
+  buildLeft =
+      leftInput->getEstimatedPages() <= rightInput->getEstimatedPages();
+  Operator& build_input = buildLeft ? *leftInput : *rightInput;
+  TupleView overflow;
+  build_input.open();
+  if (!readBuildInput(build_input, numAvailableBufPages - 2, overflow)) {
+    switchToPartitioned(build_input, overflow);
+    return;
+  }
+  build_input.close();
+  buildTable(numAvailableBufPages - 2);
+  (buildLeft ? rightInput : leftInput)->open();
+}
+
+bool AdaptiveHashJoinOperator::next(TupleView& tuple) {
+  if (!partitioned)
+    return OnePassJoinOperator::next(tuple);
+  while (true) {
+    if (currentJoin != nullptr) {
+      if (currentJoin->next(tuple)) {
+        numResultTuples++;
+        return true;
+      }
+      finishPair();
+    }
+    if (!startNextPair())
+      return false;
+  }
+}
+
+void AdaptiveHashJoinOperator::close() {
+  OnePassJoinOperator::close();
+  if (currentJoin != nullptr)
+    finishPair();
+  for (const BucketPair& pair : pendingPairs) {
+    File::remove(pair.leftFilename);
+    File::remove(pair.rightFilename);
+  }
+  pendingPairs.clear();
+}
+
+ParallelGraceHashJoinOperator::ParallelGraceHashJoinOperator(
+    File& leftTableFile,
+    File& rightTableFile,
+    const TableSchema& leftTableSchema,
+    const TableSchema& rightTableSchema,
+    const Catalog* catalog,
+    BufMgr* bufMgr,
+    int numWorkers)
+    : JoinOperator(leftTableFile,
+                   rightTableFile,
+                   leftTableSchema,
+                   rightTableSchema,
+                   catalog,
+                   bufMgr),
+      leftFile(leftTableFile),
+      rightFile(rightTableFile),
+      numWorkers(numWorkers > 0 ? numWorkers
+                                : max<int>(thread::hardware_concurrency(), 1)),
+      numActiveWorkers(0),
+      workerBufPages(0),
+      numBuckets(0),
+      numFilterPages(0),
+      numFilteredTuples(0),
+      joined(true),
+      numPendingTasks(0),
+      failed(false),
+      resultBuckets(bufMgr),
+      resultFile(0) {
+  // nothing
+}
+
+void ParallelGraceHashJoinOperator::createBuckets(int numBuckets,
+                                                  BucketSet& buckets) {
+  buckets.files.create(getPartitionPrefix("PGHJ"), numBuckets);
   {
-    frameUsed=0;//how many frames in the buffer pool is being used
-    vector<string> sTuple,rTuple;//two tuples to be joit
-    string ret;//the result tuple
-    for(frameUsed=0;frameUsed<frameAmt && s_it!=sfile.end();++frameUsed,++s_it)
-    {
-      //read m-1 pages of S to the buffer pool, place from frames[0] to frames[m-2]
-      bufMgr->readPage(&sfile,(*s_it).page_number(),frames[frameUsed]);
-      numIOs++;
-      numUsedBufPages++;
+    lock_guard<mutex> lock(partitionFilesLock);
+    for (int i = 0; i < numBuckets; ++i) {
+      partitionFiles.insert(buckets.files.getFilename(i));
     }
-    for(FileIterator r_it=rfile.begin();r_it!=rfile.end();++r_it)
-    {
-      //read 1 page of R to the buffer pool, place at rframe
-      bufMgr->readPage(&rfile,(*r_it).page_number(),rframe);
-      numIOs++;
-      numUsedBufPages++;
-      for(PageIterator rframe_it=rframe->begin();rframe_it!=rframe->end();++rframe_it)
-      {
-        splitTuple(rschema,*rframe_it,rTuple);
-        for(int i=0;i<frameUsed;++i)
-        {
-          for(PageIterator sframe_it=frames[i]->begin();sframe_it!=frames[i]->end();++sframe_it)
-          {
-            splitTuple(sschema,*sframe_it,sTuple);
-            ret.clear();
-            bool flag=1;//set to 0 when the join operator fails
-            for(int j=0;j<resultTableSchema.getAttrCount();++j)
-            {
-              string attr=resultTableSchema.getAttrName(j);
-              bool shas=sschema.hasAttr(attr);
-              bool rhas=rschema.hasAttr(attr);
-              string sraw=sTuple[sschema.getAttrNum(attr)];
-              string rraw=rTuple[rschema.getAttrNum(attr)];
-              if(shas && rhas)//this attr comes from both R and S, it's the junction
-              {
-                /*
-                  Actually, we should check the attrs before this for-loop
-                  so that the junction attr could be checked at the first place of the for-loop, in order to drop those failing join operator at the beginning
-                  and passingly we can findout whether an attr comes from S or T.
-                  But this preprocess is annoying. I'm lazy and I don't want to increase the complexity of my code.
-                */
-                if(sraw!=rraw)//if the values of this attr in S and R are not equal, then the join operator fails
-                {
-                  flag=0;//drop this tuple
-                  break;
-                }
-                ret+=sraw;
-              }
-              else if(shas)//this attr comes from S
-              {
-                ret+=sraw;
-              }
-              else//this attr comes from R
-              {
-                ret+=rraw;
-              }
-            }
-            if(flag)//join success
-            {
-              HeapFileManager::insertTuple(ret,resultFile,bufMgr);
-              ++numResultTuples;
-            }
+  }
+  buckets.locks.reset(new mutex[numBuckets]);
+}
+
+void ParallelGraceHashJoinOperator::removePartitionFile(
+    const string& filename) {
+  File::remove(filename);
+  lock_guard<mutex> lock(partitionFilesLock);
+  partitionFiles.erase(filename);
+}
+
+void ParallelGraceHashJoinOperator::partitionPages(
+    int worker,
+    File& file,
+    const vector<PageId>& pages,
+    bool isLeft,
+    int level,
+    BucketSet& buckets,
+    BloomFilter* insertInto,
+    const BloomFilter* filterBy) {
+  const int num_buckets = buckets.files.getNumFiles();
+  const int key_words = keyWidth / 4;
+  const std::uint64_t seed = KeyHash::seedOf(level);
+  // the keys of up to KeyHash::MAX_BATCH tuples of the page, hashed together
+  vector<std::uint32_t> keys((size_t)KeyHash::MAX_BATCH * key_words);
+  const void* batch_keys[KeyHash::MAX_BATCH];
+  const char* batch_tuples[KeyHash::MAX_BATCH];
+  std::uint16_t batch_lengths[KeyHash::MAX_BATCH];
+  std::uint64_t batch_hashes[KeyHash::MAX_BATCH];
+  int num_batched = 0;
+  auto append_batch = [&]() {
+    KeyHash::hashBatch(batch_keys, num_batched, keyWidth, seed, batch_hashes);
+    for (int i = 0; i < num_batched; ++i) {
+      BucketId bucket = KeyHash::toBucket(batch_hashes[i], num_buckets);
+      lock_guard<mutex> lock(buckets.locks[bucket]);
+      buckets.files.append(bucket, string(batch_tuples[i], batch_lengths[i]));
+    }
+    num_batched = 0;
+  };
+  for (PageId page_number : pages) {
+    Page* page;
+    bufMgr->readPage(&file, page_number, page);
+    outputs[worker].numIOs++;
+    try {
+      for (PageIterator iter = page->begin(); iter != page->end(); ++iter) {
+        std::uint16_t length;
+        const char* tuple = iter.data(length);
+        std::uint32_t* key = &keys[(size_t)num_batched * key_words];
+        if (keyWidth > 0)
+          writeJoinKey(tuple, isLeft, (char*)key);
+        if (insertInto != nullptr || filterBy != nullptr) {
+          std::uint64_t key_hash = keyKernels.hash(key, key_words);
+          if (filterBy != nullptr && !filterBy->mayContain(key_hash)) {
+            outputs[worker].numFilteredTuples++;  // cannot have a match
+            continue;
           }
+          if (insertInto != nullptr)
+            insertInto->insert(key_hash);
         }
+        batch_keys[num_batched] = key;
+        batch_tuples[num_batched] = tuple;
+        batch_lengths[num_batched] = length;
+        if (++num_batched == KeyHash::MAX_BATCH)
+          append_batch();
       }
-      //release that 1 page of R
-      bufMgr->unPinPage(&rfile,(*r_it).page_number(),false);
+      // the tuples of the batch are in the page
+      append_batch();
+    } catch (...) {
+      bufMgr->unPinPage(&file, page_number, false);
+      throw;
     }
-    //relase that m-1 pages of S
-    for(int i=0;i<frameUsed;++i)
-    {
-      bufMgr->unPinPage(&sfile,frames[i]->page_number(),false);
+    bufMgr->unPinPage(&file, page_number, false);
+  }
+}
+
+void ParallelGraceHashJoinOperator::joinPair(int worker,
+                                             const BucketPair& pair) {
+  WorkerOutput& output = outputs[worker];
+  // the tail page of the result file of the worker stays pinned
+  const int join_buf_pages = workerBufPages - 1;
+  if (min(pair.leftPages, pair.rightPages) > join_buf_pages - 1 &&
+      pair.level < MAX_PARTITION_LEVELS) {
+    // neither bucket fits in the pages of a worker, split them again with
+    // one input page and one output page per bucket
+    const int num_buckets = join_buf_pages - 1;
+    BucketSet left_buckets(bufMgr), right_buckets(bufMgr);
+    createBuckets(num_buckets, left_buckets);
+    createBuckets(num_buckets, right_buckets);
+    for (int side = 0; side < 2; ++side) {
+      bool is_left = side == 0;
+      BucketSet& buckets = is_left ? left_buckets : right_buckets;
+      {
+        File file =
+            File::open(is_left ? pair.leftFilename : pair.rightFilename);
+        vector<PageId> pages;
+        for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+          pages.push_back(iter.page_number());
+        }
+        partitionPages(worker, file, pages, is_left, pair.level, buckets);
+        bufMgr->flushFile(&file);
+      }
+      buckets.files.close();
+    }
+    output.numUsedBufPages = max(output.numUsedBufPages, num_buckets + 2);
+    removePartitionFile(pair.leftFilename);
+    removePartitionFile(pair.rightFilename);
+    for (int i = 0; i < num_buckets; ++i) {
+      int left_pages = left_buckets.files.getNumPages(i);
+      int right_pages = right_buckets.files.getNumPages(i);
+      output.numIOs += left_pages + right_pages;
+      if (left_pages > 0 && right_pages > 0) {
+        BucketPair sub_pair = {left_buckets.files.getFilename(i),
+                               right_buckets.files.getFilename(i), left_pages,
+                               right_pages, pair.level + 1};
+        pushTask(worker, {min(sub_pair.leftPages, sub_pair.rightPages),
+                          [this, sub_pair](int w) { joinPair(w, sub_pair); }});
+      } else {
+        // nothing can join with this bucket
+        removePartitionFile(left_buckets.files.getFilename(i));
+        removePartitionFile(right_buckets.files.getFilename(i));
+      }
     }
+    return;
   }
-  isComplete = true;
-  return true;
+
+  {
+    unique_ptr<Operator> left_scan(new TableScanOperator(
+        File::open(pair.leftFilename), leftTableSchema, bufMgr));
+    unique_ptr<Operator> right_scan(new TableScanOperator(
+        File::open(pair.rightFilename), rightTableSchema, bufMgr));
+    unique_ptr<JoinOperator> join;
+    if (min(pair.leftPages, pair.rightPages) <= join_buf_pages - 1) {
+      join.reset(new OnePassJoinOperator(std::move(left_scan),
+                                         std::move(right_scan), catalog,
+                                         bufMgr));
+    } else {
+      // hashing does not split them any further (e.g. a single key value)
+      join.reset(new NestedLoopJoinOperator(std::move(left_scan),
+                                            std::move(right_scan), catalog,
+                                            bufMgr));
+    }
+    join->setNumAvailableBufPages(join_buf_pages);
+    TupleView tuple;
+    join->open();
+    while (join->next(tuple)) {
+      resultBuckets.files.append(worker, string(tuple.data, tuple.size));
+    }
+    join->close();
+    output.numIOs += join->getNumIOs();
+    output.numUsedBufPages =
+        max(output.numUsedBufPages, join->getNumUsedBufPages() + 1);
+  }
+  removePartitionFile(pair.leftFilename);
+  removePartitionFile(pair.rightFilename);
 }
 
-BucketId GraceHashJoinOperator::hash(const string& key) const {
-  std::hash<string> strHash;
-  return strHash(key) % numBuckets;
+void ParallelGraceHashJoinOperator::pushTask(int worker, Task task) {
+  numPendingTasks++;
+  TaskQueue& queue = *queues[worker];
+  lock_guard<mutex> lock(queue.lock);
+  auto pos = queue.tasks.begin();
+  while (pos != queue.tasks.end() && pos->pages >= task.pages) {
+    ++pos;
+  }
+  queue.tasks.insert(pos, std::move(task));
 }
 
-bool GraceHashJoinOperator::execute(int numAvailableBufPages,
-                                    File& resultFile) {
-  if (isComplete)
-    return true;
+bool ParallelGraceHashJoinOperator::takeTask(int worker, Task& task) {
+  // the own queue first, then the other ones in turn. Taking the largest
+  // task splits a large bucket pair early, and idle workers steal its
+  // pieces before anything else.
+  for (int i = 0; i < numActiveWorkers; ++i) {
+    TaskQueue& queue = *queues[(worker + i) % numActiveWorkers];
+    lock_guard<mutex> lock(queue.lock);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
 
+void ParallelGraceHashJoinOperator::runWorker(int worker) {
+  // tasks queue their pieces before they are done, so no work can be left
+  // once nothing is pending
+  while (numPendingTasks > 0) {
+    Task task;
+    if (!takeTask(worker, task)) {
+      this_thread::yield();  // the last tasks are still running
+      continue;
+    }
+    if (!failed) {
+      try {
+        task.run(worker);
+      } catch (...) {
+        if (outputs[worker].error == nullptr)
+          outputs[worker].error = current_exception();
+        failed = true;
+      }
+    }
+    numPendingTasks--;
+  }
+}
+
+void ParallelGraceHashJoinOperator::runTasks(vector<Task> tasks) {
+  failed = false;
+  sort(tasks.begin(), tasks.end(),
+       [](const Task& a, const Task& b) { return a.pages > b.pages; });
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    pushTask(i % numActiveWorkers, std::move(tasks[i]));
+  }
+  // the calling thread is worker 0
+  vector<thread> threads;
+  for (int w = 1; w < numActiveWorkers; ++w) {
+    threads.push_back(
+        thread(&ParallelGraceHashJoinOperator::runWorker, this, w));
+  }
+  runWorker(0);
+  for (thread& t : threads) {
+    t.join();
+  }
+  for (WorkerOutput& output : outputs) {
+    numIOs += output.numIOs;
+    output.numIOs = 0;
+    if (output.error != nullptr)
+      rethrow_exception(output.error);
+  }
+}
+
+void ParallelGraceHashJoinOperator::open() {
+  close();
   numResultTuples = 0;
   numUsedBufPages = 0;
-  numIOs = 0;
 
-  // TODO: Execute the join algorithm
+  // a worker needs one input page and two buckets, next to the tail page of
+  // its result file, i.e. four pages
+  if (numAvailableBufPages < 4)
+    throw BufferExceededException();
+  numActiveWorkers = max(1, min(numWorkers, numAvailableBufPages / 4));
+  workerBufPages = numAvailableBufPages / numActiveWorkers;
+  queues.clear();
+  for (int w = 0; w < numActiveWorkers; ++w) {
+    queues.push_back(unique_ptr<TaskQueue>(new TaskQueue()));
+  }
+  outputs.assign(numActiveWorkers, WorkerOutput());
+  for (WorkerOutput& output : outputs) {
+    output.numIOs = output.numUsedBufPages = output.numFilteredTuples = 0;
+  }
 
-  isComplete = true;
-  return true;
+  // every worker pins an input page, next to one output page per bucket.
+  // A bucket of the smaller input should fit in the pages of a worker, and
+  // there should be some buckets per worker to balance the load.
+  vector<PageId> left_pages, right_pages;
+  for (FileIterator iter = leftFile.begin(); iter != leftFile.end(); ++iter) {
+    left_pages.push_back(iter.page_number());
+  }
+  for (FileIterator iter = rightFile.begin(); iter != rightFile.end();
+       ++iter) {
+    right_pages.push_back(iter.page_number());
+  }
+  int min_pages = min(left_pages.size(), right_pages.size());
+  int needed_buckets =
+      (min_pages + workerBufPages - 3) / max(workerBufPages - 2, 1);
+  numBuckets = max(2, min(numAvailableBufPages - numActiveWorkers,
+                          max(needed_buckets, 2 * numActiveWorkers)));
+
+  // the pages left over hold a Bloom filter per worker on the keys of the
+  // smaller input
+  numFilteredTuples = 0;
+  const int pages_per_filter_page =
+      GraceHashJoinOperator::INPUT_PAGES_PER_FILTER_PAGE;
+  numFilterPages =
+      min((numAvailableBufPages - numActiveWorkers - numBuckets) /
+              numActiveWorkers,
+          (min_pages + pages_per_filter_page - 1) / pages_per_filter_page);
+  if (keyWidth == 0 || numFilterPages <= 0)
+    numFilterPages = 0;
+  bloomFilters.assign(numFilterPages > 0 ? numActiveWorkers : 0,
+                      BloomFilter());
+  for (BloomFilter& filter : bloomFilters) {
+    filter.reset((size_t)numFilterPages * Page::DATA_SIZE * 8);
+  }
+  numUsedBufPages =
+      numBuckets + numActiveWorkers + numFilterPages * numActiveWorkers;
+
+  // partition the inputs one after the other, a range of pages per task;
+  // the smaller input fills the filters, the other one is filtered
+  bool left_first = left_pages.size() <= right_pages.size();
+  BucketSet left_buckets(bufMgr), right_buckets(bufMgr);
+  for (int side = 0; side < 2; ++side) {
+    bool is_left = (side == 0) == left_first;
+    bool fill_filter = side == 0 && !bloomFilters.empty();
+    bool apply_filter = side == 1 && !bloomFilters.empty();
+    File& file = is_left ? leftFile : rightFile;
+    const vector<PageId>& pages = is_left ? left_pages : right_pages;
+    BucketSet& buckets = is_left ? left_buckets : right_buckets;
+    createBuckets(numBuckets, buckets);
+    vector<Task> tasks;
+    for (size_t first = 0; first < pages.size(); first += PAGES_PER_TASK) {
+      vector<PageId> range(
+          pages.begin() + first,
+          pages.begin() + min(pages.size(), first + PAGES_PER_TASK));
+      BucketSet* target = &buckets;
+      tasks.push_back(
+          {(int)range.size(),
+           [this, &file, range, is_left, target, fill_filter,
+            apply_filter](int w) {
+             partitionPages(w, file, range, is_left, 0, *target,
+                            fill_filter ? &bloomFilters[w] : nullptr,
+                            apply_filter ? &bloomFilters[0] : nullptr);
+           }});
+    }
+    runTasks(std::move(tasks));
+    bufMgr->flushFile(&file);
+    buckets.files.close();
+    if (fill_filter) {
+      for (size_t w = 1; w < bloomFilters.size(); ++w) {
+        bloomFilters[0].merge(bloomFilters[w]);
+        bloomFilters[w].clear();
+      }
+    }
+  }
+  bloomFilters.clear();
+  for (WorkerOutput& output : outputs) {
+    numFilteredTuples += output.numFilteredTuples;
+  }
+
+  initialPairs.clear();
+  for (int i = 0; i < numBuckets; ++i) {
+    int left_bucket_pages = left_buckets.files.getNumPages(i);
+    int right_bucket_pages = right_buckets.files.getNumPages(i);
+    numIOs += left_bucket_pages + right_bucket_pages;
+    if (left_bucket_pages > 0 && right_bucket_pages > 0) {
+      initialPairs.push_back({left_buckets.files.getFilename(i),
+                              right_buckets.files.getFilename(i),
+                              left_bucket_pages, right_bucket_pages, 1});
+    } else {
+      // nothing can join with this bucket
+      removePartitionFile(left_buckets.files.getFilename(i));
+      removePartitionFile(right_buckets.files.getFilename(i));
+    }
+  }
+  joined = false;
+}
+
+bool ParallelGraceHashJoinOperator::next(TupleView& tuple) {
+  if (!joined) {
+    // join all bucket pairs, the results wait in the result files
+    joined = true;
+    createBuckets(numActiveWorkers, resultBuckets);
+    vector<Task> tasks;
+    for (const BucketPair& pair : initialPairs) {
+      tasks.push_back({min(pair.leftPages, pair.rightPages),
+                       [this, pair](int w) { joinPair(w, pair); }});
+    }
+    initialPairs.clear();
+    runTasks(std::move(tasks));
+    resultBuckets.files.close();
+    int used_buf_pages = 0;
+    for (int w = 0; w < numActiveWorkers; ++w) {
+      numIOs += resultBuckets.files.getNumPages(w);
+      used_buf_pages += outputs[w].numUsedBufPages;
+    }
+    numUsedBufPages = max(numUsedBufPages, used_buf_pages);
+    resultFile = 0;
+  }
+  while (true) {
+    if (resultScan != nullptr) {
+      if (resultScan->next(tuple)) {
+        numResultTuples++;
+        return true;
+      }
+      resultScan->close();
+      numIOs += resultScan->getNumIOs();
+      resultScan.reset();
+      removePartitionFile(resultBuckets.files.getFilename(resultFile++));
+    }
+    if (resultFile >= resultBuckets.files.getNumFiles())
+      return false;
+    resultScan.reset(new TableScanOperator(
+        File::open(resultBuckets.files.getFilename(resultFile)), schema,
+        bufMgr));
+    resultScan->open();
+  }
+}
+
+void ParallelGraceHashJoinOperator::close() {
+  joined = true;
+  initialPairs.clear();
+  outputs.clear();
+  resultScan.reset();
+  resultBuckets.files.remove();
+  resultFile = 0;
+  for (unique_ptr<TaskQueue>& queue : queues) {
+    queue->tasks.clear();
+  }
+  numPendingTasks = 0;
+  // the partition files of an unfinished run
+  for (const string& filename : partitionFiles) {
+    if (File::exists(filename) && !File::isOpen(filename))
+      File::remove(filename);
+  }
+  partitionFiles.clear();
+  // the input frames are keyed by this operator's file handles
+  bufMgr->flushFile(&leftFile);
+  bufMgr->flushFile(&rightFile);
 }
 
-}  // namespace badgerdb
\ No newline at end of file
+}  // namespace badgerdb
@@ -6,10 +6,31 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bloom_filter.h"
+#include "btree.h"
 #include "buffer.h"
 #include "catalog.h"
 #include "file.h"
+#include "key_kernels.h"
+#include "operator.h"
+#include "partition_files.h"
+#include "radix_hash_table.h"
 #include "schema.h"
+#include "statistics.h"
 #include "storage.h"
 
 using namespace std;
@@ -55,19 +76,21 @@ class TableScanner {
 };
 
 /**
- * Join Operator
+ * Join Operator. The inputs are operators, by default scans of two table
+ * files. A join can be pulled tuple by tuple through open()/next()/close()
+ * like any operator, or run to completion into a result file by execute().
  */
-class JoinOperator {
+class JoinOperator : public Operator {
  protected:
   /**
-   * Data file of the left table
+   * Left input
    */
-  File& leftTableFile;
+  unique_ptr<Operator> leftInput;
 
   /**
-   * Data file of the right table
+   * Right input
    */
-  File& rightTableFile;
+  unique_ptr<Operator> rightInput;
 
   /**
    * Schema of the left table
@@ -80,9 +103,46 @@ class JoinOperator {
   const TableSchema& rightTableSchema;
 
   /**
-   * Schema of the result table
+   * Layouts of the left and right tuples
+   */
+  TupleLayout leftLayout;
+  TupleLayout rightLayout;
+
+  /**
+   * Common attributes of the left and right input, and their width in a
+   * join key
+   */
+  vector<int> leftKeyAttrs;
+  vector<int> rightKeyAttrs;
+  vector<int> keyAttrWidths;
+
+  /**
+   * Width of a join key in bytes
+   */
+  int keyWidth;
+
+  /**
+   * Writers of the join keys of the left and right tuples, set if the key
+   * is a single attribute at a fixed offset
+   */
+  KeyWriter leftKeyWriter;
+  KeyWriter rightKeyWriter;
+
+  /**
+   * Hash and equality kernels of the join keys, for keyWidth bytes
+   */
+  KeyKernels keyKernels;
+
+  /**
+   * Right attributes copied into a result tuple
    */
-  TableSchema resultTableSchema;
+  vector<int> rightOutputAttrs;
+
+  /**
+   * The bytes of a right tuple copied into a result tuple, as (offset,
+   * length) runs; empty if their position depends on a VARCHAR
+   */
+  vector<pair<int, int>> rightOutputRuns;
 
   /**
    * System catalog
@@ -90,9 +150,9 @@ class JoinOperator {
   const Catalog* catalog;
 
   /**
-   * Buffer pool manager
+   * Number of buffer pages the executor may use
    */
-  BufMgr* bufMgr;
+  int numAvailableBufPages;
 
   /**
    * Is the executor completed
@@ -110,13 +170,24 @@ class JoinOperator {
   int numUsedBufPages;
 
   /**
-   * Number of I/Os carried out by the executor
+   * Current result tuple
    */
-  int numIOs;
+  string resultTuple;
 
  public:
   /**
-   * Constructor
+   * Number of buffer pages used unless set otherwise
+   */
+  static const int DEFAULT_NUM_BUF_PAGES = 100;
+
+  /**
+   * Partitions of a hash join are split again at most this many times
+   * before falling back to a nested-loop join
+   */
+  static const int MAX_PARTITION_LEVELS = 3;
+
+  /**
+   * Constructor, joining two tables
    */
   JoinOperator(File& leftTableFile,
                File& rightTableFile,
@@ -125,10 +196,18 @@ class JoinOperator {
                const Catalog* catalog,
                BufMgr* bufMgr);
 
+  /**
+   * Constructor, joining the outputs of two operators
+   */
+  JoinOperator(unique_ptr<Operator> leftInput,
+               unique_ptr<Operator> rightInput,
+               const Catalog* catalog,
+               BufMgr* bufMgr);
+
   /**
    * Destructor
    */
-  ~JoinOperator() {
+  virtual ~JoinOperator() {
     // nothing
   }
 
@@ -148,15 +227,22 @@ class JoinOperator {
   virtual void printRunningStats() const;
 
   /**
-   * Execute the join algorithm
+   * Set the number of buffer pages the executor may use
+   */
+  void setNumAvailableBufPages(int numAvailableBufPages) {
+    this->numAvailableBufPages = numAvailableBufPages;
+  }
+
+  /**
+   * Execute the join algorithm, writing the result into resultFile
    * @return If succeeded, return true
    */
-  virtual bool execute(int numAvailableBufPages, File& resultFile) = 0;
+  bool execute(int numAvailableBufPages, File& resultFile);
 
   /**
    * Get the schema of the result table
    */
-  const TableSchema& getResultTableSchema() const { return resultTableSchema; }
+  const TableSchema& getResultTableSchema() const { return schema; }
 
   /**
    * Get number of result tuples
@@ -169,9 +255,18 @@ class JoinOperator {
   int getNumUsedBufPages() const { return numUsedBufPages; }
 
   /**
-   * Get number of I/Os carried out by the executor
+   * Get number of I/Os carried out by the executor, including the inputs
+   */
+  int getNumIOs() const {
+    return numIOs + leftInput->getNumIOs() + rightInput->getNumIOs();
+  }
+
+  /**
+   * Get the estimated number of pages of the result
    */
-  int getNumIOs() const { return numIOs; }
+  int getEstimatedPages() const {
+    return leftInput->getEstimatedPages() + rightInput->getEstimatedPages();
+  }
 
   /**
    * Create the result schema using the input schemas
@@ -182,22 +277,149 @@ class JoinOperator {
 
  protected:
   /**
-   * Get common attributes in all input tables
+   * Resolve the join attributes and the sources of the result attributes,
+   * once for all tuples
    */
-  vector<Attribute> getCommonAttributes(
-      const TableSchema& leftTableSchema,
-      const TableSchema& rightTableSchema) const;
+  void bindAttributes();
+
+  /**
+   * Write the join key of a left or right tuple: the values of the common
+   * attributes, each zero-padded to a fixed width, so that keys of the two
+   * inputs can be compared with memcmp
+   * @param key keyWidth bytes, a multiple of 4
+   */
+  void writeJoinKey(const char* tuple, bool isLeft, char* key) const {
+    const KeyWriter& writer = isLeft ? leftKeyWriter : rightKeyWriter;
+    if (writer.isSet())
+      writer(tuple, key);
+    else
+      writeAnyJoinKey(tuple, isLeft, key);
+  }
 
   /**
-   * Join two tuples
+   * Write the join key of a tuple attribute by attribute, for keys the
+   * writers are not set for
    */
-  string joinTuples(string leftTuple,
-                    string rightTuple,
-                    const TableSchema& leftTableSchema,
-                    const TableSchema& rightTableSchema) const;
+  void writeAnyJoinKey(const char* tuple, bool isLeft, char* key) const;
+
+  /**
+   * Get the prefix of the names of the partition files of a join method
+   */
+  string getPartitionPrefix(const string& method) const {
+    return leftTableSchema.getTableName() + "_" + method + "_" +
+           rightTableSchema.getTableName();
+  }
+
+  /**
+   * Get the join key of a left or right tuple
+   */
+  string getJoinKey(const char* tuple, bool isLeft) const {
+    string key(keyWidth, '\0');
+    if (keyWidth > 0)
+      writeJoinKey(tuple, isLeft, &key[0]);
+    return key;
+  }
+
+  /**
+   * Join two tuples into result
+   */
+  void joinTuples(const char* leftTuple,
+                  int leftSize,
+                  const char* rightTuple,
+                  string& result) const;
 };
 
+/**
+ * One-pass hash join: the smaller input is read into memory, the other one
+ * streams past it. The in-memory input is indexed by a RadixHashTable, and
+ * the streamed tuples are looked up a batch at a time, prefetching their
+ * buckets.
+ */
 class OnePassJoinOperator : public JoinOperator {
+ protected:
+  /**
+   * Is the left input held in memory?
+   */
+  bool buildLeft;
+
+  /**
+   * Tuples of the smaller input, back to back, and where each one starts,
+   * followed by the end of the last one
+   */
+  string buildData;
+  vector<std::uint32_t> buildOffsets;
+
+  /**
+   * Bytes the tuples of the smaller input take in pages
+   */
+  size_t buildBytes;
+
+  /**
+   * 64-bit hashes of the keys of the smaller input, until the table is
+   * built
+   */
+  vector<std::uint64_t> buildHashes;
+
+  /**
+   * Index of the smaller input by join key
+   */
+  RadixHashTable hashTable;
+
+  /**
+   * Join keys of the smaller input, so that most streamed tuples without a
+   * match are dropped before a lookup; disabled if it does not fit in memory
+   */
+  BloomFilter bloomFilter;
+
+  /**
+   * Number of streamed tuples dropped by the Bloom filter
+   */
+  int numFilteredTuples;
+
+  /**
+   * Current batch of the streamed input: tuples, offsets as for buildData,
+   * keys and their hashes
+   */
+  string probeData;
+  vector<std::uint32_t> probeOffsets;
+  vector<std::uint32_t> probeKeys;
+  vector<std::uint32_t> probeHashes;
+
+  /**
+   * Matches of the current batch as (streamed tuple, in-memory tuple), and
+   * the next one to return
+   */
+  vector<pair<std::uint32_t, std::uint32_t>> matches;
+  size_t nextMatch;
+
+  /**
+   * Read the next batch of the streamed input and find its matches
+   * @return False if the streamed input is used up
+   */
+  bool probeBatch();
+
+  /**
+   * Find the matches of the current batch, for keys of WORDS words
+   */
+  template <int WORDS>
+  void findBatchMatches();
+
+  /**
+   * Read the tuples of the smaller input into memory
+   * @param capacityPages Pages the tuples may take
+   * @param overflow Receives the first tuple that did not fit
+   * @return False if a tuple did not fit
+   */
+  bool readBuildInput(Operator& buildInput,
+                      int capacityPages,
+                      TupleView& overflow);
+
+  /**
+   * Index the tuples read, and fill the Bloom filter if it fits next to
+   * them in capacityPages pages
+   */
+  void buildTable(int capacityPages);
+
  public:
   /**
    * Constructor
@@ -213,7 +435,29 @@ class OnePassJoinOperator : public JoinOperator {
                      leftTableSchema,
                      rightTableSchema,
                      catalog,
-                     bufMgr) {
+                     bufMgr),
+        buildLeft(true),
+        buildBytes(0),
+        numFilteredTuples(0),
+        nextMatch(0) {
+    // nothing
+  }
+
+  /**
+   * Constructor
+   */
+  OnePassJoinOperator(unique_ptr<Operator> leftInput,
+                      unique_ptr<Operator> rightInput,
+                      const Catalog* catalog,
+                      BufMgr* bufMgr)
+      : JoinOperator(std::move(leftInput),
+                     std::move(rightInput),
+                     catalog,
+                     bufMgr),
+        buildLeft(true),
+        buildBytes(0),
+        numFilteredTuples(0),
+        nextMatch(0) {
     // nothing
   }
 
@@ -229,10 +473,139 @@ class OnePassJoinOperator : public JoinOperator {
    */
   string getOperatorName() const { return "ONE_PASS_JOIN"; }
 
-  bool execute(int numAvailableBufPages, File& resultFile);
+  /**
+   * Print running statistics (overrided)
+   */
+  void printRunningStats() const {
+    JoinOperator::printRunningStats();
+    cout << "# Filtered Tuples: " << numFilteredTuples << endl;
+  }
+
+  /**
+   * Get the number of streamed tuples dropped by the Bloom filter
+   */
+  int getNumFilteredTuples() const { return numFilteredTuples; }
+
+  /**
+   * Number of streamed tuples looked up together
+   */
+  static const int PROBE_BATCH_SIZE = 64;
+
+  /**
+   * Bloom filter bits per tuple of the smaller input
+   */
+  static const int BLOOM_FILTER_BITS_PER_TUPLE = 10;
+
+  /**
+   * Read the smaller input into memory
+   * @throws BufferExceededException If it needs more than M - 1 pages
+   */
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close();
 };
 
+/**
+ * Block nested-loop join: M - 1 pages of the smaller (outer) input are held
+ * in memory while the other (inner) input is scanned. The block is hashed on
+ * the join key, so an inner tuple is only compared with the outer tuples of
+ * its bucket.
+ */
 class NestedLoopJoinOperator : public JoinOperator {
+ protected:
+  /**
+   * Is the left input the outer one?
+   */
+  bool outerLeft;
+
+  /**
+   * Number of buffer pages kept for the inner input, the block gets the
+   * other ones
+   */
+  int numInnerBufPages;
+
+  /**
+   * Outer tuples of the current block, stored back to back, and where each
+   * of them starts; the last offset is the end of the block
+   */
+  string blockData;
+  vector<int> blockOffsets;
+
+  /**
+   * Number of outer tuples in the current block
+   */
+  int numBlockTuples;
+
+  /**
+   * Join keys of the block, keyWidth bytes per outer tuple
+   */
+  vector<std::uint32_t> blockKeys;
+
+  /**
+   * Hash table over the block keys of an equi-join: first outer tuple per
+   * bucket and next outer tuple with the same bucket, numBlockTuples ends a
+   * chain. Unused if there are no common attributes.
+   */
+  vector<int> blockBuckets;
+  vector<int> blockChain;
+  std::uint32_t blockBucketMask;
+
+  /**
+   * First outer tuple of the next block, if it has been read already
+   */
+  string pendingTuple;
+  bool hasPendingTuple;
+
+  /**
+   * Current inner tuple and its join key
+   */
+  TupleView innerTuple;
+  vector<std::uint32_t> innerKey;
+  bool hasInnerTuple;
+
+  /**
+   * Next outer tuple of the block to match with innerTuple: a position in
+   * the block, or in a hash chain
+   */
+  int blockPos;
+
+  /**
+   * Read the next block of outer tuples
+   */
+  void loadBlock();
+
+  /**
+   * Build the hash table over the keys of the block
+   */
+  void hashBlock();
+
+  /**
+   * Find the first outer tuple with a join key, from position from on in the
+   * block or in a hash chain
+   * @return numBlockTuples if there is none
+   */
+  int findMatch(const std::uint32_t* key, int from) const;
+
+  /**
+   * findMatch for keys of WORDS words
+   */
+  template <int WORDS>
+  int findMatchOf(const std::uint32_t* key, int from) const;
+
+  /**
+   * Get the position after outer tuple i in the block or in its hash chain
+   */
+  int nextPosition(int i) const {
+    return blockChain.empty() ? i + 1 : blockChain[i];
+  }
+
+  /**
+   * Get the position of the first outer tuple that may match a join key
+   */
+  int firstPosition(const std::uint32_t* key) const;
+
  public:
   /**
    * Constructor
@@ -248,7 +621,35 @@ class NestedLoopJoinOperator : public JoinOperator {
                      leftTableSchema,
                      rightTableSchema,
                      catalog,
-                     bufMgr) {
+                     bufMgr),
+        outerLeft(true),
+        numInnerBufPages(1),
+        numBlockTuples(0),
+        blockBucketMask(0),
+        hasPendingTuple(false),
+        hasInnerTuple(false),
+        blockPos(0) {
+    // nothing
+  }
+
+  /**
+   * Constructor
+   */
+  NestedLoopJoinOperator(unique_ptr<Operator> leftInput,
+                         unique_ptr<Operator> rightInput,
+                         const Catalog* catalog,
+                         BufMgr* bufMgr)
+      : JoinOperator(std::move(leftInput),
+                     std::move(rightInput),
+                     catalog,
+                     bufMgr),
+        outerLeft(true),
+        numInnerBufPages(1),
+        numBlockTuples(0),
+        blockBucketMask(0),
+        hasPendingTuple(false),
+        hasInnerTuple(false),
+        blockPos(0) {
     // nothing
   }
 
@@ -264,71 +665,1065 @@ class NestedLoopJoinOperator : public JoinOperator {
    */
   string getOperatorName() const { return "NESTED_LOOP_JOIN"; }
 
-  bool execute(int numAvailableBufPages, File& resultFile);
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close();
 };
 
 /**
- * Bucket Id type
+ * Threads kept by a parallel operator across its rounds of work. A round
+ * runs the job on every worker, the calling thread being worker 0, and
+ * returns once all of them are done. The job must not throw.
  */
-typedef std::uint32_t BucketId;
-
-class GraceHashJoinOperator : public JoinOperator {
+class WorkerPool {
  private:
   /**
-   * Number of buckets
+   * Threads of workers 1 and up
    */
-  int numBuckets;
+  vector<thread> threads;
+
+  /**
+   * Job run by every worker in a round
+   */
+  function<void(int)> job;
+
+  /**
+   * Guards the round state and signals its start and its end
+   */
+  mutex lock;
+  condition_variable roundStarted;
+  condition_variable roundDone;
+
+  /**
+   * Number of rounds started
+   */
+  std::uint64_t round;
+
+  /**
+   * Number of threads still running the current round
+   */
+  int numBusyThreads;
+
+  /**
+   * Set when the threads are to exit
+   */
+  bool stopping;
 
   /**
-   * Hash function from key to bucket Id
+   * Thread of a worker: run the job once per round until stopped
    */
-  BucketId hash(const string& key) const;
+  void runThread(int worker);
 
  public:
   /**
    * Constructor
    */
-  GraceHashJoinOperator(File& leftTableFile,
-                        File& rightTableFile,
-                        const TableSchema& leftTableSchema,
-                        const TableSchema& rightTableSchema,
-                        const Catalog* catalog,
-                        BufMgr* bufMgr)
-      : JoinOperator(leftTableFile,
-                     rightTableFile,
-                     leftTableSchema,
-                     rightTableSchema,
-                     catalog,
-                     bufMgr) {
+  WorkerPool() : round(0), numBusyThreads(0), stopping(false) {
     // nothing
   }
 
+  /**
+   * Not copyable, the threads run on this pool
+   */
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
   /**
    * Destructor
    */
-  ~GraceHashJoinOperator() {
-    // nothing
-  }
+  ~WorkerPool() { stop(); }
 
   /**
-   * Get oprator's name (overrided)
+   * Start the threads of numWorkers workers running job, stopping those of
+   * a previous start
    */
-  string getOperatorName() const { return "GRACE_HASH_JOIN"; }
+  void start(int numWorkers, function<void(int)> job);
 
   /**
-   * Print running statistics (overrided)
+   * Run a round of the job on all workers and wait for them
    */
-  void printRunningStats() const {
-    JoinOperator::printRunningStats();
-    cout << "# Buckets: " << numBuckets << endl;
-  }
+  void run();
 
   /**
-   * Get number of buckets
+   * Stop and join the threads
    */
-  int getNumBuckets() const { return numBuckets; }
+  void stop();
+};
 
-  bool execute(int numAvailableBufPages, File& resultFile);
+/**
+ * Block nested-loop join scanning the inner input on worker threads. The
+ * outer blocks are loaded and hashed as by NestedLoopJoinOperator; the inner
+ * pages are then claimed in rounds by the workers of a pool, which probe the
+ * shared block and append their results to a file of their own, handed out
+ * by next() after the round. Every worker pins one inner page at a time and
+ * the tail page of its result file, so with W workers a block gets M - 2W
+ * pages.
+ */
+class ParallelNestedLoopJoinOperator : public NestedLoopJoinOperator {
+ private:
+  /**
+   * Statistics of a worker in the current round
+   */
+  struct WorkerOutput {
+    int numIOs;
+    exception_ptr error;
+  };
+
+  /**
+   * Own handles of the table files, the buffer pool frames are keyed by them
+   */
+  File leftFile;
+  File rightFile;
+
+  /**
+   * Number of workers asked for, and used in the current run
+   */
+  int numWorkers;
+  int numActiveWorkers;
+
+  /**
+   * Workers of the current run
+   */
+  WorkerPool workers;
+
+  /**
+   * Pages of the inner table
+   */
+  vector<PageId> innerPages;
+
+  /**
+   * First inner page of the next round
+   */
+  size_t nextInnerPage;
+
+  /**
+   * Next inner page to claim in the current round, and the end of the round
+   */
+  atomic<size_t> roundPage;
+  size_t roundEndPage;
+
+  /**
+   * Outputs of the workers in the last round
+   */
+  vector<WorkerOutput> outputs;
+
+  /**
+   * Result files of the last round, one per worker, each appended to by its
+   * worker only
+   */
+  PartitionFiles resultFiles;
+
+  /**
+   * Result file being scanned by next(), and its scan; the files before it
+   * are deleted
+   */
+  int resultFile;
+  unique_ptr<TableScanOperator> resultScan;
+
+  /**
+   * Join the current block with the next round of inner pages
+   */
+  void runRound();
+
+  /**
+   * Worker: probe the block with the inner pages claimed in the round
+   */
+  void probePages(int worker);
+
+ public:
+  /**
+   * Number of inner pages a round gives to each worker
+   */
+  static const int PAGES_PER_ROUND = 16;
+
+  /**
+   * Constructor
+   * @param numWorkers Number of worker threads, 0 for one per core
+   */
+  ParallelNestedLoopJoinOperator(File& leftTableFile,
+                                 File& rightTableFile,
+                                 const TableSchema& leftTableSchema,
+                                 const TableSchema& rightTableSchema,
+                                 const Catalog* catalog,
+                                 BufMgr* bufMgr,
+                                 int numWorkers = 0);
+
+  /**
+   * Destructor
+   */
+  ~ParallelNestedLoopJoinOperator() { close(); }
+
+  /**
+   * Get oprator's name (overrided)
+   */
+  string getOperatorName() const { return "PARALLEL_NESTED_LOOP_JOIN"; }
+
+  /**
+   * Get the number of workers of the last run
+   */
+  int getNumActiveWorkers() const { return numActiveWorkers; }
+
+  /**
+   * Start the workers and read the first block
+   * @throws BufferExceededException If there are less than 3 buffer pages
+   */
+  void open();
+
+  bool next(TupleView& tuple);
+
+  /**
+   * Stop the workers and delete the result files left
+   */
+  void close();
+};
+
+/**
+ * Bucket Id type
+ */
+typedef std::uint32_t BucketId;
+
+/**
+ * Nested-loop join probing a B+ tree index on the right table for every
+ * left tuple instead of scanning the right table. The left tuples are read
+ * in blocks; the matches of a block are sorted by record ID, so that every
+ * right page is read once per block.
+ */
+class IndexNestedLoopJoinOperator : public JoinOperator {
+ private:
+  /**
+   * A right tuple matching a left tuple of the block
+   */
+  struct Match {
+    RecordId rid;
+    int outer;
+  };
+
+  /**
+   * Right table file, the buffer pool frames are keyed by its address
+   */
+  File innerFile;
+
+  /**
+   * Index on a join attribute of the right table
+   */
+  BTreeIndex& innerIndex;
+
+  /**
+   * Join attribute of the index, as a position in leftKeyAttrs
+   */
+  int indexKeyAttr;
+
+  /**
+   * Left tuples of the current block, stored back to back, and where each
+   * of them starts; the last offset is the end of the block
+   */
+  string blockData;
+  vector<int> blockOffsets;
+
+  /**
+   * Join keys of the block, keyWidth bytes per left tuple
+   */
+  string blockKeys;
+
+  /**
+   * First left tuple of the next block, if it has been read already
+   */
+  string pendingTuple;
+  bool hasPendingTuple;
+
+  /**
+   * Join key of the current right tuple
+   */
+  string innerKey;
+
+  /**
+   * Right tuples matching the block by the index, in record ID order
+   */
+  vector<Match> matches;
+
+  /**
+   * Next match to join
+   */
+  size_t nextMatch;
+
+  /**
+   * Pinned right page, or null
+   */
+  Page* pinnedPage;
+
+  /**
+   * Number of index probes
+   */
+  int numProbes;
+
+  /**
+   * Find the position of the index attribute among the join attributes
+   * @throws BadIndexInfoException If the index is not on one
+   */
+  void bindIndex();
+
+  /**
+   * Read the next block of left tuples and probe the index for them
+   * @return False if the left input is used up
+   */
+  bool probeBlock();
+
+  /**
+   * Unpin the pinned right page
+   */
+  void releasePage();
+
+ public:
+  /**
+   * Constructor
+   * @param rightIndex Index on a join attribute of the right table
+   */
+  IndexNestedLoopJoinOperator(File& leftTableFile,
+                              File& rightTableFile,
+                              const TableSchema& leftTableSchema,
+                              const TableSchema& rightTableSchema,
+                              BTreeIndex& rightIndex,
+                              const Catalog* catalog,
+                              BufMgr* bufMgr);
+
+  /**
+   * Constructor, joining the output of an operator with a table
+   * @param rightIndex Index on a join attribute of the right table
+   */
+  IndexNestedLoopJoinOperator(unique_ptr<Operator> leftInput,
+                              File& rightTableFile,
+                              const TableSchema& rightTableSchema,
+                              BTreeIndex& rightIndex,
+                              const Catalog* catalog,
+                              BufMgr* bufMgr);
+
+  /**
+   * Destructor
+   */
+  ~IndexNestedLoopJoinOperator() { close(); }
+
+  /**
+   * Get oprator's name (overrided)
+   */
+  string getOperatorName() const { return "INDEX_NESTED_LOOP_JOIN"; }
+
+  /**
+   * Print running statistics (overrided)
+   */
+  void printRunningStats() const {
+    JoinOperator::printRunningStats();
+    cout << "# Index Probes: " << numProbes << endl;
+    cout << "# Index Height: " << innerIndex.getHeight() << endl;
+  }
+
+  /**
+   * Get the number of index probes
+   */
+  int getNumProbes() const { return numProbes; }
+
+  /**
+   * Read the first block of left tuples
+   * @throws BufferExceededException If there are less than 3 buffer pages
+   */
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close();
+};
+
+/**
+ * Grace hash join: both inputs are hashed into bucket files, then every
+ * pair of matching buckets is joined in one pass. Buckets too large for that
+ * are split again.
+ */
+class GraceHashJoinOperator : public JoinOperator {
+ private:
+  /**
+   * A pair of matching bucket files waiting to be joined
+   */
+  struct BucketPair {
+    string leftFilename;
+    string rightFilename;
+    int leftPages;
+    int rightPages;
+    int level;
+  };
+
+  /**
+   * Number of buckets
+   */
+  int numBuckets;
+
+  /**
+   * Bucket pairs still to be joined
+   */
+  vector<BucketPair> pendingPairs;
+
+  /**
+   * Bucket pair being joined
+   */
+  BucketPair currentPair;
+
+  /**
+   * Join of the current bucket pair, or null
+   */
+  unique_ptr<JoinOperator> currentJoin;
+
+  /**
+   * Join keys of the smaller input, filled while it is partitioned and
+   * applied while the other one is, so that most of its tuples without a
+   * match are never written to a bucket; disabled if no pages are spare
+   */
+  BloomFilter bloomFilter;
+
+  /**
+   * Number of buffer pages of the Bloom filter
+   */
+  int numFilterPages;
+
+  /**
+   * Number of tuples dropped by the Bloom filter
+   */
+  int numFilteredTuples;
+
+  /**
+   * Hashes of the keys known to be heavy hitters. When a pair is split
+   * again, their tuples go to a bucket of their own, which is joined
+   * without further splitting.
+   */
+  set<std::uint64_t> heavyHitters;
+
+  /**
+   * Heavy hitters found while the current pair is partitioned, added to
+   * heavyHitters once both of its inputs are, so that both are split the
+   * same way
+   */
+  vector<std::uint64_t> newHeavyHitters;
+
+  /**
+   * Number of tuples written to heavy hitter buckets
+   */
+  int numHeavyHitterTuples;
+
+  /**
+   * Hash the tuples of the left or right input into numBuckets new bucket
+   * files. When a pair is split again and heavy hitters are known, their
+   * tuples go to one more bucket, last, in place of a regular one if no page
+   * is spare. Keys found to be heavy are added to newHeavyHitters.
+   * @param buckets Receives the bucket files, closed
+   * @param insertInto If not null, receives the keys of the tuples
+   * @param filterBy If not null, only tuples whose keys it may contain are
+   *                 kept
+   * @return True if the last bucket holds the heavy hitters
+   */
+  bool partition(Operator& input,
+                 bool isLeft,
+                 int level,
+                 PartitionFiles& buckets,
+                 BloomFilter* insertInto = nullptr,
+                 const BloomFilter* filterBy = nullptr);
+
+  /**
+   * Partition both inputs and queue the pairs of non-empty buckets
+   * @param pairPages Pages of the smaller input, if it is a bucket split
+   *                  again. Buckets not smaller than that, and the bucket
+   *                  of heavy hitters, are not split any further.
+   */
+  void partitionPair(Operator& leftInput,
+                     Operator& rightInput,
+                     int level,
+                     int pairPages = 0);
+
+  /**
+   * Start joining the next bucket pair
+   * @return False if there are no pairs left
+   */
+  bool startNextPair();
+
+  /**
+   * Finish the current bucket pair and delete its files
+   */
+  void finishPair();
+
+ public:
+  /**
+   * Constructor
+   */
+  GraceHashJoinOperator(File& leftTableFile,
+                        File& rightTableFile,
+                        const TableSchema& leftTableSchema,
+                        const TableSchema& rightTableSchema,
+                        const Catalog* catalog,
+                        BufMgr* bufMgr)
+      : JoinOperator(leftTableFile,
+                     rightTableFile,
+                     leftTableSchema,
+                     rightTableSchema,
+                     catalog,
+                     bufMgr),
+        numBuckets(0),
+        numFilterPages(0),
+        numFilteredTuples(0),
+        numHeavyHitterTuples(0) {
+    // nothing
+  }
+
+  /**
+   * Constructor
+   */
+  GraceHashJoinOperator(unique_ptr<Operator> leftInput,
+                        unique_ptr<Operator> rightInput,
+                        const Catalog* catalog,
+                        BufMgr* bufMgr)
+      : JoinOperator(std::move(leftInput),
+                     std::move(rightInput),
+                     catalog,
+                     bufMgr),
+        numBuckets(0),
+        numFilterPages(0),
+        numFilteredTuples(0),
+        numHeavyHitterTuples(0) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  ~GraceHashJoinOperator() { close(); }
+
+  /**
+   * Get oprator's name (overrided)
+   */
+  string getOperatorName() const { return "GRACE_HASH_JOIN"; }
+
+  /**
+   * Print running statistics (overrided)
+   */
+  void printRunningStats() const {
+    JoinOperator::printRunningStats();
+    cout << "# Buckets: " << numBuckets << endl;
+    cout << "# Filtered Tuples: " << numFilteredTuples << endl;
+    cout << "# Heavy Hitters: " << heavyHitters.size() << " ("
+         << numHeavyHitterTuples << " tuples)" << endl;
+  }
+
+  /**
+   * Get the number of tuples dropped by the Bloom filter
+   */
+  int getNumFilteredTuples() const { return numFilteredTuples; }
+
+  /**
+   * Get the number of heavy hitters found
+   */
+  int getNumHeavyHitters() const { return heavyHitters.size(); }
+
+  /**
+   * Get the number of tuples written to heavy hitter buckets
+   */
+  int getNumHeavyHitterTuples() const { return numHeavyHitterTuples; }
+
+  /**
+   * A key is a heavy hitter if its tuples in one input fill at least
+   * 1 / HEAVY_HITTER_SHARE of the memory
+   */
+  static const int HEAVY_HITTER_SHARE = 2;
+
+  /**
+   * Pages of the smaller input per Bloom filter page; with tuples of 20
+   * bytes, this gives about 12 bits per tuple
+   */
+  static const int INPUT_PAGES_PER_FILTER_PAGE = 16;
+
+  /**
+   * Get number of buckets
+   */
+  int getNumBuckets() const { return numBuckets; }
+
+  /**
+   * Get number of I/Os carried out by the executor, including the inputs
+   */
+  int getNumIOs() const {
+    return JoinOperator::getNumIOs() +
+           (currentJoin != nullptr ? currentJoin->getNumIOs() : 0);
+  }
+
+  /**
+   * Partition both inputs
+   * @throws BufferExceededException If there are less than 3 buffer pages
+   */
+  void open();
+
+  bool next(TupleView& tuple);
+
+  /**
+   * Delete the bucket files left
+   */
+  void close();
+};
+
+/**
+ * Hash join that starts as a one-pass join and turns into a partitioned
+ * (Grace) join if the smaller input does not fit in memory after all, e.g.
+ * because the statistics were wrong. The tuples read so far are then
+ * spilled to bucket files by hash partition and the rest of the input
+ * follows them, so nothing is read twice. Bucket pairs are joined by
+ * adaptive joins again, one level deeper.
+ */
+class AdaptiveHashJoinOperator : public OnePassJoinOperator {
+ private:
+  /**
+   * A pair of matching bucket files waiting to be joined
+   */
+  struct BucketPair {
+    string leftFilename;
+    string rightFilename;
+    int leftPages;
+    int rightPages;
+  };
+
+  /**
+   * Partitioning level: 0, or the number of partitionings the inputs went
+   * through
+   */
+  int level;
+
+  /**
+   * Has the join switched to partitioned mode?
+   */
+  bool partitioned;
+
+  /**
+   * Tuples and pages of the smaller input in memory when the join switched
+   */
+  int switchTuples;
+  int switchPages;
+
+  /**
+   * Number of buckets in partitioned mode
+   */
+  int numBuckets;
+
+  /**
+   * Bucket pairs still to be joined
+   */
+  vector<BucketPair> pendingPairs;
+
+  /**
+   * Bucket pair being joined
+   */
+  BucketPair currentPair;
+
+  /**
+   * Join of the current bucket pair, or null
+   */
+  unique_ptr<JoinOperator> currentJoin;
+
+  /**
+   * Bucket of a join key at this level
+   */
+  BucketId bucketOf(const std::uint32_t* key) const;
+
+  /**
+   * Append the tuples of an open input to the buckets of their keys
+   * @param first Tuple to append before the input, or null
+   */
+  void partitionInto(Operator& input,
+                     bool isLeft,
+                     const TupleView* first,
+                     PartitionFiles& buckets);
+
+  /**
+   * Spill the tuples in memory and partition the rest of both inputs
+   * @param overflow First tuple of the smaller input not in memory
+   */
+  void switchToPartitioned(Operator& buildInput, const TupleView& overflow);
+
+  /**
+   * Start joining the next bucket pair
+   * @return False if there are no pairs left
+   */
+  bool startNextPair();
+
+  /**
+   * Finish the current bucket pair and delete its files
+   */
+  void finishPair();
+
+ public:
+  /**
+   * Constructor
+   */
+  AdaptiveHashJoinOperator(File& leftTableFile,
+                           File& rightTableFile,
+                           const TableSchema& leftTableSchema,
+                           const TableSchema& rightTableSchema,
+                           const Catalog* catalog,
+                           BufMgr* bufMgr)
+      : OnePassJoinOperator(leftTableFile,
+                            rightTableFile,
+                            leftTableSchema,
+                            rightTableSchema,
+                            catalog,
+                            bufMgr),
+        level(0),
+        partitioned(false),
+        switchTuples(0),
+        switchPages(0),
+        numBuckets(0) {
+    // nothing
+  }
+
+  /**
+   * Constructor
+   * @param level Partitioning level of the inputs
+   */
+  AdaptiveHashJoinOperator(unique_ptr<Operator> leftInput,
+                           unique_ptr<Operator> rightInput,
+                           const Catalog* catalog,
+                           BufMgr* bufMgr,
+                           int level = 0)
+      : OnePassJoinOperator(std::move(leftInput),
+                            std::move(rightInput),
+                            catalog,
+                            bufMgr),
+        level(level),
+        partitioned(false),
+        switchTuples(0),
+        switchPages(0),
+        numBuckets(0) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  ~AdaptiveHashJoinOperator() { close(); }
+
+  /**
+   * Get oprator's name (overrided)
+   */
+  string getOperatorName() const { return "ADAPTIVE_HASH_JOIN"; }
+
+  /**
+   * Print running statistics (overrided)
+   */
+  void printRunningStats() const {
+    JoinOperator::printRunningStats();
+    if (partitioned) {
+      cout << "# Switched To Partitioned Mode After: " << switchTuples
+           << " tuples (" << switchPages << " pages)" << endl;
+      cout << "# Buckets: " << numBuckets << endl;
+    } else {
+      cout << "# Mode: One-Pass" << endl;
+      cout << "# Filtered Tuples: " << numFilteredTuples << endl;
+    }
+  }
+
+  /**
+   * Has the last run switched to partitioned mode?
+   */
+  bool isPartitioned() const { return partitioned; }
+
+  /**
+   * Get the number of tuples of the smaller input in memory when the last
+   * run switched to partitioned mode
+   */
+  int getSwitchTuples() const { return switchTuples; }
+
+  /**
+   * Get number of I/Os carried out by the executor, including the inputs
+   */
+  int getNumIOs() const {
+    return JoinOperator::getNumIOs() +
+           (currentJoin != nullptr ? currentJoin->getNumIOs() : 0);
+  }
+
+  /**
+   * Read the smaller input into memory, or partition both inputs if it does
+   * not fit
+   * @throws BufferExceededException If there are less than 3 buffer pages
+   */
+  void open();
+
+  bool next(TupleView& tuple);
+
+  /**
+   * Delete the bucket files left
+   */
+  void close();
+};
+
+/**
+ * Grace hash join run as tasks on a work-stealing pool of worker threads.
+ * Partitioning splits the inputs into page ranges, whose tuples are hashed
+ * into shared bucket files. Every pair of matching buckets is then a task,
+ * joined in one pass or, if too large for the memory of a worker, split into
+ * smaller bucket pairs which become new tasks. A worker owns 1/W of the
+ * buffer pages during the join, one of them the tail page of its result
+ * file, so W workers never use more than M pages. The result files are
+ * scanned back by next() one page at a time.
+ */
+class ParallelGraceHashJoinOperator : public JoinOperator {
+ private:
+  /**
+   * A pair of matching bucket files waiting to be joined
+   */
+  struct BucketPair {
+    string leftFilename;
+    string rightFilename;
+    int leftPages;
+    int rightPages;
+    int level;
+  };
+
+  /**
+   * Bucket files being written by a partitioning step. The appender of a
+   * bucket is shared by the workers, one at a time.
+   */
+  struct BucketSet {
+    PartitionFiles files;
+    unique_ptr<mutex[]> locks;
+
+    explicit BucketSet(BufMgr* bufMgr) : files(bufMgr) {
+      // nothing
+    }
+  };
+
+  /**
+   * A unit of work; its size (in pages) orders the tasks of a queue
+   */
+  struct Task {
+    int pages;
+    function<void(int)> run;
+  };
+
+  /**
+   * Tasks of a worker, the largest at the front. Its owner and the thieves
+   * all take tasks from the front.
+   */
+  struct TaskQueue {
+    mutex lock;
+    deque<Task> tasks;
+  };
+
+  /**
+   * Statistics of a worker
+   */
+  struct WorkerOutput {
+    int numIOs;
+    int numUsedBufPages;
+    int numFilteredTuples;
+    exception_ptr error;
+  };
+
+  /**
+   * Own handles of the table files, the buffer pool frames are keyed by them
+   */
+  File leftFile;
+  File rightFile;
+
+  /**
+   * Number of workers asked for, and used in the current run
+   */
+  int numWorkers;
+  int numActiveWorkers;
+
+  /**
+   * Buffer pages of a worker while joining bucket pairs, including the tail
+   * page of its result file
+   */
+  int workerBufPages;
+
+  /**
+   * Number of buckets of the first partitioning
+   */
+  int numBuckets;
+
+  /**
+   * Bloom filter on the keys of the smaller input, one per worker while it
+   * is partitioned; they are then merged into the first one, which filters
+   * the other input
+   */
+  vector<BloomFilter> bloomFilters;
+
+  /**
+   * Number of buffer pages of a Bloom filter
+   */
+  int numFilterPages;
+
+  /**
+   * Number of tuples dropped by the Bloom filter
+   */
+  int numFilteredTuples;
+
+  /**
+   * Bucket pairs left by the partitioning, joined on the first call to next()
+   */
+  vector<BucketPair> initialPairs;
+
+  /**
+   * Have the bucket pairs been joined?
+   */
+  bool joined;
+
+  /**
+   * Queue of every worker
+   */
+  vector<unique_ptr<TaskQueue>> queues;
+
+  /**
+   * Tasks queued or running
+   */
+  atomic<int> numPendingTasks;
+
+  /**
+   * Set when a task failed; the tasks left are then dropped
+   */
+  atomic<bool> failed;
+
+  /**
+   * Outputs of the workers
+   */
+  vector<WorkerOutput> outputs;
+
+  /**
+   * Result files, one per worker, each appended to by its worker only
+   */
+  BucketSet resultBuckets;
+
+  /**
+   * Result file being scanned by next(), and its scan
+   */
+  int resultFile;
+  unique_ptr<TableScanOperator> resultScan;
+
+  /**
+   * Partition files not deleted yet, removed by close() if left over
+   */
+  set<string> partitionFiles;
+  mutex partitionFilesLock;
+
+  /**
+   * Create numBuckets new bucket files, deleted by close() if left over
+   */
+  void createBuckets(int numBuckets, BucketSet& buckets);
+
+  /**
+   * Delete a partition file
+   */
+  void removePartitionFile(const string& filename);
+
+  /**
+   * Hash the tuples on some pages of a left or right file into a set of
+   * buckets, pinning one input page at a time
+   * @param insertInto If not null, receives the keys of the tuples
+   * @param filterBy If not null, only tuples whose keys it may contain are
+   *                 kept
+   */
+  void partitionPages(int worker,
+                      File& file,
+                      const vector<PageId>& pages,
+                      bool isLeft,
+                      int level,
+                      BucketSet& buckets,
+                      BloomFilter* insertInto = nullptr,
+                      const BloomFilter* filterBy = nullptr);
+
+  /**
+   * Worker: join a bucket pair into the result file of the worker, or split
+   * it into new tasks
+   */
+  void joinPair(int worker, const BucketPair& pair);
+
+  /**
+   * Queue a task on the queue of a worker, in order of size
+   */
+  void pushTask(int worker, Task task);
+
+  /**
+   * Take a task from the own queue, or else steal one from another worker
+   */
+  bool takeTask(int worker, Task& task);
+
+  /**
+   * Worker: run tasks until none are left
+   */
+  void runWorker(int worker);
+
+  /**
+   * Run tasks on the workers and wait until they and the tasks they queue
+   * are done
+   */
+  void runTasks(vector<Task> tasks);
+
+ public:
+  /**
+   * Number of input pages of a partitioning task
+   */
+  static const int PAGES_PER_TASK = 16;
+
+  /**
+   * Constructor
+   * @param numWorkers Number of worker threads, 0 for one per core
+   */
+  ParallelGraceHashJoinOperator(File& leftTableFile,
+                                File& rightTableFile,
+                                const TableSchema& leftTableSchema,
+                                const TableSchema& rightTableSchema,
+                                const Catalog* catalog,
+                                BufMgr* bufMgr,
+                                int numWorkers = 0);
+
+  /**
+   * Destructor
+   */
+  ~ParallelGraceHashJoinOperator() { close(); }
+
+  /**
+   * Get oprator's name (overrided)
+   */
+  string getOperatorName() const { return "PARALLEL_GRACE_HASH_JOIN"; }
+
+  /**
+   * Print running statistics (overrided)
+   */
+  void printRunningStats() const {
+    JoinOperator::printRunningStats();
+    cout << "# Buckets: " << numBuckets << endl;
+    cout << "# Workers: " << numActiveWorkers << endl;
+    cout << "# Filtered Tuples: " << numFilteredTuples << endl;
+  }
+
+  /**
+   * Get the number of tuples dropped by the Bloom filter
+   */
+  int getNumFilteredTuples() const { return numFilteredTuples; }
+
+  /**
+   * Get number of buckets of the first partitioning
+   */
+  int getNumBuckets() const { return numBuckets; }
+
+  /**
+   * Get the number of workers of the last run
+   */
+  int getNumActiveWorkers() const { return numActiveWorkers; }
+
+  /**
+   * Partition both inputs
+   * @throws BufferExceededException If there are less than 4 buffer pages
+   */
+  void open();
+
+  bool next(TupleView& tuple);
+
+  /**
+   * Delete the bucket and result files left
+   */
+  void close();
 };
 
-}  // namespace badgerdb
\ No newline at end of file
+}  // namespace badgerdb
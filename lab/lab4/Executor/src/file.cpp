@@ -25,6 +25,7 @@ namespace badgerdb {
 
 File::StreamMap File::open_streams_;
 File::CountMap File::open_counts_;
+std::mutex File::registry_mutex_;
 
 File File::create(const std::string& filename) {
   return File(filename, true /* create_new */);
@@ -38,7 +39,8 @@ void File::remove(const std::string& filename) {
   if (!exists(filename)) {
     throw FileNotFoundException(filename);
   }
-  if (isOpen(filename)) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  if (open_counts_.find(filename) != open_counts_.end()) {
     throw FileOpenException(filename);
   }
   std::remove(filename.c_str());
@@ -48,6 +50,7 @@ bool File::isOpen(const std::string& filename) {
   if (!exists(filename)) {
     return false;
   }
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   return open_counts_.find(filename) != open_counts_.end();
 }
 
@@ -63,8 +66,9 @@ bool File::exists(const std::string& filename) {
 }
 
 File::File(const File& other)
-  : filename_(other.filename_),
-    stream_(open_streams_[filename_]) {
+  : filename_(other.filename_) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  stream_ = open_streams_[filename_];
   ++open_counts_[filename_];
 }
 
@@ -232,6 +236,7 @@ File::File(const std::string& name, const bool create_new) : filename_(name) {
 }
 
 void File::openIfNeeded(const bool create_new) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   if (open_counts_.find(filename_) != open_counts_.end()) {	//exists an entry already
     ++open_counts_[filename_];
     stream_ = open_streams_[filename_];
@@ -259,6 +264,7 @@ void File::openIfNeeded(const bool create_new) {
 }
 
 void File::close() {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   --open_counts_[filename_];
   stream_.reset();
   if (open_counts_[filename_] == 0) {
@@ -11,6 +11,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
 
 #include "page.h"
 
@@ -315,6 +316,12 @@ namespace badgerdb {
          */
         static CountMap open_counts_;
 
+        /**
+         * Guards open_streams_ and open_counts_, so that threads can open and
+         * close files.
+         */
+        static std::mutex registry_mutex_;
+
         /**
          * Name of the file this object represents.
          */
@@ -0,0 +1,538 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "hash_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "exceptions/bad_index_info_exception.h"
+#include "file_iterator.h"
+#include "index_page.h"
+#include "page_iterator.h"
+#include "predicate.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Marks the meta page of an index file
+ */
+static const std::uint32_t META_MAGIC = 0x45584849;  // "EXHI"
+
+/**
+ * Bytes of the meta record: magic, attribute type, key width, global depth,
+ * number of buckets, first directory page, number of entries and first free
+ * page
+ */
+static const int META_BYTES = 36;
+
+/**
+ * Bytes of a record ID in an entry
+ */
+static const int RID_BYTES = 6;
+
+/**
+ * Bytes of a directory page header: next directory page and number of slots
+ */
+static const int DIRECTORY_HEADER_BYTES = 8;
+
+/**
+ * Directory slots of a directory page
+ */
+static const int DIRECTORY_PAGE_SLOTS =
+    (ExtendibleHashIndex::BUCKET_BYTES - DIRECTORY_HEADER_BYTES) /
+    sizeof(PageId);
+
+static int getLocalDepth(const char* bucket) {
+  std::uint16_t depth;
+  memcpy(&depth, bucket, sizeof(depth));
+  return depth;
+}
+
+/**
+ * First entry of a bucket page whose first bytes are not below those of key
+ */
+static int lowerBound(const char* bucket,
+                      int width,
+                      const char* key,
+                      int bytes) {
+  const char* entries = bucket + ExtendibleHashIndex::BUCKET_HEADER_BYTES;
+  int low = 0, high = IndexPage::getCount(bucket);
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (memcmp(entries + (size_t)mid * width, key, bytes) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+ExtendibleHashIndex::ExtendibleHashIndex(const string& indexFilename,
+                                         const TableSchema& tableSchema,
+                                         const string& attrName,
+                                         BufMgr* bufMgr)
+    : file(File::exists(indexFilename) ? File::open(indexFilename)
+                                       : File::create(indexFilename)),
+      bufMgr(bufMgr),
+      layout(tableSchema),
+      attrNum(tableSchema.getAttrNum(attrName)),
+      attrType(tableSchema.getAttrType(attrNum)),
+      tableSchema(tableSchema),
+      keyWidth(layout.getNormalizedWidth(attrNum)),
+      entryWidth(keyWidth + RID_BYTES),
+      bucketCapacity((BUCKET_BYTES - BUCKET_HEADER_BYTES) / entryWidth),
+      metaPageNumber(Page::INVALID_NUMBER),
+      globalDepth(0),
+      directoryDirty(false),
+      freeListHead(Page::INVALID_NUMBER),
+      numBuckets(0),
+      numEntries(0),
+      numPageReads(0) {
+  metaPageNumber = file.begin().page_number();
+  if (metaPageNumber != Page::INVALID_NUMBER) {
+    readMeta();
+    return;
+  }
+  // a new index: the meta page, then a single empty bucket
+  Page* page;
+  bufMgr->allocPage(&file, metaPageNumber, page);
+  page->insertRecord(string(META_BYTES, '\0'));
+  bufMgr->unPinPage(&file, metaPageNumber, true);
+  directory.push_back(takePage());
+  writeRecord(directory[0], emptyBucket(0));
+  numBuckets = 1;
+  directoryDirty = true;
+  writeDirectory();
+  writeMeta();
+}
+
+ExtendibleHashIndex::~ExtendibleHashIndex() {
+  flush();
+}
+
+string ExtendibleHashIndex::makeEntry(const string& key,
+                                      const RecordId& rid) const {
+  string entry = key;
+  entry.resize(keyWidth, '\0');
+  entry.append((const char*)&rid.page_number, sizeof(rid.page_number));
+  entry.append((const char*)&rid.slot_number, sizeof(rid.slot_number));
+  return entry;
+}
+
+RecordId ExtendibleHashIndex::entryRecordId(const char* entry, int keyWidth) {
+  RecordId rid;
+  memcpy(&rid.page_number, entry + keyWidth, sizeof(rid.page_number));
+  memcpy(&rid.slot_number, entry + keyWidth + sizeof(rid.page_number),
+         sizeof(rid.slot_number));
+  return rid;
+}
+
+std::uint32_t ExtendibleHashIndex::hashKey(const char* key) const {
+  std::uint64_t hash = 0x9e3779b97f4a7c15ULL;
+  for (int i = 0; i < keyWidth; i += sizeof(std::uint64_t)) {
+    std::uint64_t word = 0;
+    memcpy(&word, key + i, min<int>(sizeof(word), keyWidth - i));
+    hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 32;
+  }
+  // the directory takes the low bits, mix the high ones into them
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  return (std::uint32_t)(hash ^ (hash >> 29));
+}
+
+void ExtendibleHashIndex::readBucket(PageId pageNumber, string& bucket) {
+  Page* page;
+  bufMgr->readPage(&file, pageNumber, page);
+  std::uint16_t length;
+  const char* data = page->getRecordData({pageNumber, 1}, length);
+  bucket.assign(data, length);
+  bufMgr->unPinPage(&file, pageNumber, false);
+  numPageReads++;
+}
+
+void ExtendibleHashIndex::writeRecord(PageId pageNumber,
+                                      const string& record) {
+  Page* page;
+  bufMgr->readPage(&file, pageNumber, page);
+  if ((int)record.size() == BUCKET_BYTES) {
+    page->updateRecord({pageNumber, 1}, record);
+  } else {
+    string padded = record;
+    padded.resize(BUCKET_BYTES, '\0');
+    page->updateRecord({pageNumber, 1}, padded);
+  }
+  bufMgr->unPinPage(&file, pageNumber, true);
+}
+
+PageId ExtendibleHashIndex::allocatePage() {
+  PageId pageNumber;
+  Page* page;
+  bufMgr->allocPage(&file, pageNumber, page);
+  page->insertRecord(string(BUCKET_BYTES, '\0'));
+  bufMgr->unPinPage(&file, pageNumber, true);
+  return pageNumber;
+}
+
+PageId ExtendibleHashIndex::takePage() {
+  if (freeListHead == Page::INVALID_NUMBER)
+    return allocatePage();
+  PageId pageNumber = freeListHead;
+  string bucket;
+  readBucket(pageNumber, bucket);
+  freeListHead = IndexPage::getLink(bucket.data());
+  return pageNumber;
+}
+
+void ExtendibleHashIndex::freePage(PageId pageNumber) {
+  string bucket = emptyBucket(0);
+  IndexPage::setLink(bucket, freeListHead);
+  writeRecord(pageNumber, bucket);
+  freeListHead = pageNumber;
+}
+
+string ExtendibleHashIndex::emptyBucket(int localDepth) const {
+  string bucket(BUCKET_BYTES, '\0');
+  std::uint16_t depth = localDepth;
+  memcpy(&bucket[0], &depth, sizeof(depth));
+  IndexPage::setLink(bucket, Page::INVALID_NUMBER);
+  return bucket;
+}
+
+void ExtendibleHashIndex::writeChain(PageId firstPage,
+                                     const vector<string>& entries,
+                                     int localDepth) {
+  PageId page_number = firstPage;
+  size_t done = 0;
+  while (true) {
+    string bucket = emptyBucket(localDepth);
+    int count = min<size_t>(bucketCapacity, entries.size() - done);
+    for (int i = 0; i < count; ++i) {
+      bucket.replace(BUCKET_HEADER_BYTES + (size_t)i * entryWidth, entryWidth,
+                     entries[done + i]);
+    }
+    IndexPage::setCount(bucket, count);
+    done += count;
+    if (done == entries.size()) {
+      writeRecord(page_number, bucket);
+      return;
+    }
+    PageId next_page = takePage();
+    IndexPage::setLink(bucket, next_page);
+    writeRecord(page_number, bucket);
+    page_number = next_page;
+  }
+}
+
+void ExtendibleHashIndex::split(std::uint32_t slot) {
+  // gather the entries of the whole chain, its overflow pages become free
+  PageId primary = directory[slot];
+  vector<string> entries;
+  string bucket;
+  readBucket(primary, bucket);
+  int depth = getLocalDepth(bucket.data());
+  while (true) {
+    for (int i = 0; i < IndexPage::getCount(bucket.data()); ++i) {
+      entries.push_back(bucket.substr(
+          BUCKET_HEADER_BYTES + (size_t)i * entryWidth, entryWidth));
+    }
+    PageId next = IndexPage::getLink(bucket.data());
+    if (next == Page::INVALID_NUMBER)
+      break;
+    readBucket(next, bucket);
+    freePage(next);
+  }
+
+  if (depth == globalDepth) {
+    // the new half of the directory points to the same buckets
+    size_t size = directory.size();
+    directory.resize(size * 2);
+    copy(directory.begin(), directory.begin() + size,
+         directory.begin() + size);
+    globalDepth++;
+  }
+
+  // overflow pages are only sorted one by one
+  sort(entries.begin(), entries.end());
+  const std::uint32_t bit = 1u << depth;
+  vector<string> low, high;
+  for (const string& entry : entries) {
+    if (hashKey(entry.data()) & bit)
+      high.push_back(entry);
+    else
+      low.push_back(entry);
+  }
+  PageId high_page = takePage();
+  writeChain(primary, low, depth + 1);
+  writeChain(high_page, high, depth + 1);
+
+  // the slots of the bucket with the new bit set move to the new one
+  for (std::uint32_t i = (slot & (bit - 1)) | bit; i < directory.size();
+       i += bit * 2) {
+    directory[i] = high_page;
+  }
+  numBuckets++;
+  directoryDirty = true;
+}
+
+void ExtendibleHashIndex::writeMeta() {
+  string meta(META_BYTES, '\0');
+  IndexPage::writeWord(&meta[0], META_MAGIC);
+  IndexPage::writeWord(&meta[4], attrType);
+  IndexPage::writeWord(&meta[8], keyWidth);
+  IndexPage::writeWord(&meta[12], globalDepth);
+  IndexPage::writeWord(&meta[16], numBuckets);
+  IndexPage::writeWord(&meta[20], directoryPages[0]);
+  memcpy(&meta[24], &numEntries, sizeof(numEntries));
+  IndexPage::writeWord(&meta[32], freeListHead);
+  Page* page;
+  bufMgr->readPage(&file, metaPageNumber, page);
+  page->updateRecord({metaPageNumber, 1}, meta);
+  bufMgr->unPinPage(&file, metaPageNumber, true);
+}
+
+void ExtendibleHashIndex::readMeta() {
+  Page* page;
+  bufMgr->readPage(&file, metaPageNumber, page);
+  std::uint16_t length;
+  const char* meta = page->getRecordData({metaPageNumber, 1}, length);
+  bool is_index =
+      length == META_BYTES && IndexPage::readWord(meta) == META_MAGIC;
+  std::uint32_t type = is_index ? IndexPage::readWord(meta + 4) : 0;
+  std::uint32_t width = is_index ? IndexPage::readWord(meta + 8) : 0;
+  PageId directory_page = Page::INVALID_NUMBER;
+  if (is_index) {
+    globalDepth = IndexPage::readWord(meta + 12);
+    numBuckets = IndexPage::readWord(meta + 16);
+    directory_page = IndexPage::readWord(meta + 20);
+    memcpy(&numEntries, meta + 24, sizeof(numEntries));
+    freeListHead = IndexPage::readWord(meta + 32);
+  }
+  bufMgr->unPinPage(&file, metaPageNumber, false);
+  if (!is_index)
+    throw BadIndexInfoException(file.filename(),
+                                "not an extendible hash index");
+  if (type != (std::uint32_t)attrType || (int)width != keyWidth)
+    throw BadIndexInfoException(file.filename(),
+                                "indexes another attribute type or width");
+
+  while (directory_page != Page::INVALID_NUMBER) {
+    directoryPages.push_back(directory_page);
+    bufMgr->readPage(&file, directory_page, page);
+    const char* record = page->getRecordData({directory_page, 1}, length);
+    PageId next = IndexPage::readWord(record);
+    std::uint32_t num_slots = IndexPage::readWord(record + 4);
+    for (std::uint32_t i = 0; i < num_slots; ++i) {
+      directory.push_back(IndexPage::readWord(
+          record + DIRECTORY_HEADER_BYTES + i * sizeof(PageId)));
+    }
+    bufMgr->unPinPage(&file, directory_page, false);
+    directory_page = next;
+  }
+}
+
+void ExtendibleHashIndex::writeDirectory() {
+  size_t num_pages =
+      (directory.size() + DIRECTORY_PAGE_SLOTS - 1) / DIRECTORY_PAGE_SLOTS;
+  while (directoryPages.size() < num_pages) {
+    directoryPages.push_back(allocatePage());
+  }
+  for (size_t p = 0; p < num_pages; ++p) {
+    size_t first = p * DIRECTORY_PAGE_SLOTS;
+    size_t num_slots = min<size_t>(DIRECTORY_PAGE_SLOTS,
+                                   directory.size() - first);
+    string record(DIRECTORY_HEADER_BYTES + num_slots * sizeof(PageId), '\0');
+    IndexPage::writeWord(&record[0], p + 1 < num_pages
+                                         ? directoryPages[p + 1]
+                                         : Page::INVALID_NUMBER);
+    IndexPage::writeWord(&record[4], num_slots);
+    memcpy(&record[DIRECTORY_HEADER_BYTES], &directory[first],
+           num_slots * sizeof(PageId));
+    writeRecord(directoryPages[p], record);
+  }
+  directoryDirty = false;
+}
+
+string ExtendibleHashIndex::getKey(const char* tuple) const {
+  string key;
+  layout.appendNormalized(tuple, layout.locate(tuple, attrNum), attrNum, key);
+  return key;
+}
+
+string ExtendibleHashIndex::makeKey(const string& value) const {
+  return Predicate::makeKey(tableSchema, attrNum, value);
+}
+
+void ExtendibleHashIndex::addEntry(PageId pageNumber,
+                                   string& bucket,
+                                   const string& entry) {
+  int count = IndexPage::getCount(bucket.data());
+  int pos = lowerBound(bucket.data(), entryWidth, entry.data(), entryWidth);
+  bucket.insert(BUCKET_HEADER_BYTES + (size_t)pos * entryWidth, entry);
+  bucket.resize(BUCKET_BYTES);
+  IndexPage::setCount(bucket, count + 1);
+  writeRecord(pageNumber, bucket);
+  numEntries++;
+}
+
+void ExtendibleHashIndex::insert(const string& key, const RecordId& rid) {
+  string entry = makeEntry(key, rid);
+  const std::uint32_t hash = hashKey(entry.data());
+  const std::uint32_t split_mask = (1u << MAX_GLOBAL_DEPTH) - 1;
+  string bucket;
+  while (true) {
+    std::uint32_t slot = hash & ((1u << globalDepth) - 1);
+    PageId page_number = directory[slot];
+    readBucket(page_number, bucket);
+    int count = IndexPage::getCount(bucket.data());
+    if (count < bucketCapacity) {
+      addEntry(page_number, bucket, entry);
+      return;
+    }
+
+    // split, unless the entries agree with this one on every bit a split
+    // could use; then a bucket with overflow pages holds no other hashes
+    bool can_split = false;
+    if (getLocalDepth(bucket.data()) < MAX_GLOBAL_DEPTH) {
+      for (int i = 0; i < count && !can_split; ++i) {
+        const char* other =
+            bucket.data() + BUCKET_HEADER_BYTES + (size_t)i * entryWidth;
+        can_split = ((hashKey(other) ^ hash) & split_mask) != 0;
+      }
+    }
+    if (can_split) {
+      split(slot);
+      continue;
+    }
+
+    // the first overflow page with room, or a new one at the end
+    while (IndexPage::getLink(bucket.data()) != Page::INVALID_NUMBER) {
+      page_number = IndexPage::getLink(bucket.data());
+      readBucket(page_number, bucket);
+      count = IndexPage::getCount(bucket.data());
+      if (count < bucketCapacity) {
+        addEntry(page_number, bucket, entry);
+        return;
+      }
+    }
+    PageId overflow_page = takePage();
+    string overflow = emptyBucket(getLocalDepth(bucket.data()));
+    overflow.replace(BUCKET_HEADER_BYTES, entryWidth, entry);
+    IndexPage::setCount(overflow, 1);
+    writeRecord(overflow_page, overflow);
+    IndexPage::setLink(bucket, overflow_page);
+    writeRecord(page_number, bucket);
+    numEntries++;
+    return;
+  }
+}
+
+bool ExtendibleHashIndex::remove(const string& key, const RecordId& rid) {
+  string entry = makeEntry(key, rid);
+  PageId page_number =
+      directory[hashKey(entry.data()) & ((1u << globalDepth) - 1)];
+  string bucket;
+  while (page_number != Page::INVALID_NUMBER) {
+    readBucket(page_number, bucket);
+    int count = IndexPage::getCount(bucket.data());
+    int pos = lowerBound(bucket.data(), entryWidth, entry.data(), entryWidth);
+    size_t offset = BUCKET_HEADER_BYTES + (size_t)pos * entryWidth;
+    if (pos < count &&
+        memcmp(bucket.data() + offset, entry.data(), entryWidth) == 0) {
+      bucket.erase(offset, entryWidth);
+      IndexPage::setCount(bucket, count - 1);
+      writeRecord(page_number, bucket);
+      numEntries--;
+      return true;
+    }
+    page_number = IndexPage::getLink(bucket.data());
+  }
+  return false;
+}
+
+bool ExtendibleHashIndex::lookup(const string& key, RecordId& rid) {
+  string padded = key;
+  padded.resize(keyWidth, '\0');
+  PageId page_number =
+      directory[hashKey(padded.data()) & ((1u << globalDepth) - 1)];
+  while (page_number != Page::INVALID_NUMBER) {
+    Page* page;
+    bufMgr->readPage(&file, page_number, page);
+    std::uint16_t length;
+    const char* bucket = page->getRecordData({page_number, 1}, length);
+    numPageReads++;
+    int pos = lowerBound(bucket, entryWidth, padded.data(), keyWidth);
+    const char* entry =
+        bucket + BUCKET_HEADER_BYTES + (size_t)pos * entryWidth;
+    if (pos < IndexPage::getCount(bucket) &&
+        memcmp(entry, padded.data(), keyWidth) == 0) {
+      rid = entryRecordId(entry, keyWidth);
+      bufMgr->unPinPage(&file, page_number, false);
+      return true;
+    }
+    PageId next = IndexPage::getLink(bucket);
+    bufMgr->unPinPage(&file, page_number, false);
+    page_number = next;
+  }
+  return false;
+}
+
+int ExtendibleHashIndex::lookupAll(const string& key, vector<RecordId>& rids) {
+  string padded = key;
+  padded.resize(keyWidth, '\0');
+  PageId page_number =
+      directory[hashKey(padded.data()) & ((1u << globalDepth) - 1)];
+  int num_found = 0;
+  while (page_number != Page::INVALID_NUMBER) {
+    Page* page;
+    bufMgr->readPage(&file, page_number, page);
+    std::uint16_t length;
+    const char* bucket = page->getRecordData({page_number, 1}, length);
+    numPageReads++;
+    int count = IndexPage::getCount(bucket);
+    for (int pos = lowerBound(bucket, entryWidth, padded.data(), keyWidth);
+         pos < count; ++pos) {
+      const char* entry =
+          bucket + BUCKET_HEADER_BYTES + (size_t)pos * entryWidth;
+      if (memcmp(entry, padded.data(), keyWidth) != 0)
+        break;
+      rids.push_back(entryRecordId(entry, keyWidth));
+      num_found++;
+    }
+    PageId next = IndexPage::getLink(bucket);
+    bufMgr->unPinPage(&file, page_number, false);
+    page_number = next;
+  }
+  return num_found;
+}
+
+void ExtendibleHashIndex::loadTable(File& tableFile) {
+  for (FileIterator iter = tableFile.begin();
+       iter.page_number() != Page::INVALID_NUMBER; ++iter) {
+    PageId page_number = iter.page_number();
+    Page* page;
+    bufMgr->readPage(&tableFile, page_number, page);
+    PageIterator records(page);
+    for (SlotId slot = records.getNextUsedSlot(Page::INVALID_SLOT);
+         slot != Page::INVALID_SLOT; slot = records.getNextUsedSlot(slot)) {
+      std::uint16_t length;
+      const char* tuple = page->getRecordData({page_number, slot}, length);
+      insert(getKey(tuple), RecordId{page_number, slot});
+    }
+    bufMgr->unPinPage(&tableFile, page_number, false);
+  }
+  // the frames are keyed by the caller's file handle
+  bufMgr->flushFile(&tableFile);
+}
+
+void ExtendibleHashIndex::flush() {
+  if (directoryDirty)
+    writeDirectory();
+  writeMeta();
+  bufMgr->flushFile(&file);
+}
+
+}  // namespace badgerdb
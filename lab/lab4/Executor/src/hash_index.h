@@ -0,0 +1,332 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "schema.h"
+#include "tuple.h"
+#include "types.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Disk-based extendible hash index mapping the values of an INT, CHAR or
+ * VARCHAR attribute of a table to the record IDs of its tuples, for equality
+ * lookups. The buckets live in a file of their own, one bucket per page, read
+ * and written through the buffer pool.
+ *
+ * The directory maps the low globalDepth bits of a key hash to a bucket and
+ * is kept in memory, so a lookup reads a single bucket page. A full bucket is
+ * split in two on the next bit of the hash; only when its local depth reaches
+ * the global one does the directory double, by copying its pointers, without
+ * touching any other bucket. Entries whose hashes cannot be told apart, such
+ * as duplicate keys, go to a chain of overflow pages instead. Deletes do not
+ * merge buckets or shrink the directory.
+ *
+ * The entries of a bucket page are kept sorted, so that a lookup binary
+ * searches the page.
+ */
+class ExtendibleHashIndex {
+ private:
+  /**
+   * Index file, the buffer pool frames are keyed by its address
+   */
+  File file;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Layout of the indexed table
+   */
+  TupleLayout layout;
+
+  /**
+   * Number of the indexed attribute
+   */
+  int attrNum;
+
+  /**
+   * Type of the indexed attribute
+   */
+  DataType attrType;
+
+  /**
+   * Schema of the table, to normalize constants of the indexed attribute
+   */
+  TableSchema tableSchema;
+
+  /**
+   * Width of a normalized key
+   */
+  int keyWidth;
+
+  /**
+   * Width of an entry: the key and the record ID
+   */
+  int entryWidth;
+
+  /**
+   * Max number of entries of a bucket page
+   */
+  int bucketCapacity;
+
+  /**
+   * Page holding the meta data of the index
+   */
+  PageId metaPageNumber;
+
+  /**
+   * Number of hash bits the directory is indexed by
+   */
+  int globalDepth;
+
+  /**
+   * Primary bucket page of every directory slot
+   */
+  vector<PageId> directory;
+
+  /**
+   * Pages the directory is stored in
+   */
+  vector<PageId> directoryPages;
+
+  /**
+   * Has the directory changed since it was last written?
+   */
+  bool directoryDirty;
+
+  /**
+   * First of the bucket pages emptied by splits, which are chained through
+   * their overflow links and reused before allocating new ones
+   */
+  PageId freeListHead;
+
+  /**
+   * Number of buckets, without their overflow pages
+   */
+  std::uint32_t numBuckets;
+
+  /**
+   * Number of entries
+   */
+  std::uint64_t numEntries;
+
+  /**
+   * Number of bucket pages read
+   */
+  std::uint64_t numPageReads;
+
+  /**
+   * Make an entry of a key and a record ID
+   */
+  string makeEntry(const string& key, const RecordId& rid) const;
+
+  /**
+   * Get the record ID of an entry
+   */
+  static RecordId entryRecordId(const char* entry, int keyWidth);
+
+  /**
+   * Hash a key of keyWidth bytes
+   */
+  std::uint32_t hashKey(const char* key) const;
+
+  /**
+   * Copy a bucket page into bucket
+   */
+  void readBucket(PageId pageNumber, string& bucket);
+
+  /**
+   * Overwrite the record of a page, padded to BUCKET_BYTES
+   */
+  void writeRecord(PageId pageNumber, const string& record);
+
+  /**
+   * Allocate a page holding a record of BUCKET_BYTES zeros
+   */
+  PageId allocatePage();
+
+  /**
+   * Get a page for a new bucket, a free one or a newly allocated one
+   */
+  PageId takePage();
+
+  /**
+   * Put a page emptied by a split at the head of the free list
+   */
+  void freePage(PageId pageNumber);
+
+  /**
+   * Create an empty bucket page of a local depth with no overflow page
+   */
+  string emptyBucket(int localDepth) const;
+
+  /**
+   * Write entries into a chain of bucket pages starting at a page, taking
+   * further pages as needed
+   */
+  void writeChain(PageId firstPage,
+                  const vector<string>& entries,
+                  int localDepth);
+
+  /**
+   * Add an entry in key order to a bucket page with room and write it
+   */
+  void addEntry(PageId pageNumber, string& bucket, const string& entry);
+
+  /**
+   * Split the bucket of a directory slot on the next bit of the hash,
+   * doubling the directory if its local depth is the global one
+   */
+  void split(std::uint32_t slot);
+
+  /**
+   * Write the meta data into the meta page
+   */
+  void writeMeta();
+
+  /**
+   * Read the meta data from the meta page
+   */
+  void readMeta();
+
+  /**
+   * Write the directory into its pages
+   */
+  void writeDirectory();
+
+ public:
+  /**
+   * Bytes of the bucket record of a page
+   */
+  static const int BUCKET_BYTES = Page::DATA_SIZE - sizeof(PageSlot);
+
+  /**
+   * Bytes of a bucket header: local depth, number of entries and next
+   * overflow page
+   */
+  static const int BUCKET_HEADER_BYTES = 8;
+
+  /**
+   * Max global depth; buckets whose entries agree on this many hash bits
+   * overflow instead of splitting
+   */
+  static const int MAX_GLOBAL_DEPTH = 20;
+
+  /**
+   * Constructor. Opens the index in the file, or creates an empty one.
+   * @throws BadIndexInfoException If the file holds an index on another
+   *                               attribute type or width
+   */
+  ExtendibleHashIndex(const string& indexFilename,
+                      const TableSchema& tableSchema,
+                      const string& attrName,
+                      BufMgr* bufMgr);
+
+  /**
+   * Not copyable, the buffer pool frames are keyed by the file's address
+   */
+  ExtendibleHashIndex(const ExtendibleHashIndex&) = delete;
+  ExtendibleHashIndex& operator=(const ExtendibleHashIndex&) = delete;
+
+  /**
+   * Destructor. Writes the meta data and the directory and flushes the file.
+   */
+  ~ExtendibleHashIndex();
+
+  /**
+   * Get the normalized key of the indexed attribute of a tuple
+   */
+  string getKey(const char* tuple) const;
+
+  /**
+   * Get the normalized key of a value in the syntax of INSERT, e.g. 42 or
+   * 'abc'
+   */
+  string makeKey(const string& value) const;
+
+  /**
+   * Get the width of a normalized key
+   */
+  int getKeyWidth() const { return keyWidth; }
+
+  /**
+   * Get the number of the indexed attribute in the table schema
+   */
+  int getAttrNum() const { return attrNum; }
+
+  /**
+   * Get the name of the index file
+   */
+  const string& getFilename() const { return file.filename(); }
+
+  /**
+   * Add an entry
+   */
+  void insert(const string& key, const RecordId& rid);
+
+  /**
+   * Remove an entry
+   * @return False if there is no such entry
+   */
+  bool remove(const string& key, const RecordId& rid);
+
+  /**
+   * Find a tuple with a key
+   * @param rid Receives its record ID
+   * @return False if there is none
+   */
+  bool lookup(const string& key, RecordId& rid);
+
+  /**
+   * Find all tuples with a key
+   * @param rids Receives their record IDs, appended in no particular order
+   * @return Number of tuples found
+   */
+  int lookupAll(const string& key, vector<RecordId>& rids);
+
+  /**
+   * Insert the tuples of a heap file of the indexed table
+   */
+  void loadTable(File& tableFile);
+
+  /**
+   * Write the meta data, the directory and the buckets back to the file
+   */
+  void flush();
+
+  /**
+   * Get the number of entries
+   */
+  std::uint64_t getNumEntries() const { return numEntries; }
+
+  /**
+   * Get the number of hash bits the directory is indexed by
+   */
+  int getGlobalDepth() const { return globalDepth; }
+
+  /**
+   * Get the number of buckets, without their overflow pages
+   */
+  std::uint32_t getNumBuckets() const { return numBuckets; }
+
+  /**
+   * Get the number of bucket pages read
+   */
+  std::uint64_t getNumPageReads() const { return numPageReads; }
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,60 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "types.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Layout shared by the pages of the index files, BTreeIndex and
+ * ExtendibleHashIndex. A node or bucket is one record per page, starting with
+ * an 8-byte header: 16 bits of the index's own (the node type, or the local
+ * depth), the 16-bit number of entries and a 32-bit link to another page
+ * (the next leaf or first child, or the next overflow page).
+ */
+class IndexPage {
+ public:
+  static std::uint32_t readWord(const char* bytes) {
+    std::uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+
+  static void writeWord(char* bytes, std::uint32_t value) {
+    memcpy(bytes, &value, sizeof(value));
+  }
+
+  /**
+   * Get the number of entries of a node
+   */
+  static int getCount(const char* node) {
+    std::uint16_t count;
+    memcpy(&count, node + 2, sizeof(count));
+    return count;
+  }
+
+  static void setCount(string& node, int count) {
+    std::uint16_t value = count;
+    memcpy(&node[2], &value, sizeof(value));
+  }
+
+  /**
+   * Get the page linked from a node
+   */
+  static PageId getLink(const char* node) { return readWord(node + 4); }
+
+  static void setLink(string& node, PageId pageNumber) {
+    writeWord(&node[4], pageNumber);
+  }
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,223 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "key_hash.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BADGERDB_CRC32C_HASH
+#include <nmmintrin.h>
+#endif
+
+using namespace std;
+
+namespace badgerdb {
+
+const int KeyHash::MAX_BATCH;
+
+/**
+ * Odd constants of the hashes
+ */
+static const std::uint64_t P0 = 0xa0761d6478bd642fULL;
+static const std::uint64_t P1 = 0xe7037ed1a0b428dbULL;
+static const std::uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+
+/**
+ * Multiply to 128 bits and fold the halves together
+ */
+static std::uint64_t mum(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)a * b;
+  return (std::uint64_t)r ^ (std::uint64_t)(r >> 64);
+#else
+  std::uint64_t a_lo = (std::uint32_t)a, a_hi = a >> 32;
+  std::uint64_t b_lo = (std::uint32_t)b, b_hi = b >> 32;
+  std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+  std::uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+  std::uint64_t middle = (lo_lo >> 32) + (std::uint32_t)hi_lo + lo_hi;
+  std::uint64_t low = (middle << 32) | (std::uint32_t)lo_lo;
+  std::uint64_t high = hi_hi + (hi_lo >> 32) + (middle >> 32);
+  return low ^ high;
+#endif
+}
+
+/**
+ * Load 8 bytes as a word
+ */
+static std::uint64_t loadWord(const char* bytes) {
+  std::uint64_t word;
+  memcpy(&word, bytes, 8);
+  return word;
+}
+
+/**
+ * Load the last length < 8 bytes of a key as a word, zero-padded, without
+ * reading past the key
+ */
+static std::uint64_t loadTail(const char* bytes, size_t length) {
+  std::uint64_t word = 0;
+  size_t i = 0;
+  if (length >= 4) {
+    std::uint32_t half;
+    memcpy(&half, bytes, 4);
+    word = half;
+    i = 4;
+  }
+  for (; i < length; ++i) {
+    word |= (std::uint64_t)(unsigned char)bytes[i] << (8 * i);
+  }
+  return word;
+}
+
+static std::uint64_t hashWy(const void* key,
+                            size_t length,
+                            std::uint64_t seed) {
+  const char* bytes = (const char*)key;
+  seed ^= P0;
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    seed = mum(loadWord(bytes + i) ^ P1, loadWord(bytes + i + 8) ^ seed);
+  }
+  std::uint64_t a = 0, b = 0;
+  if (i + 8 <= length) {
+    a = loadWord(bytes + i);
+    b = loadTail(bytes + i + 8, length - i - 8);
+  } else {
+    a = loadTail(bytes + i, length - i);
+  }
+  return mum(P1 ^ length, mum(a ^ P1, b ^ seed));
+}
+
+static void hashBatchWy(const void* const* keys,
+                        int numKeys,
+                        size_t length,
+                        std::uint64_t seed,
+                        std::uint64_t* hashes) {
+  for (int k = 0; k < numKeys; ++k) {
+    hashes[k] = hashWy(keys[k], length, seed);
+  }
+}
+
+#ifdef BADGERDB_CRC32C_HASH
+
+/**
+ * One step of the two CRC32C chains of a key, the second over the word
+ * rotated
+ */
+__attribute__((target("sse4.2")))
+static void stepCrc(std::uint64_t word,
+                    std::uint64_t& low,
+                    std::uint64_t& high) {
+  low = _mm_crc32_u64(low, word);
+  high = _mm_crc32_u64(high, (word >> 32) | (word << 32));
+}
+
+__attribute__((target("sse4.2")))
+static std::uint64_t hashCrc(const void* key,
+                             size_t length,
+                             std::uint64_t seed) {
+  const char* bytes = (const char*)key;
+  std::uint64_t low = (std::uint32_t)seed, high = seed >> 32;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    stepCrc(loadWord(bytes + i), low, high);
+  }
+  if (i < length)
+    stepCrc(loadTail(bytes + i, length - i), low, high);
+  return mum((high << 32 | low) ^ P2, P0 ^ length);
+}
+
+/**
+ * Hash up to MAX_BATCH keys by CRC32C as hashCrc does. Every step of the
+ * loop advances the chains of all keys, so that the 3-cycle latency of the
+ * instruction is overlapped.
+ */
+__attribute__((target("sse4.2")))
+static void hashBatchCrc(const void* const* keys,
+                         int numKeys,
+                         size_t length,
+                         std::uint64_t seed,
+                         std::uint64_t* hashes) {
+  std::uint64_t low[KeyHash::MAX_BATCH], high[KeyHash::MAX_BATCH];
+  for (int k = 0; k < numKeys; ++k) {
+    low[k] = (std::uint32_t)seed;
+    high[k] = seed >> 32;
+  }
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    for (int k = 0; k < numKeys; ++k) {
+      stepCrc(loadWord((const char*)keys[k] + i), low[k], high[k]);
+    }
+  }
+  if (i < length) {
+    for (int k = 0; k < numKeys; ++k) {
+      stepCrc(loadTail((const char*)keys[k] + i, length - i), low[k],
+              high[k]);
+    }
+  }
+  for (int k = 0; k < numKeys; ++k) {
+    hashes[k] = mum((high[k] << 32 | low[k]) ^ P2, P0 ^ length);
+  }
+}
+
+#endif  // BADGERDB_CRC32C_HASH
+
+/**
+ * Hash functions of the CPU, picked once
+ */
+struct HashFunctions {
+  std::uint64_t (*hash)(const void* key, size_t length, std::uint64_t seed);
+  void (*hashBatch)(const void* const* keys,
+                    int numKeys,
+                    size_t length,
+                    std::uint64_t seed,
+                    std::uint64_t* hashes);
+  bool usesCrc32c;
+};
+
+static HashFunctions detectHashFunctions() {
+#ifdef BADGERDB_CRC32C_HASH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) {
+    HashFunctions functions = {&hashCrc, &hashBatchCrc, true};
+    return functions;
+  }
+#endif
+  HashFunctions functions = {&hashWy, &hashBatchWy, false};
+  return functions;
+}
+
+static const HashFunctions& hashFunctions() {
+  static const HashFunctions functions = detectHashFunctions();
+  return functions;
+}
+
+std::uint64_t KeyHash::seedOf(int level) {
+  // splitmix64 of the level, so that consecutive levels get unrelated seeds
+  std::uint64_t z = (std::uint64_t)(level + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+std::uint64_t KeyHash::hash(const void* key,
+                            size_t length,
+                            std::uint64_t seed) {
+  return hashFunctions().hash(key, length, seed);
+}
+
+void KeyHash::hashBatch(const void* const* keys,
+                        int numKeys,
+                        size_t length,
+                        std::uint64_t seed,
+                        std::uint64_t* hashes) {
+  hashFunctions().hashBatch(keys, numKeys, length, seed, hashes);
+}
+
+bool KeyHash::usesCrc32c() {
+  return hashFunctions().usesCrc32c;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,69 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Seeded 64-bit hash of the bytes of a key, e.g. a join key written from a
+ * tuple, for partitioning. On CPUs with SSE4.2 it runs two CRC32C chains
+ * over the key 8 bytes at a time; elsewhere it is a wyhash-style hash of 16
+ * bytes per 64 x 64 -> 128-bit multiply. Either way the result is mixed by a
+ * final multiply, so that its high bits pick a bucket by multiply-shift.
+ *
+ * Partitioning passes use the seed of their level, so a bucket split again
+ * one level deeper is split by an independent hash. The hash may differ
+ * between CPUs and must not be persisted.
+ */
+class KeyHash {
+ public:
+  /**
+   * Max number of keys hashed together by hashBatch
+   */
+  static const int MAX_BATCH = 8;
+
+  /**
+   * Get the seed of a partitioning level
+   */
+  static std::uint64_t seedOf(int level);
+
+  /**
+   * Hash the length bytes of a key
+   */
+  static std::uint64_t hash(const void* key,
+                            size_t length,
+                            std::uint64_t seed);
+
+  /**
+   * Hash up to MAX_BATCH keys of the same length, as hash does. Their
+   * chains are interleaved so that the CPU overlaps them.
+   * @param hashes Receives the hash of every key
+   */
+  static void hashBatch(const void* const* keys,
+                        int numKeys,
+                        size_t length,
+                        std::uint64_t seed,
+                        std::uint64_t* hashes);
+
+  /**
+   * Get the bucket of a hash out of numBuckets by multiply-shift: the high
+   * 32 bits of the hash scaled to [0, numBuckets), without a division
+   */
+  static std::uint32_t toBucket(std::uint64_t hash, std::uint32_t numBuckets) {
+    return (std::uint32_t)(((hash >> 32) * numBuckets) >> 32);
+  }
+
+  /**
+   * Does the hash use CRC32C instructions?
+   */
+  static bool usesCrc32c();
+};
+
+}  // namespace badgerdb
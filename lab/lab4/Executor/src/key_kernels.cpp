@@ -0,0 +1,71 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "key_kernels.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+const int KeyKernels::MAX_FIXED_WORDS;
+
+KeyKernels KeyKernels::forWords(int numWords) {
+  static const KeyKernels kernels[MAX_FIXED_WORDS + 1] = {
+      {&KeyWords<0>::hash, &KeyWords<0>::equals},
+      {&KeyWords<1>::hash, &KeyWords<1>::equals},
+      {&KeyWords<2>::hash, &KeyWords<2>::equals},
+      {&KeyWords<3>::hash, &KeyWords<3>::equals},
+      {&KeyWords<4>::hash, &KeyWords<4>::equals}};
+  return kernels[numWords <= MAX_FIXED_WORDS ? numWords : 0];
+}
+
+/**
+ * Write the join key of a tuple through the kernel of the attribute type;
+ * the bytes of the key after the attribute are zeroed
+ */
+template <DataType TYPE>
+static void writeAttrKey(const KeyWriter& writer,
+                         const char* tuple,
+                         char* key);
+
+template <>
+void writeAttrKey<INT>(const KeyWriter& writer, const char* tuple, char* key) {
+  AttrKernels<INT>::writeKey(tuple + writer.offset, 4, 4, key);
+  memset(key + 4, 0, writer.keyWidth - 4);
+}
+
+template <>
+void writeAttrKey<CHAR>(const KeyWriter& writer, const char* tuple, char* key) {
+  AttrKernels<CHAR>::writeKey(tuple + writer.offset, writer.length,
+                              writer.keyWidth, key);
+}
+
+template <>
+void writeAttrKey<VARCHAR>(const KeyWriter& writer,
+                           const char* tuple,
+                           char* key) {
+  const char* value = tuple + writer.offset;
+  AttrKernels<VARCHAR>::writeKey(value + 1, (unsigned char)value[0],
+                                 writer.width, key);
+  memset(key + writer.width, 0, writer.keyWidth - writer.width);
+}
+
+KeyWriter KeyWriter::forAttr(DataType type,
+                             int offset,
+                             int length,
+                             int width,
+                             int keyWidth) {
+  // indexed by DataType
+  static void (*const writers[])(const KeyWriter&, const char*, char*) = {
+      &writeAttrKey<INT>, &writeAttrKey<CHAR>, &writeAttrKey<VARCHAR>};
+  KeyWriter writer;
+  writer.offset = offset;
+  writer.length = length;
+  writer.width = width;
+  writer.keyWidth = keyWidth;
+  writer.write = writers[type];
+  return writer;
+}
+
+}  // namespace badgerdb
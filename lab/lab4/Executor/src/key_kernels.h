@@ -0,0 +1,242 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "schema.h"
+#include "tuple.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Kernels on join keys of WORDS 4-byte words: hashing a key and comparing
+ * two. With a fixed WORDS the loops unroll into a few integer operations;
+ * WORDS = 0 takes the number of words at run time.
+ */
+template <int WORDS>
+struct KeyWords {
+  /**
+   * Hash a key to 64 bits
+   */
+  static std::uint64_t hash(const std::uint32_t* key, int numWords) {
+    const int n = WORDS > 0 ? WORDS : numWords;
+    std::uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for (int i = 0; i < n; ++i) {
+      hash = (hash ^ key[i]) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 32;
+    }
+    return hash;
+  }
+
+  /**
+   * Are two keys equal? All words are compared, without a branch per word.
+   */
+  static bool equals(const std::uint32_t* a,
+                     const std::uint32_t* b,
+                     int numWords) {
+    const int n = WORDS > 0 ? WORDS : numWords;
+    std::uint32_t diff = 0;
+    for (int i = 0; i < n; ++i) {
+      diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+  }
+};
+
+/**
+ * Kernels on join keys of one width, picked once per operator from the
+ * width through a dispatch table
+ */
+struct KeyKernels {
+  /**
+   * Max number of words of a key with kernels of its own; wider keys get
+   * those of KeyWords<0>
+   */
+  static const int MAX_FIXED_WORDS = 4;
+
+  std::uint64_t (*hash)(const std::uint32_t* key, int numWords);
+  bool (*equals)(const std::uint32_t* a, const std::uint32_t* b, int numWords);
+
+  /**
+   * Get the kernels of keys of numWords words
+   */
+  static KeyKernels forWords(int numWords);
+};
+
+/**
+ * Kernels on the values of an attribute of type TYPE as stored in a tuple:
+ * locating a value, comparing it with a constant in the same form and
+ * writing its part of a join key. An operator picks the instantiation of an
+ * attribute once from the schema, so the loops over tuples do not branch on
+ * the type.
+ */
+template <DataType TYPE>
+struct AttrKernels;
+
+template <>
+struct AttrKernels<INT> {
+  /**
+   * Locate the num-th attribute of a tuple, at fixedOffset if that is not -1
+   */
+  static AttrSlot locate(const TupleLayout& layout,
+                         const char* tuple,
+                         int num,
+                         int fixedOffset) {
+    AttrSlot slot;
+    slot.offset =
+        fixedOffset >= 0 ? fixedOffset : layout.locate(tuple, num).offset;
+    slot.length = 4;
+    return slot;
+  }
+
+  /**
+   * Compare a value with a constant of the same type like strcmp
+   */
+  static int compare(const char* value,
+                     int length,
+                     const char* constant,
+                     int constantLength) {
+    int a = TupleLayout::decodeInt(value);
+    int b = TupleLayout::decodeInt(constant);
+    return a < b ? -1 : a > b ? 1 : 0;
+  }
+
+  /**
+   * Write the part of a join key of a value, width bytes
+   */
+  static void writeKey(const char* value, int length, int width, char* key) {
+    memcpy(key, value, 4);
+  }
+};
+
+template <>
+struct AttrKernels<CHAR> {
+  static AttrSlot locate(const TupleLayout& layout,
+                         const char* tuple,
+                         int num,
+                         int fixedOffset) {
+    if (fixedOffset < 0)
+      return layout.locate(tuple, num);
+    AttrSlot slot;
+    slot.offset = fixedOffset;
+    slot.length = layout.getNormalizedWidth(num);
+    return slot;
+  }
+
+  /**
+   * The constant is padded to the max length, as stored
+   */
+  static int compare(const char* value,
+                     int length,
+                     const char* constant,
+                     int constantLength) {
+    return memcmp(value, constant, length);
+  }
+
+  /**
+   * The key is zero-padded if the attribute of the other input is longer
+   */
+  static void writeKey(const char* value, int length, int width, char* key) {
+    memcpy(key, value, length);
+    memset(key + length, 0, width - length);
+  }
+};
+
+template <>
+struct AttrKernels<VARCHAR> {
+  static AttrSlot locate(const TupleLayout& layout,
+                         const char* tuple,
+                         int num,
+                         int fixedOffset) {
+    if (fixedOffset < 0)
+      return layout.locate(tuple, num);
+    AttrSlot slot;
+    slot.offset = fixedOffset + 1;
+    slot.length = (unsigned char)tuple[fixedOffset];
+    return slot;
+  }
+
+  static int compare(const char* value,
+                     int length,
+                     const char* constant,
+                     int constantLength) {
+    int cmp = memcmp(value, constant, min(length, constantLength));
+    return cmp != 0 ? cmp : length - constantLength;
+  }
+
+  /**
+   * The key is the length byte, then the characters zero-padded
+   */
+  static void writeKey(const char* value, int length, int width, char* key) {
+    int copied = min(length, width - 1);
+    key[0] = (char)length;
+    memcpy(key + 1, value, copied);
+    memset(key + 1 + copied, 0, width - 1 - copied);
+  }
+};
+
+/**
+ * Writer of the join key of a tuple whose only key attribute lies at a
+ * fixed offset, the common case of a join on one attribute. The kernel of
+ * the attribute type is picked once through a dispatch table; keys with
+ * several attributes are left to the general JoinOperator::writeJoinKey.
+ */
+struct KeyWriter {
+  /**
+   * Offset of the attribute in a tuple, and its length if fixed
+   */
+  int offset;
+  int length;
+
+  /**
+   * Bytes of the attribute in the key, and of the whole key
+   */
+  int width;
+  int keyWidth;
+
+  /**
+   * Kernel of the attribute type, or null if the writer is not set
+   */
+  void (*write)(const KeyWriter& writer, const char* tuple, char* key);
+
+  /**
+   * Constructor of a writer that is not set
+   */
+  KeyWriter()
+      : offset(0), length(0), width(0), keyWidth(0), write(nullptr) {
+    // nothing
+  }
+
+  /**
+   * Get the writer of the join keys of an attribute at a fixed offset
+   * @param length Its length in the tuple: the max length for CHAR
+   * @param width Its bytes in the key
+   * @param keyWidth Bytes of the key, whole words
+   */
+  static KeyWriter forAttr(DataType type,
+                           int offset,
+                           int length,
+                           int width,
+                           int keyWidth);
+
+  /**
+   * Is the writer set?
+   */
+  bool isSet() const { return write != nullptr; }
+
+  /**
+   * Write the key of a tuple
+   */
+  void operator()(const char* tuple, char* key) const {
+    write(*this, tuple, key);
+  }
+};
+
+}  // namespace badgerdb
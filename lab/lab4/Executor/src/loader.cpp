@@ -0,0 +1,628 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "loader.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "exceptions/badgerdb_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/invalid_sql_exception.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+static string toUpper(string s) {
+  for (char& c : s) {
+    c = toupper((unsigned char)c);
+  }
+  return s;
+}
+
+static string trim(const string& s) {
+  size_t begin = 0, end = s.size();
+  while (begin < end && isspace((unsigned char)s[begin]))
+    begin++;
+  while (end > begin && isspace((unsigned char)s[end - 1]))
+    end--;
+  return s.substr(begin, end - begin);
+}
+
+static size_t skipSpaces(const string& s, size_t pos) {
+  while (pos < s.size() && isspace((unsigned char)s[pos]))
+    pos++;
+  return pos;
+}
+
+/**
+ * Character at pos, or '\0' past the end of the string
+ */
+static char charAt(const string& s, size_t pos) {
+  return pos < s.size() ? s[pos] : '\0';
+}
+
+/**
+ * Read a plain or quoted ("name", `name`, [name]) identifier at pos
+ */
+static string readIdentifier(const string& s, size_t& pos) {
+  pos = skipSpaces(s, pos);
+  char c = charAt(s, pos);
+  if (c == '"' || c == '`' || c == '[') {
+    size_t end = s.find(c == '[' ? ']' : c, pos + 1);
+    if (end == string::npos)
+      throw InvalidSQLException(s, "unterminated identifier");
+    string name = s.substr(pos + 1, end - pos - 1);
+    pos = end + 1;
+    return name;
+  }
+  size_t begin = pos;
+  while (pos < s.size() &&
+         (isalnum((unsigned char)s[pos]) || s[pos] == '_' || s[pos] == '$'))
+    pos++;
+  return s.substr(begin, pos - begin);
+}
+
+/**
+ * Read the next word at pos and check that it is the expected keyword
+ */
+static bool readKeyword(const string& s, size_t& pos, const string& keyword) {
+  size_t begin = skipSpaces(s, pos);
+  if (toUpper(s.substr(begin, keyword.size())) != keyword)
+    return false;
+  pos = begin + keyword.size();
+  return true;
+}
+
+/**
+ * Split a list at separators outside quotes and parentheses
+ */
+static vector<string> splitTopLevel(const string& s, char sep) {
+  vector<string> items;
+  int depth = 0;
+  char quote = '\0';
+  size_t begin = 0;
+  for (size_t i = 0; i < s.size(); ++i) {
+    char c = s[i];
+    if (quote != '\0') {
+      if (c == quote)
+        quote = '\0';
+    } else if (c == '\'' || c == '"' || c == '`') {
+      quote = c;
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')') {
+      depth--;
+    } else if (c == sep && depth == 0) {
+      items.push_back(s.substr(begin, i - begin));
+      begin = i + 1;
+    }
+  }
+  items.push_back(s.substr(begin));
+  return items;
+}
+
+/**
+ * Read one value of a VALUES row at pos. String literals are unquoted, NULL
+ * becomes an empty string.
+ */
+static string readValue(const string& s, size_t& pos) {
+  pos = skipSpaces(s, pos);
+  if (charAt(s, pos) == '\'') {
+    string value;
+    for (pos++;;) {
+      size_t end = s.find('\'', pos);
+      if (end == string::npos)
+        throw InvalidSQLException(s.substr(pos), "unterminated string");
+      value.append(s, pos, end - pos);
+      pos = end + 1;
+      if (charAt(s, pos) != '\'')
+        break;
+      value += '\'';  // '' stands for a single quote
+      pos++;
+    }
+    return value;
+  }
+  size_t begin = pos;
+  while (pos < s.size() && s[pos] != ',' && s[pos] != ')')
+    pos++;
+  string value = trim(s.substr(begin, pos - begin));
+  if (toUpper(value) == "NULL")
+    return "";
+  return value;
+}
+
+/**
+ * Parse the rows "(v, ...), (v, ...)" of a chunk of an INSERT statement
+ */
+static void parseValuesChunk(const string& chunk,
+                             const vector<int>& columnMap,
+                             const TableSchema& tableSchema,
+                             vector<string>& tuples) {
+  vector<string> values;
+  size_t pos = 0;
+  while (true) {
+    while (pos < chunk.size() &&
+           (chunk[pos] == ',' || isspace((unsigned char)chunk[pos])))
+      pos++;
+    if (pos >= chunk.size())
+      break;
+    if (chunk[pos] != '(')
+      throw InvalidSQLException(chunk.substr(pos), "expected '('");
+    pos++;
+    values.assign(tableSchema.getAttrCount(), "");
+    for (size_t k = 0;; ++k) {
+      string value = readValue(chunk, pos);
+      if (k >= columnMap.size())
+        throw InvalidSQLException(chunk.substr(pos), "too many values");
+      values[columnMap[k]] = value;
+      pos = skipSpaces(chunk, pos);
+      if (charAt(chunk, pos) == ',') {
+        pos++;
+      } else if (charAt(chunk, pos) == ')') {
+        pos++;
+        break;
+      } else {
+        throw InvalidSQLException(chunk.substr(pos), "unterminated row");
+      }
+    }
+    tuples.push_back(
+        HeapFileManager::createTupleFromValues(values, tableSchema));
+  }
+}
+
+/**
+ * Parse the lines of a chunk of a CSV file
+ */
+static void parseCSVChunk(const string& chunk,
+                          char delimiter,
+                          const TableSchema& tableSchema,
+                          vector<string>& tuples) {
+  vector<string> values;
+  size_t pos = 0;
+  while (pos < chunk.size()) {
+    size_t eol = chunk.find('\n', pos);
+    if (eol == string::npos)
+      eol = chunk.size();
+    size_t end = eol;
+    if (end > pos && chunk[end - 1] == '\r')
+      end--;
+    if (end > pos) {
+      values.clear();
+      size_t p = pos;
+      while (true) {
+        string value;
+        if (chunk[p] == '"') {
+          // quoted field, "" stands for a double quote
+          for (p++; p < end; p++) {
+            if (chunk[p] == '"') {
+              if (p + 1 < end && chunk[p + 1] == '"') {
+                p++;
+              } else {
+                p++;
+                break;
+              }
+            }
+            value += chunk[p];
+          }
+          while (p < end && chunk[p] != delimiter)
+            p++;
+        } else {
+          size_t begin = p;
+          while (p < end && chunk[p] != delimiter)
+            p++;
+          value.assign(chunk, begin, p - begin);
+        }
+        values.push_back(value);
+        if (p >= end)
+          break;
+        p++;  // skip the delimiter
+      }
+      if ((int)values.size() > tableSchema.getAttrCount())
+        throw BadgerDbException("CSV row has too many fields: " +
+                                chunk.substr(pos, end - pos));
+      values.resize(tableSchema.getAttrCount());
+      tuples.push_back(
+          HeapFileManager::createTupleFromValues(values, tableSchema));
+    }
+    pos = eol + 1;
+  }
+}
+
+BulkLoader::BulkLoader(Catalog* catalog,
+                       BufMgr* bufMgr,
+                       int numWorkers,
+                       size_t chunkSize)
+    : catalog(catalog),
+      bufMgr(bufMgr),
+      numWorkers(numWorkers),
+      chunkSize(chunkSize) {
+  if (this->numWorkers <= 0)
+    this->numWorkers = max(1u, thread::hardware_concurrency());
+}
+
+void BulkLoader::loadChunks(
+    File& file,
+    const function<bool(string&)>& nextChunk,
+    const function<void(const string&, vector<string>&)>& parseChunk) {
+  deque<future<vector<string>>> pending;
+  // the tail page carries over from one chunk to the next
+  HeapAppender appender(file, bufMgr, catalog);
+  bool more = true;
+  while (more || !pending.empty()) {
+    // keep every worker busy while this thread writes pages
+    while (more && (int)pending.size() < numWorkers) {
+      string chunk;
+      more = nextChunk(chunk);
+      if (more) {
+        pending.push_back(async(
+            launch::async,
+            [&parseChunk](const string& text) {
+              vector<string> tuples;
+              parseChunk(text, tuples);
+              return tuples;
+            },
+            std::move(chunk)));
+      }
+    }
+    if (pending.empty())
+      break;
+    vector<string> tuples = pending.front().get();
+    pending.pop_front();
+    for (const string& tuple : tuples) {
+      appender.append(tuple);
+    }
+    stats.numRows += tuples.size();
+  }
+  appender.close();
+  stats.numPages += appender.getNumPages();
+}
+
+void BulkLoader::analyzeTables(int numSamplePages) {
+  for (const auto& entry : tableFiles) {
+    HeapFileManager::analyzeTable(catalog, catalog->getTableId(entry.first),
+                                  bufMgr, numSamplePages);
+  }
+}
+
+void BulkLoader::buildZoneMaps() {
+  for (const auto& entry : tableFiles) {
+    HeapFileManager::buildZoneMap(catalog, catalog->getTableId(entry.first),
+                                  bufMgr);
+  }
+}
+
+File& BulkLoader::getTableFile(const string& tableName) {
+  auto it = tableFiles.find(tableName);
+  if (it == tableFiles.end()) {
+    TableId tableId = catalog->getTableId(tableName);
+    it = tableFiles
+             .insert(make_pair(
+                 tableName, File::open(catalog->getTableFilename(tableId))))
+             .first;
+  }
+  return it->second;
+}
+
+void BulkLoader::loadSQLFile(const string& filename) {
+  auto start = chrono::steady_clock::now();
+  ifstream in(filename, ios::binary);
+  if (!in)
+    throw FileNotFoundException(filename);
+  stringstream buffer;
+  buffer << in.rdbuf();
+  const string text = buffer.str();
+
+  // cut the dump into statements at ';' outside quotes, dropping comments
+  string statement;
+  char quote = '\0';
+  size_t begin = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    if (quote != '\0') {
+      if (c == quote)
+        quote = '\0';
+    } else if (c == '\'' || c == '"' || c == '`') {
+      quote = c;
+    } else if (c == '-' && charAt(text, i + 1) == '-') {
+      statement.append(text, begin, i - begin);
+      i = text.find('\n', i);
+      if (i == string::npos)
+        i = text.size();
+      begin = i;
+    } else if (c == '/' && charAt(text, i + 1) == '*') {
+      statement.append(text, begin, i - begin);
+      i = text.find("*/", i + 2);
+      i = (i == string::npos) ? text.size() : i + 1;
+      begin = i + 1;
+    } else if (c == ';') {
+      statement.append(text, begin, i - begin);
+      executeStatement(statement);
+      statement.clear();
+      begin = i + 1;
+    }
+  }
+  if (begin < text.size())
+    statement.append(text, begin, string::npos);
+  executeStatement(statement);
+
+  stats.seconds +=
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void BulkLoader::loadCSVFile(const string& filename,
+                             const string& tableName,
+                             char delimiter,
+                             bool hasHeader) {
+  auto start = chrono::steady_clock::now();
+  if (!catalog->hasTable(tableName))
+    throw BadgerDbException("Unknown table: " + tableName);
+  const TableSchema tableSchema =
+      catalog->getTableSchema(catalog->getTableId(tableName));
+  ifstream in(filename, ios::binary);
+  if (!in)
+    throw FileNotFoundException(filename);
+  if (hasHeader) {
+    string header;
+    getline(in, header);
+  }
+
+  // chunks end at the last line break read, the rest is carried over
+  string carry;
+  auto nextChunk = [&](string& chunk) {
+    chunk.swap(carry);
+    carry.clear();
+    size_t cut = string::npos;
+    while (in && cut == string::npos) {
+      size_t old_size = chunk.size();
+      chunk.resize(old_size + chunkSize);
+      in.read(&chunk[old_size], chunkSize);
+      chunk.resize(old_size + in.gcount());
+      cut = chunk.rfind('\n');
+    }
+    if (in && cut != string::npos) {
+      carry.assign(chunk, cut + 1, string::npos);
+      chunk.resize(cut + 1);
+    }
+    return !chunk.empty();
+  };
+  auto parseChunk = [&](const string& chunk, vector<string>& tuples) {
+    parseCSVChunk(chunk, delimiter, tableSchema, tuples);
+  };
+  loadChunks(getTableFile(tableName), nextChunk, parseChunk);
+
+  stats.seconds +=
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void BulkLoader::executeStatement(const string& statement) {
+  size_t pos = 0;
+  if (readKeyword(statement, pos, "CREATE")) {
+    createTable(statement);
+  } else if (readKeyword(statement, pos, "INSERT")) {
+    insertRows(statement);
+  } else if (!trim(statement).empty()) {
+    cerr << "Skipping unsupported statement: "
+         << trim(statement).substr(0, 40) << endl;
+  }
+}
+
+void BulkLoader::createTable(const string& statement) {
+  size_t pos = 0;
+  readKeyword(statement, pos, "CREATE");
+  if (!readKeyword(statement, pos, "TABLE")) {
+    cerr << "Skipping unsupported statement: "
+         << trim(statement).substr(0, 40) << endl;
+    return;
+  }
+  readKeyword(statement, pos, "IF NOT EXISTS");
+  string tableName = readIdentifier(statement, pos);
+  if (catalog->hasTable(tableName))
+    throw InvalidSQLException(statement, "table already exists");
+
+  TableSchema tableSchema(tableName);
+  try {
+    tableSchema = parseCreateTable(statement);
+  } catch (InvalidSQLException& e) {
+    cerr << "Skipping table " << tableName << ": " << e.message() << endl;
+    skippedTables.insert(tableName);
+    return;
+  }
+
+  string tableFilename = tableName + ".tbl";
+  tableFiles.insert(make_pair(tableName, File::create(tableFilename)));
+  catalog->addTableSchema(tableSchema, tableFilename);
+  stats.numTables++;
+}
+
+void BulkLoader::insertRows(const string& statement) {
+  size_t pos = 0;
+  readKeyword(statement, pos, "INSERT");
+  readKeyword(statement, pos, "INTO");
+  string tableName = readIdentifier(statement, pos);
+  if (skippedTables.count(tableName))
+    return;
+  if (!catalog->hasTable(tableName))
+    throw InvalidSQLException(statement, "unknown table " + tableName);
+  const TableSchema tableSchema =
+      catalog->getTableSchema(catalog->getTableId(tableName));
+
+  // map the listed columns to their positions in the schema
+  vector<int> columnMap;
+  pos = skipSpaces(statement, pos);
+  if (charAt(statement, pos) == '(') {
+    size_t end = statement.find(')', pos);
+    if (end == string::npos)
+      throw InvalidSQLException(statement, "unterminated column list");
+    for (string column :
+         splitTopLevel(statement.substr(pos + 1, end - pos - 1), ',')) {
+      size_t p = 0;
+      int num = tableSchema.getAttrNum(readIdentifier(column, p));
+      if (num < 0)
+        throw InvalidSQLException(statement, "unknown column " + column);
+      columnMap.push_back(num);
+    }
+    pos = end + 1;
+  } else {
+    for (int i = 0; i < tableSchema.getAttrCount(); ++i)
+      columnMap.push_back(i);
+  }
+  if (!readKeyword(statement, pos, "VALUES"))
+    throw InvalidSQLException(statement, "only INSERT ... VALUES is supported");
+
+  // chunks end after a row, once they are at least chunkSize long
+  auto nextChunk = [&](string& chunk) {
+    if (pos >= statement.size())
+      return false;
+    size_t begin = pos, i = pos;
+    int depth = 0;
+    bool quoted = false;
+    for (; i < statement.size(); ++i) {
+      char c = statement[i];
+      if (quoted) {
+        if (c == '\'')
+          quoted = false;
+      } else if (c == '\'') {
+        quoted = true;
+      } else if (c == '(') {
+        depth++;
+      } else if (c == ')' && --depth == 0 && i + 1 - begin >= chunkSize) {
+        i++;
+        break;
+      }
+    }
+    chunk.assign(statement, begin, i - begin);
+    pos = i;
+    return true;
+  };
+  auto parseChunk = [&](const string& chunk, vector<string>& tuples) {
+    parseValuesChunk(chunk, columnMap, tableSchema, tuples);
+  };
+  loadChunks(getTableFile(tableName), nextChunk, parseChunk);
+}
+
+TableSchema BulkLoader::parseCreateTable(const string& statement) {
+  size_t pos = 0;
+  readKeyword(statement, pos, "CREATE");
+  readKeyword(statement, pos, "TABLE");
+  readKeyword(statement, pos, "IF NOT EXISTS");
+  string tableName = readIdentifier(statement, pos);
+  size_t open = statement.find('(', pos);
+  size_t close = statement.rfind(')');
+  if (tableName.empty() || open == string::npos || close == string::npos ||
+      close < open)
+    throw InvalidSQLException(statement, "missing column list");
+
+  vector<Attribute> attrs;
+  vector<vector<string>> keys;  // PRIMARY KEY (...) and UNIQUE (...) lists
+  vector<bool> keyIsPrimary;
+  for (string def :
+       splitTopLevel(statement.substr(open + 1, close - open - 1), ',')) {
+    def = trim(def);
+    if (def.empty())
+      continue;
+    string upper = toUpper(def);
+    size_t p = 0;
+    bool quoted = def[0] == '"' || def[0] == '`' || def[0] == '[';
+    string first = toUpper(readIdentifier(def, p));
+
+    if (!quoted && (first == "PRIMARY" || first == "UNIQUE" ||
+                    first == "FOREIGN" || first == "CHECK" ||
+                    first == "CONSTRAINT" || first == "KEY" ||
+                    first == "INDEX")) {
+      // table constraint, only keys matter to the schema
+      bool primary = upper.find("PRIMARY KEY") != string::npos;
+      if (!primary && first != "UNIQUE" && upper.find(" UNIQUE") == string::npos)
+        continue;
+      size_t b = def.find('('), e = def.find(')');
+      if (b == string::npos || e == string::npos)
+        continue;
+      vector<string> columns;
+      for (string column : splitTopLevel(def.substr(b + 1, e - b - 1), ',')) {
+        size_t q = 0;
+        columns.push_back(readIdentifier(column, q));
+      }
+      keys.push_back(columns);
+      keyIsPrimary.push_back(primary);
+      continue;
+    }
+
+    // column definition: name type[(size)] [constraints]
+    p = 0;
+    string attrName = readIdentifier(def, p);
+    p = skipSpaces(def, p);
+    size_t typeBegin = p;
+    while (p < def.size() && isalpha((unsigned char)def[p]))
+      p++;
+    string typeName = toUpper(def.substr(typeBegin, p - typeBegin));
+    int maxSize = -1;
+    p = skipSpaces(def, p);
+    if (charAt(def, p) == '(') {
+      maxSize = atoi(def.c_str() + p + 1);
+      p = def.find(')', p) + 1;
+    }
+    string constraints = toUpper(def.substr(min(p, def.size())));
+
+    DataType attrType;
+    if (typeName == "INT" || typeName == "INTEGER" || typeName == "SMALLINT" ||
+        typeName == "TINYINT" || typeName == "MEDIUMINT") {
+      attrType = INT;
+      maxSize = 4;
+    } else if (typeName == "CHAR" || typeName == "CHARACTER") {
+      attrType = CHAR;
+      if (maxSize <= 0)
+        maxSize = 1;
+    } else if (typeName == "VARCHAR" || typeName == "VARCHAR2") {
+      attrType = VARCHAR;
+      if (maxSize <= 0)
+        throw InvalidSQLException(def, "VARCHAR needs a length");
+    } else {
+      throw InvalidSQLException(def, "unsupported type " + typeName);
+    }
+
+    Attribute attr(attrName, attrType, maxSize);
+    attr.isNotNull = constraints.find("NOT NULL") != string::npos ||
+                     constraints.find("PRIMARY KEY") != string::npos;
+    attr.isUnique = constraints.find("UNIQUE") != string::npos ||
+                    constraints.find("PRIMARY KEY") != string::npos;
+    attrs.push_back(attr);
+  }
+  if (attrs.empty())
+    throw InvalidSQLException(statement, "no columns");
+
+  TableSchema tableSchema(tableName, attrs);
+  vector<Attribute> keyed = attrs;
+  for (size_t k = 0; k < keys.size(); ++k) {
+    for (const string& column : keys[k]) {
+      int num = tableSchema.getAttrNum(column);
+      if (num < 0)
+        throw InvalidSQLException(statement, "unknown key column " + column);
+      if (keyIsPrimary[k])
+        keyed[num].isNotNull = true;
+      if (keys[k].size() == 1)
+        keyed[num].isUnique = true;
+    }
+  }
+  return TableSchema(tableName, keyed);
+}
+
+void BulkLoader::printStats() const {
+  cout << "# Tables Created: " << stats.numTables << endl;
+  cout << "# Rows Loaded: " << stats.numRows << endl;
+  cout << "# Pages Written: " << stats.numPages << endl;
+  cout << "# Seconds: " << stats.seconds << endl;
+  cout << "# Rows/sec: " << (long)stats.getRowsPerSecond() << endl;
+}
+
+}  // namespace badgerdb
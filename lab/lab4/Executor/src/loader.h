@@ -0,0 +1,197 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "catalog.h"
+#include "file.h"
+#include "schema.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Running statistics of a bulk load
+ */
+struct LoadStats {
+  /**
+   * Number of tables created
+   */
+  int numTables;
+
+  /**
+   * Number of rows loaded
+   */
+  long numRows;
+
+  /**
+   * Number of pages written to table files
+   */
+  long numPages;
+
+  /**
+   * Wall-clock time spent loading, in seconds
+   */
+  double seconds;
+
+  /**
+   * Constructor
+   */
+  LoadStats() : numTables(0), numRows(0), numPages(0), seconds(0) {
+    // nothing
+  }
+
+  /**
+   * Get the load throughput
+   */
+  double getRowsPerSecond() const {
+    return seconds > 0 ? numRows / seconds : 0;
+  }
+};
+
+/**
+ * Bulk loader for SQL dumps and CSV files.
+ *
+ * The input is cut into chunks at row boundaries. Chunks are parsed and
+ * encoded into tuples by worker threads, while the calling thread packs the
+ * tuples into pages of the table file in input order.
+ */
+class BulkLoader {
+ private:
+  /**
+   * System catalog
+   */
+  Catalog* catalog;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Maximum number of chunks being parsed at the same time
+   */
+  int numWorkers;
+
+  /**
+   * Approximate number of input bytes per chunk
+   */
+  size_t chunkSize;
+
+  /**
+   * Running statistics
+   */
+  LoadStats stats;
+
+  /**
+   * Files of the tables touched by the loader
+   */
+  map<string, File> tableFiles;
+
+  /**
+   * Tables whose CREATE TABLE was rejected, their rows are skipped
+   */
+  set<string> skippedTables;
+
+  /**
+   * Execute a CREATE TABLE or INSERT statement from a dump
+   */
+  void executeStatement(const string& statement);
+
+  /**
+   * CREATE TABLE
+   */
+  void createTable(const string& statement);
+
+  /**
+   * INSERT INTO ... VALUES (...), (...), ...
+   */
+  void insertRows(const string& statement);
+
+  /**
+   * Get the file of a table, opening it if needed
+   */
+  File& getTableFile(const string& tableName);
+
+  /**
+   * Parse the chunks produced by nextChunk with parseChunk on worker threads
+   * and append the resulting tuples to the table file in chunk order.
+   */
+  void loadChunks(File& file,
+                  const function<bool(string&)>& nextChunk,
+                  const function<void(const string&, vector<string>&)>&
+                      parseChunk);
+
+ public:
+  /**
+   * Constructor
+   * @param numWorkers Number of parser threads, 0 for one per core
+   * @param chunkSize Approximate number of input bytes per chunk
+   */
+  BulkLoader(Catalog* catalog,
+             BufMgr* bufMgr,
+             int numWorkers = 0,
+             size_t chunkSize = 1 << 20);
+
+  /**
+   * Destructor
+   */
+  ~BulkLoader() {
+    // nothing
+  }
+
+  /**
+   * Load an SQL dump made of CREATE TABLE and INSERT statements
+   */
+  void loadSQLFile(const string& filename);
+
+  /**
+   * Load a CSV file into an existing table. Quoted fields may not contain
+   * line breaks.
+   */
+  void loadCSVFile(const string& filename,
+                   const string& tableName,
+                   char delimiter = ',',
+                   bool hasHeader = false);
+
+  /**
+   * Get running statistics
+   */
+  const LoadStats& getStats() const { return stats; }
+
+  /**
+   * Print running statistics
+   */
+  void printStats() const;
+
+  /**
+   * Refresh the statistics of every table the loader wrote to
+   * @param numSamplePages Pages sampled per table, 0 to read all pages
+   */
+  void analyzeTables(int numSamplePages = 0);
+
+  /**
+   * Build the zone maps of every table the loader wrote to
+   */
+  void buildZoneMaps();
+
+  /**
+   * Create table schema from a CREATE TABLE statement as found in dumps:
+   * multi-line, quoted identifiers, lower-case types and column or table
+   * constraints are accepted.
+   * @throws InvalidSQLException If a column has an unsupported type
+   */
+  static TableSchema parseCreateTable(const string& statement);
+};
+
+}  // namespace badgerdb
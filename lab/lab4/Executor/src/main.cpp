@@ -13,6 +13,8 @@
 #include <sstream>
 #include <vector>
 
+#include "aggregate.h"
+#include "batch.h"
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/file_not_found_exception.h"
@@ -23,6 +25,7 @@
 #include "file_iterator.h"
 #include "page.h"
 #include "page_iterator.h"
+#include "planner.h"
 #include "storage.h"
 
 using namespace badgerdb;
@@ -54,7 +57,7 @@ void createDatabase(BufMgr* bufMgr, Catalog* catalog) {
        << ");";
     string tuple =
         HeapFileManager::createTupleFromSQLStatement(ss.str(), catalog);
-    HeapFileManager::insertTuple(tuple, leftTableFile, bufMgr);
+    HeapFileManager::insertTuple(tuple, leftTableFile, bufMgr, catalog);
   }
 
   for (int i = 0; i < rightTableRows; i++) {
@@ -62,7 +65,7 @@ void createDatabase(BufMgr* bufMgr, Catalog* catalog) {
     ss << "INSERT INTO s VALUES (" << i << ", 's" << i << "');";
     string tuple =
         HeapFileManager::createTupleFromSQLStatement(ss.str(), catalog);
-    HeapFileManager::insertTuple(tuple, rightTableFile, bufMgr);
+    HeapFileManager::insertTuple(tuple, rightTableFile, bufMgr, catalog);
   }
 
   // Print all tuples in tables
@@ -158,6 +161,146 @@ void testGraceHashJoin(BufMgr* bufMgr, Catalog* catalog) {
   scanner.print();
 }
 
+void testJoinPlanner(BufMgr* bufMgr, Catalog* catalog, int numBufPages) {
+  TableId leftTableId = catalog->getTableId("r");
+  TableId rightTableId = catalog->getTableId("s");
+  TableSchema leftTableSchema = catalog->getTableSchema(leftTableId);
+  TableSchema rightTableSchema = catalog->getTableSchema(rightTableId);
+
+  // Let the planner choose the join operator
+  File leftTableFile = File::open(catalog->getTableFilename(leftTableId));
+  File rightTableFile = File::open(catalog->getTableFilename(rightTableId));
+  JoinPlanner planner(catalog, bufMgr);
+  JoinPlan plan = planner.plan(leftTableFile, leftTableSchema, rightTableFile,
+                               rightTableSchema, numBufPages);
+  unique_ptr<JoinOperator> joinOperator = planner.createJoinOperator(
+      plan, leftTableFile, rightTableFile, leftTableSchema, rightTableSchema);
+
+  // Join two tables using the chosen operator
+  string filename = leftTableSchema.getTableName() + "_PLAN" +
+                    to_string(numBufPages) + "_" +
+                    rightTableSchema.getTableName() + ".tbl";
+  File resultFile = File::create(filename);
+  joinOperator->execute(numBufPages, resultFile);
+
+  // Print predicted and actual I/Os
+  cout << JoinPlanner::explain(plan, joinOperator.get()) << endl;
+  joinOperator->printRunningStats();
+}
+
+void testPipeline(BufMgr* bufMgr, Catalog* catalog) {
+  TableId leftTableId = catalog->getTableId("r");
+  TableId rightTableId = catalog->getTableId("s");
+  TableSchema leftTableSchema = catalog->getTableSchema(leftTableId);
+  TableSchema rightTableSchema = catalog->getTableSchema(rightTableId);
+  File leftTableFile = File::open(catalog->getTableFilename(leftTableId));
+  File rightTableFile = File::open(catalog->getTableFilename(rightTableId));
+
+  // SELECT a, c FROM r JOIN s WHERE b = 7, without intermediate files
+  unique_ptr<Operator> leftScan(
+      new TableScanOperator(leftTableFile, leftTableSchema, bufMgr, catalog));
+  unique_ptr<Operator> rightScan(new TableScanOperator(
+      rightTableFile, rightTableSchema, bufMgr, catalog));
+  unique_ptr<Operator> join(new OnePassJoinOperator(
+      std::move(leftScan), std::move(rightScan), catalog, bufMgr));
+  auto predicate = FilterOperator::attrEquals(join->getSchema(), "b", "7");
+  unique_ptr<Operator> filter(
+      new FilterOperator(std::move(join), predicate, bufMgr));
+  ProjectOperator project(std::move(filter), {"a", "c"}, bufMgr);
+
+  // Print all tuples in result
+  project.print();
+  cout << "# I/Os: " << project.getNumIOs() << endl;
+}
+
+void testBatchPipeline(BufMgr* bufMgr, Catalog* catalog) {
+  TableId leftTableId = catalog->getTableId("r");
+  TableId rightTableId = catalog->getTableId("s");
+  TableSchema leftTableSchema = catalog->getTableSchema(leftTableId);
+  TableSchema rightTableSchema = catalog->getTableSchema(rightTableId);
+  File leftTableFile = File::open(catalog->getTableFilename(leftTableId));
+  File rightTableFile = File::open(catalog->getTableFilename(rightTableId));
+
+  // the same query as testPipeline, a batch of tuples at a time
+  unique_ptr<BatchOperator> leftScan(
+      new BatchScanOperator(leftTableFile, leftTableSchema, bufMgr, catalog));
+  unique_ptr<BatchOperator> rightScan(new BatchScanOperator(
+      rightTableFile, rightTableSchema, bufMgr, catalog));
+  unique_ptr<BatchOperator> join(new BatchHashJoinOperator(
+      std::move(leftScan), std::move(rightScan), bufMgr));
+  unique_ptr<BatchOperator> filter(
+      new BatchFilterOperator(std::move(join), "b", EQUAL, "7", bufMgr));
+  unique_ptr<BatchOperator> project(
+      new BatchProjectOperator(std::move(filter), {"a", "c"}, bufMgr));
+  BatchToRowOperator result(std::move(project), bufMgr);
+
+  // Print all tuples in result
+  result.print();
+  cout << "# I/Os: " << result.getNumIOs() << endl;
+}
+
+void testWideBatchScan() {
+  // tuples of about 1 KB in a small buffer pool, so that a batch of
+  // RowBatch::CAPACITY tuples would span more pages than the pool holds
+  BufMgr bufMgr(64);
+  TableSchema schema = TableSchema::fromSQLStatement(
+      "CREATE TABLE w (a INT, b CHAR(1000));");
+  string filename = "w.tbl";
+  File file = File::create(filename);
+  int rows = 3000;
+  vector<string> tuples;
+  for (int i = 0; i < rows; i++) {
+    vector<string> values = {to_string(i), "w" + to_string(i)};
+    tuples.push_back(HeapFileManager::createTupleFromValues(values, schema));
+  }
+  HeapFileManager::bulkInsertTuples(tuples, file, &bufMgr, nullptr);
+
+  int scanRows = 0;
+  {
+    TableScanOperator scan(file, schema, &bufMgr);
+    TupleView tuple;
+    scan.open();
+    while (scan.next(tuple)) {
+      scanRows++;
+    }
+    scan.close();
+  }
+  long long batchRows;
+  {
+    BatchScanOperator scan(file, schema, &bufMgr);
+    batchRows = scan.count();
+  }
+  cout << "# Tuples: " << rows << ", Scan: " << scanRows
+       << ", Batch Scan: " << batchRows << endl;
+  bufMgr.flushFile(&file);
+}
+
+void testHashAggregate(BufMgr* bufMgr, Catalog* catalog) {
+  TableId leftTableId = catalog->getTableId("r");
+  TableId rightTableId = catalog->getTableId("s");
+  TableSchema leftTableSchema = catalog->getTableSchema(leftTableId);
+  TableSchema rightTableSchema = catalog->getTableSchema(rightTableId);
+  File leftTableFile = File::open(catalog->getTableFilename(leftTableId));
+  File rightTableFile = File::open(catalog->getTableFilename(rightTableId));
+
+  // SELECT c, COUNT(*), SUM(b), AVG(b) FROM r JOIN s GROUP BY c
+  unique_ptr<Operator> leftScan(
+      new TableScanOperator(leftTableFile, leftTableSchema, bufMgr, catalog));
+  unique_ptr<Operator> rightScan(new TableScanOperator(
+      rightTableFile, rightTableSchema, bufMgr, catalog));
+  unique_ptr<Operator> join(new OnePassJoinOperator(
+      std::move(leftScan), std::move(rightScan), catalog, bufMgr));
+  HashAggregateOperator aggregate(
+      std::move(join), {"c"},
+      {Aggregate(AGG_COUNT), Aggregate(AGG_SUM, "b"),
+       Aggregate(AGG_AVG, "b")},
+      bufMgr);
+
+  // Print all tuples in result
+  aggregate.print();
+  aggregate.printRunningStats();
+}
+
 int main() {
   // Create buffer pool
   int availableBufPages = 256;
@@ -181,6 +324,28 @@ int main() {
   // cout << "Test Grace Hash Join ..." << endl;
   // testGraceHashJoin(bufMgr, catalog);
 
+  // Test a pipelined plan
+  cout << "Test Pipeline ..." << endl;
+  testPipeline(bufMgr, catalog);
+
+  // Test the same plan in the batch engine
+  cout << "Test Batch Pipeline ..." << endl;
+  testBatchPipeline(bufMgr, catalog);
+
+  // Test cost-based choice of the join operator
+  cout << "Test Join Planner ..." << endl;
+  testJoinPlanner(bufMgr, catalog, 3);
+  testJoinPlanner(bufMgr, catalog, 10);
+  testJoinPlanner(bufMgr, catalog, 50);
+
+  // Test the batch scan of tuples wider than a batch of pages
+  cout << "Test Wide Batch Scan ..." << endl;
+  testWideBatchScan();
+
+  // Test grouping and aggregation
+  cout << "Test Hash Aggregate ..." << endl;
+  testHashAggregate(bufMgr, catalog);
+
   // Destroy objects
   delete bufMgr;
   delete catalog;
@@ -10,6 +10,7 @@
  *     <li> @ref prereq_sec
  *     <li> @ref commands_sec
  *     <li> @ref modify_run_main_sec
+ *     <li> @ref bulk_load_sec
  *     <li> @ref documentation_sec
  *   </ol>
  *   <li> @ref api_sec
@@ -68,6 +69,24 @@
  * If you want to edit what <code>badgerdb_main</code> does, edit
  * <code>src/main.cpp</code>.
  *
+ * @subsection bulk_load_sec Bulk loading tables
+ *
+ * Tables can be created and filled from SQL dumps (CREATE TABLE and
+ * INSERT ... VALUES statements) and CSV files with <code>badgerdb_load</code>:
+ * @code
+ *   $ make load
+ *   $ ./src/badgerdb_load -j 4 college.sql SC=more_grades.csv
+ * @endcode
+ * Each table is stored in <code>&lt;table&gt;.tbl</code>. A CSV file is
+ * loaded into a table created by an earlier dump. The tables are recorded in
+ * the catalog file <code>badgerdb.cat</code> (see Catalog::save()), so later
+ * runs can add rows to them.
+ *
+ * The catalog also keeps page and tuple counts for every table, maintained by
+ * HeapFileManager. With <code>-a N</code> the loaded tables are analyzed
+ * afterwards (see HeapFileManager::analyzeTable()): N sampled pages per table,
+ * or all pages for 0, give min/max values, distinct counts and histograms.
+ *
  * @subsection documentation_sec Rebuilding the documentation
  *
  * Documentation is generated by using Doxygen.  If you have updated the
@@ -0,0 +1,321 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "operator.h"
+
+#include <iostream>
+
+#include "simd_scan.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+int Operator::materialize(File& file) {
+  HeapAppender appender(file, bufMgr, nullptr);
+  TupleView tuple;
+  open();
+  while (next(tuple)) {
+    appender.append(tuple.toString());
+  }
+  close();
+  appender.close();
+  return appender.getNumTuples();
+}
+
+void Operator::print() {
+  TupleLayout layout(schema);
+  vector<AttrSlot> slots(layout.getAttrCount());
+  TupleView tuple;
+  open();
+  while (next(tuple)) {
+    layout.locate(tuple.data, &slots[0]);
+    string print_key = "(";
+    for (int i = 0; i < layout.getAttrCount(); ++i) {
+      const char* value = tuple.data + slots[i].offset;
+      if (layout.getAttrType(i) == INT)
+        print_key += to_string(TupleLayout::decodeInt(value));
+      else
+        print_key.append(value, slots[i].length);
+      print_key += ",";
+    }
+    print_key[print_key.size() - 1] = ')';  // change the last ',' to ')'
+    cout << print_key << endl;
+  }
+  close();
+}
+
+void TableScanOperator::releasePage() {
+  if (pinnedPage != nullptr) {
+    bufMgr->unPinPage(&file, fileIter.page_number(), false);
+    pinnedPage = nullptr;
+  }
+}
+
+void TableScanOperator::open() {
+  close();
+  fileIter = file.begin();
+}
+
+bool TableScanOperator::next(TupleView& tuple) {
+  while (true) {
+    if (pinnedPage != nullptr) {
+      if (pageIter != pinnedPage->end()) {
+        std::uint16_t length;
+        tuple.data = pageIter.data(length);
+        tuple.size = length;
+        ++pageIter;
+        return true;
+      }
+      // the page is used up, move on to the next one
+      releasePage();
+      ++fileIter;
+    }
+    if (fileIter.page_number() == Page::INVALID_NUMBER)
+      return false;  // end of the file, or not opened
+    bufMgr->readPage(&file, fileIter.page_number(), pinnedPage);
+    numIOs++;
+    pageIter = pinnedPage->begin();
+  }
+}
+
+void TableScanOperator::close() {
+  releasePage();
+  // the frames are keyed by this operator's file handle
+  bufMgr->flushFile(&file);
+  fileIter = FileIterator();
+}
+
+int TableScanOperator::getEstimatedPages() const {
+  return HeapFileManager::getNumPages(file, catalog);
+}
+
+bool FilterOperator::next(TupleView& tuple) {
+  while (input->next(tuple)) {
+    if (predicate(tuple))
+      return true;
+  }
+  return false;
+}
+
+FilteredScanOperator::FilteredScanOperator(const File& tableFile,
+                                           const TableSchema& tableSchema,
+                                           const Predicate& predicate,
+                                           const vector<string>& attrNames,
+                                           BufMgr* bufMgr,
+                                           const Catalog* catalog)
+    : Operator(attrNames.empty() ? tableSchema
+                                 : ProjectOperator::createProjectedSchema(
+                                       tableSchema, attrNames),
+               bufMgr),
+      file(tableFile),
+      catalog(catalog),
+      layout(tableSchema),
+      predicate(predicate),
+      slots(layout.getAttrCount()),
+      nextPage(0),
+      pinnedPage(nullptr),
+      numPagesSkipped(0),
+      numPageSelected(0),
+      nextSelected(0) {
+  for (const string& attrName : attrNames) {
+    attrNums.push_back(tableSchema.getAttrNum(attrName));
+  }
+  hasIntRange = predicate.getIntRange(rangeOffset, rangeLow, rangeHigh);
+}
+
+const ZoneMap* FilteredScanOperator::findZoneMap() const {
+  TableId tableId;
+  if (catalog == nullptr ||
+      !catalog->getTableIdByFilename(file.filename(), tableId))
+    return nullptr;
+  return catalog->getZoneMap(tableId);
+}
+
+void FilteredScanOperator::releasePage() {
+  if (pinnedPage != nullptr) {
+    bufMgr->unPinPage(&file, pages[nextPage - 1], false);
+    pinnedPage = nullptr;
+  }
+}
+
+void FilteredScanOperator::open() {
+  close();
+  numPagesSkipped = 0;
+  const ZoneMap* zoneMap = predicate.isTrue() ? nullptr : findZoneMap();
+  // a page without a zone is read, it may have been written without the
+  // catalog
+  for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+    std::uint32_t zone;
+    if (zoneMap != nullptr && zoneMap->getZone(iter.page_number(), zone) &&
+        !predicate.mayMatch(*zoneMap, zone))
+      numPagesSkipped++;
+    else
+      pages.push_back(iter.page_number());
+  }
+}
+
+void FilteredScanOperator::selectPage() {
+  pageRecords.clear();
+  pageLengths.clear();
+  for (PageIterator iter = pinnedPage->begin(); iter != pinnedPage->end();
+       ++iter) {
+    std::uint16_t length;
+    pageRecords.push_back(iter.data(length));
+    pageLengths.push_back(length);
+  }
+  const int num_records = pageRecords.size();
+  pageBitmap.resize(IntScanKernels::getBitmapWords(num_records));
+  pageSelection.resize(num_records);
+  IntScanKernels::selectRecordsBetween(pageRecords.data(), num_records,
+                                       rangeOffset, rangeLow, rangeHigh,
+                                       pageBitmap.data());
+  numPageSelected = IntScanKernels::toSelection(
+      pageBitmap.data(), num_records, pageSelection.data());
+  nextSelected = 0;
+}
+
+bool FilteredScanOperator::nextSatisfying(const char*& data,
+                                          std::uint16_t& length) {
+  if (hasIntRange) {
+    if (nextSelected == numPageSelected)
+      return false;
+    std::uint16_t record = pageSelection[nextSelected++];
+    data = pageRecords[record];
+    length = pageLengths[record];
+    return true;
+  }
+  while (pageIter != pinnedPage->end()) {
+    data = pageIter.data(length);
+    ++pageIter;
+    if (predicate.evaluate(layout, data))
+      return true;
+  }
+  return false;
+}
+
+bool FilteredScanOperator::next(TupleView& tuple) {
+  while (true) {
+    if (pinnedPage != nullptr) {
+      const char* data;
+      std::uint16_t length;
+      if (nextSatisfying(data, length)) {
+        if (attrNums.empty()) {
+          tuple.data = data;
+          tuple.size = length;
+          return true;
+        }
+        layout.locate(data, &slots[0]);
+        outputTuple.clear();
+        for (int num : attrNums) {
+          layout.appendStored(data, slots[num], num, outputTuple);
+        }
+        tuple = TupleView(outputTuple);
+        return true;
+      }
+      // the page is used up, move on to the next one
+      releasePage();
+    }
+    if (nextPage == pages.size())
+      return false;  // end of the pages, or not opened
+    bufMgr->readPage(&file, pages[nextPage++], pinnedPage);
+    numIOs++;
+    if (hasIntRange)
+      selectPage();
+    else
+      pageIter = pinnedPage->begin();
+  }
+}
+
+void FilteredScanOperator::close() {
+  releasePage();
+  // the frames are keyed by this operator's file handle
+  bufMgr->flushFile(&file);
+  pages.clear();
+  nextPage = 0;
+}
+
+int FilteredScanOperator::getEstimatedPages() const {
+  int num_pages = HeapFileManager::getNumPages(file, catalog);
+  const ZoneMap* zoneMap = predicate.isTrue() ? nullptr : findZoneMap();
+  if (zoneMap == nullptr)
+    return num_pages;
+  for (std::uint32_t zone = 0; zone < zoneMap->getNumZones(); ++zone) {
+    if (!predicate.mayMatch(*zoneMap, zone))
+      num_pages--;
+  }
+  return max(num_pages, 0);
+}
+
+Predicate RangeScanOperator::createRangePredicate(
+    const TableSchema& tableSchema,
+    const string& attrName,
+    const string& low,
+    bool lowInclusive,
+    const string& high,
+    bool highInclusive) {
+  Predicate predicate;
+  if (!low.empty())
+    predicate = Predicate::compare(tableSchema, attrName,
+                                   lowInclusive ? GREATER_EQUAL : GREATER, low);
+  if (!high.empty())
+    predicate = Predicate::conjunction(
+        predicate, Predicate::compare(tableSchema, attrName,
+                                      highInclusive ? LESS_EQUAL : LESS, high));
+  return predicate;
+}
+
+function<bool(const TupleView&)> FilterOperator::attrEquals(
+    const TableSchema& tableSchema,
+    const string& attrName,
+    const string& value) {
+  // compare in place, through the kernel of the attribute type
+  Predicate predicate =
+      Predicate::compare(tableSchema, attrName, EQUAL, value);
+  TupleLayout layout(tableSchema);
+  return [layout, predicate](const TupleView& tuple) {
+    return predicate.evaluate(layout, tuple.data);
+  };
+}
+
+TableSchema ProjectOperator::createProjectedSchema(
+    const TableSchema& inputSchema,
+    const vector<string>& attrNames) {
+  vector<Attribute> attrs;
+  for (const string& attrName : attrNames) {
+    int num = inputSchema.getAttrNum(attrName);
+    attrs.push_back(Attribute(
+        attrName, inputSchema.getAttrType(num), inputSchema.getAttrMaxSize(num),
+        inputSchema.isAttrNotNull(num), inputSchema.isAttrUnique(num)));
+  }
+  return TableSchema("TEMP_TABLE", attrs, true);
+}
+
+ProjectOperator::ProjectOperator(unique_ptr<Operator> input,
+                                 const vector<string>& attrNames,
+                                 BufMgr* bufMgr)
+    : Operator(createProjectedSchema(input->getSchema(), attrNames), bufMgr),
+      input(std::move(input)),
+      inputLayout(this->input->getSchema()),
+      slots(inputLayout.getAttrCount()) {
+  for (const string& attrName : attrNames) {
+    attrNums.push_back(this->input->getSchema().getAttrNum(attrName));
+  }
+}
+
+bool ProjectOperator::next(TupleView& tuple) {
+  TupleView input_tuple;
+  if (!input->next(input_tuple))
+    return false;
+  inputLayout.locate(input_tuple.data, &slots[0]);
+  outputTuple.clear();
+  for (int num : attrNums) {
+    inputLayout.appendStored(input_tuple.data, slots[num], num, outputTuple);
+  }
+  tuple = TupleView(outputTuple);
+  return true;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,489 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "catalog.h"
+#include "file.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+#include "predicate.h"
+#include "schema.h"
+#include "tuple.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Iterator-style (Volcano) operator. A plan is a tree of operators: open()
+ * prepares an operator and its inputs, every next() call produces one tuple
+ * pulled through the tree, close() releases the resources. Tuples are
+ * handed out as views, so intermediate results stay in memory; they are
+ * only written to a file by materialize().
+ */
+class Operator {
+ protected:
+  /**
+   * Schema of the output tuples
+   */
+  TableSchema schema;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Number of I/Os carried out by this operator itself
+   */
+  int numIOs;
+
+ public:
+  /**
+   * Constructor
+   */
+  Operator(const TableSchema& schema, BufMgr* bufMgr)
+      : schema(schema), bufMgr(bufMgr), numIOs(0) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  virtual ~Operator() {
+    // nothing
+  }
+
+  /**
+   * Get the operator's name
+   */
+  virtual string getOperatorName() const = 0;
+
+  /**
+   * Get the schema of the output tuples
+   */
+  const TableSchema& getSchema() const { return schema; }
+
+  /**
+   * Prepare to produce tuples from the beginning. An operator may be opened
+   * again after close() to rescan its output.
+   */
+  virtual void open() = 0;
+
+  /**
+   * Produce the next tuple
+   * @param tuple Set to the tuple, valid until the next call to next() or
+   *              close()
+   * @return False if there are no more tuples
+   */
+  virtual bool next(TupleView& tuple) = 0;
+
+  /**
+   * Release the resources taken by open()
+   */
+  virtual void close() = 0;
+
+  /**
+   * Get the number of I/Os carried out by this operator and its inputs
+   */
+  virtual int getNumIOs() const { return numIOs; }
+
+  /**
+   * Get the estimated number of pages of the output
+   */
+  virtual int getEstimatedPages() const = 0;
+
+  /**
+   * Run the operator and write its output into a heap file that is no table
+   * of the catalog, such as a temporary file
+   * @return Number of tuples written
+   */
+  int materialize(File& file);
+
+  /**
+   * Run the operator and print its output
+   */
+  void print();
+};
+
+/**
+ * Sequential scan of a table file, reading one page at a time
+ */
+class TableScanOperator : public Operator {
+ private:
+  /**
+   * Own handle of the table file, the buffer pool frames are keyed by it
+   */
+  File file;
+
+  /**
+   * System catalog, used for page estimates if not null
+   */
+  const Catalog* catalog;
+
+  /**
+   * Current page in the file
+   */
+  FileIterator fileIter;
+
+  /**
+   * Current tuple in the pinned page
+   */
+  PageIterator pageIter;
+
+  /**
+   * Currently pinned page, or null
+   */
+  Page* pinnedPage;
+
+  /**
+   * Unpin the current page
+   */
+  void releasePage();
+
+ public:
+  /**
+   * Constructor
+   */
+  TableScanOperator(const File& tableFile,
+                    const TableSchema& tableSchema,
+                    BufMgr* bufMgr,
+                    const Catalog* catalog = nullptr)
+      : Operator(tableSchema, bufMgr),
+        file(tableFile),
+        catalog(catalog),
+        pinnedPage(nullptr) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  ~TableScanOperator() { close(); }
+
+  string getOperatorName() const { return "TABLE_SCAN"; }
+
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close();
+
+  int getEstimatedPages() const;
+};
+
+/**
+ * Scan of a table with a selection and a projection pushed into it. The
+ * predicate is evaluated on the tuples in the pinned page, and only the
+ * projected attributes of the qualifying ones are copied out; without a
+ * projection, the tuples are handed out as views into the page. If the
+ * table has a zone map, the pages it rules out are skipped without being
+ * read; pages it has no zone for are read.
+ */
+class FilteredScanOperator : public Operator {
+ private:
+  /**
+   * Own handle of the table file, the buffer pool frames are keyed by it
+   */
+  File file;
+
+  /**
+   * System catalog holding the zone map, or null
+   */
+  const Catalog* catalog;
+
+  /**
+   * Layout of the table
+   */
+  TupleLayout layout;
+
+  /**
+   * Predicate on the tuples of the table
+   */
+  Predicate predicate;
+
+  /**
+   * Table attribute number of every output attribute, empty to output
+   * whole tuples
+   */
+  vector<int> attrNums;
+
+  /**
+   * Attribute locations in the current tuple
+   */
+  vector<AttrSlot> slots;
+
+  /**
+   * Current output tuple of a projection
+   */
+  string outputTuple;
+
+  /**
+   * Pages read by the scan, in file order
+   */
+  vector<PageId> pages;
+
+  /**
+   * Next page in pages
+   */
+  size_t nextPage;
+
+  /**
+   * Current tuple in the pinned page
+   */
+  PageIterator pageIter;
+
+  /**
+   * Currently pinned page, or null
+   */
+  Page* pinnedPage;
+
+  /**
+   * Number of pages skipped by the last scan
+   */
+  int numPagesSkipped;
+
+  /**
+   * Is the predicate a range of an INT attribute, evaluated a page at a
+   * time by IntScanKernels? Then the offset of the attribute and the range.
+   */
+  bool hasIntRange;
+  int rangeOffset;
+  std::int32_t rangeLow;
+  std::int32_t rangeHigh;
+
+  /**
+   * Tuples of the pinned page and their lengths, for an INT range
+   */
+  vector<const char*> pageRecords;
+  vector<std::uint16_t> pageLengths;
+
+  /**
+   * Selection bitmap of the tuples of the pinned page, and the selected
+   * tuples in order
+   */
+  vector<std::uint64_t> pageBitmap;
+  vector<std::uint16_t> pageSelection;
+
+  /**
+   * Number of selected tuples of the pinned page, and the next one
+   */
+  int numPageSelected;
+  int nextSelected;
+
+  /**
+   * Get the zone map of the table, or null
+   */
+  const ZoneMap* findZoneMap() const;
+
+  /**
+   * Unpin the current page
+   */
+  void releasePage();
+
+  /**
+   * Evaluate the INT range on all tuples of the pinned page
+   */
+  void selectPage();
+
+  /**
+   * Get the next tuple of the pinned page satisfying the predicate
+   * @return False at the end of the page
+   */
+  bool nextSatisfying(const char*& data, std::uint16_t& length);
+
+ public:
+  /**
+   * Constructor
+   * @param attrNames Attributes to output, in order; empty for all
+   */
+  FilteredScanOperator(const File& tableFile,
+                       const TableSchema& tableSchema,
+                       const Predicate& predicate,
+                       const vector<string>& attrNames,
+                       BufMgr* bufMgr,
+                       const Catalog* catalog = nullptr);
+
+  /**
+   * Destructor
+   */
+  ~FilteredScanOperator() { close(); }
+
+  string getOperatorName() const { return "FILTERED_SCAN"; }
+
+  void open();
+
+  bool next(TupleView& tuple);
+
+  void close();
+
+  int getEstimatedPages() const;
+
+  /**
+   * Get the number of pages skipped by the last scan
+   */
+  int getNumPagesSkipped() const { return numPagesSkipped; }
+};
+
+/**
+ * Scan of the tuples of a table whose value of an attribute lies in a range.
+ * If the table has a zone map summarizing the attribute, the pages whose
+ * range cannot match are skipped without being read; otherwise every page
+ * is read.
+ */
+class RangeScanOperator : public FilteredScanOperator {
+ private:
+  /**
+   * Predicate of the range
+   */
+  static Predicate createRangePredicate(const TableSchema& tableSchema,
+                                        const string& attrName,
+                                        const string& low,
+                                        bool lowInclusive,
+                                        const string& high,
+                                        bool highInclusive);
+
+ public:
+  /**
+   * Constructor. The bounds are given as in an SQL statement, e.g. 42 or
+   * 'abc'; an empty bound is unbounded.
+   */
+  RangeScanOperator(const File& tableFile,
+                    const TableSchema& tableSchema,
+                    const string& attrName,
+                    const string& low,
+                    bool lowInclusive,
+                    const string& high,
+                    bool highInclusive,
+                    BufMgr* bufMgr,
+                    const Catalog* catalog = nullptr)
+      : FilteredScanOperator(tableFile,
+                             tableSchema,
+                             createRangePredicate(tableSchema, attrName, low,
+                                                  lowInclusive, high,
+                                                  highInclusive),
+                             vector<string>(),
+                             bufMgr,
+                             catalog) {
+    // nothing
+  }
+
+  string getOperatorName() const { return "RANGE_SCAN"; }
+};
+
+/**
+ * Selection: passes on the tuples of its input satisfying a predicate
+ */
+class FilterOperator : public Operator {
+ private:
+  /**
+   * Input operator
+   */
+  unique_ptr<Operator> input;
+
+  /**
+   * Predicate on the input tuples
+   */
+  function<bool(const TupleView&)> predicate;
+
+ public:
+  /**
+   * Constructor
+   */
+  FilterOperator(unique_ptr<Operator> input,
+                 const function<bool(const TupleView&)>& predicate,
+                 BufMgr* bufMgr)
+      : Operator(input->getSchema(), bufMgr),
+        input(std::move(input)),
+        predicate(predicate) {
+    // nothing
+  }
+
+  string getOperatorName() const { return "FILTER"; }
+
+  void open() { input->open(); }
+
+  bool next(TupleView& tuple);
+
+  void close() { input->close(); }
+
+  int getNumIOs() const { return numIOs + input->getNumIOs(); }
+
+  int getEstimatedPages() const { return input->getEstimatedPages(); }
+
+  /**
+   * Predicate comparing an attribute with a constant for equality. The
+   * value is given as in an SQL statement, e.g. 42 or 'abc'.
+   */
+  static function<bool(const TupleView&)> attrEquals(
+      const TableSchema& tableSchema,
+      const string& attrName,
+      const string& value);
+};
+
+/**
+ * Projection: keeps some attributes of its input tuples, in the given order
+ */
+class ProjectOperator : public Operator {
+ private:
+  /**
+   * Input operator
+   */
+  unique_ptr<Operator> input;
+
+  /**
+   * Layout of the input tuples
+   */
+  TupleLayout inputLayout;
+
+  /**
+   * Input attribute number of every output attribute
+   */
+  vector<int> attrNums;
+
+  /**
+   * Attribute locations in the current input tuple
+   */
+  vector<AttrSlot> slots;
+
+  /**
+   * Current output tuple
+   */
+  string outputTuple;
+
+ public:
+  /**
+   * Create the schema of some attributes of an input, in the given order
+   */
+  static TableSchema createProjectedSchema(const TableSchema& inputSchema,
+                                           const vector<string>& attrNames);
+
+  /**
+   * Constructor
+   */
+  ProjectOperator(unique_ptr<Operator> input,
+                  const vector<string>& attrNames,
+                  BufMgr* bufMgr);
+
+  string getOperatorName() const { return "PROJECT"; }
+
+  void open() { input->open(); }
+
+  bool next(TupleView& tuple);
+
+  void close() { input->close(); }
+
+  int getNumIOs() const { return numIOs + input->getNumIOs(); }
+
+  int getEstimatedPages() const { return input->getEstimatedPages(); }
+};
+
+}  // namespace badgerdb
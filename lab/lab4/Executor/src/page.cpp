@@ -46,6 +46,14 @@ std::string Page::getRecord(const RecordId& record_id) const {
   return data_.substr(slot.item_offset, slot.item_length);
 }
 
+const char* Page::getRecordData(const RecordId& record_id,
+                                std::uint16_t& length) const {
+  validateRecordId(record_id);
+  const PageSlot& slot = getSlot(record_id.slot_number);
+  length = slot.item_length;
+  return data_.data() + slot.item_offset;
+}
+
 void Page::updateRecord(const RecordId& record_id,
                         const std::string& record_data) {
   validateRecordId(record_id);
@@ -184,7 +192,9 @@ void Page::insertRecordInSlot(const SlotId slot_number,
 }
 
 void Page::validateRecordId(const RecordId& record_id) const {
-  if (record_id.page_number != page_number()) {
+  if (record_id.page_number != page_number() ||
+      record_id.slot_number == INVALID_SLOT ||
+      record_id.slot_number > header_.num_slots) {
     throw InvalidRecordException(record_id, page_number());
   }
   const PageSlot& slot = getSlot(record_id.slot_number);
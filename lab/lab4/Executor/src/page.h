@@ -150,6 +150,18 @@ namespace badgerdb {
          */
         std::string getRecord(const RecordId &record_id) const;
 
+        /**
+         * Returns the bytes of the record with the given ID without copying
+         * them.  The pointer stays valid until the page is changed or leaves
+         * the buffer pool.
+         *
+         * @param record_id  ID of the record to return.
+         * @param length     Set to the length of the record.
+         * @return  Pointer to the first byte of the record.
+         */
+        const char* getRecordData(const RecordId &record_id,
+                                  std::uint16_t &length) const;
+
         /**
          * Updates the record with the given ID, replacing its data with a new
          * version.  This is equivalent to deleting the old record and inserting a
@@ -101,6 +101,15 @@ class PageIterator {
 		return page_->getRecord(current_record_); 
 	}
 
+  /**
+   * Returns the bytes of the current record without copying them.
+   *
+   * @param length  Set to the length of the record.
+   */
+  inline const char* data(std::uint16_t& length) const {
+    return page_->getRecordData(current_record_, length);
+  }
+
   /**
    * Returns the next used slot in the page after the given slot or
    * Page::INVALID_SLOT if no slots are used after the given slot.
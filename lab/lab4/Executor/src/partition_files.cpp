@@ -0,0 +1,50 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "partition_files.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+atomic<int> PartitionFiles::numNamedFiles(0);
+
+void PartitionFiles::create(const string& prefix, int numFiles) {
+  close();
+  filenames.clear();
+  numPages.assign(numFiles, 0);
+  files.reserve(numFiles);
+  for (int i = 0; i < numFiles; ++i) {
+    string filename;
+    do {
+      filename = prefix + ".part" + to_string(numNamedFiles++);
+    } while (File::exists(filename));
+    filenames.push_back(filename);
+    files.push_back(File::create(filename));
+    appenders.push_back(unique_ptr<HeapAppender>(
+        new HeapAppender(files.back(), bufMgr, nullptr)));
+  }
+}
+
+void PartitionFiles::close() {
+  for (size_t i = 0; i < appenders.size(); ++i) {
+    appenders[i]->close();
+    numPages[i] = appenders[i]->getNumPages();
+  }
+  // the appenders reference the files
+  appenders.clear();
+  files.clear();
+}
+
+void PartitionFiles::remove() {
+  close();
+  for (const string& filename : filenames) {
+    if (File::exists(filename))
+      File::remove(filename);
+  }
+  filenames.clear();
+  numPages.clear();
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,129 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Temporary heap files written side by side through the buffer pool: the
+ * partitions of a hash join or a hash aggregation, or the result files of
+ * the workers of a parallel join. Every file is written by a HeapAppender of
+ * its own, which keeps its tail page pinned, so n open files take n buffer
+ * pages. Closing the files keeps their names and page counts; they stay on
+ * disk until deleted.
+ */
+class PartitionFiles {
+ private:
+  /**
+   * Number of files named so far in the process, so that no two operators or
+   * workers pick the same name
+   */
+  static atomic<int> numNamedFiles;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Names of the files
+   */
+  vector<string> filenames;
+
+  /**
+   * Open files and their appenders, empty once closed. The files are
+   * referenced by address in the buffer pool, so the vector must not
+   * reallocate.
+   */
+  vector<File> files;
+  vector<unique_ptr<HeapAppender>> appenders;
+
+  /**
+   * Number of pages of every file, known once closed
+   */
+  vector<int> numPages;
+
+ public:
+  /**
+   * Constructor of an empty set of files
+   */
+  explicit PartitionFiles(BufMgr* bufMgr) : bufMgr(bufMgr) {
+    // nothing
+  }
+
+  /**
+   * Not copyable, the buffer pool frames are keyed by the files' addresses
+   */
+  PartitionFiles(const PartitionFiles&) = delete;
+  PartitionFiles& operator=(const PartitionFiles&) = delete;
+
+  /**
+   * Destructor. Closes the files, without deleting them.
+   */
+  ~PartitionFiles() { close(); }
+
+  /**
+   * Create numFiles new files named prefix.partN, in place of the previous
+   * ones, which are closed but not deleted
+   */
+  void create(const string& prefix, int numFiles);
+
+  /**
+   * Get the number of files
+   */
+  int getNumFiles() const { return filenames.size(); }
+
+  /**
+   * Append a tuple to an open file. Appends to one file must not run
+   * concurrently.
+   */
+  void append(int file, const string& tuple) {
+    appenders[file]->append(tuple);
+  }
+
+  /**
+   * Write an open file back and unpin its tail page; later appends resume
+   * on its last page
+   */
+  void flush(int file) { appenders[file]->close(); }
+
+  /**
+   * Are the files open?
+   */
+  bool isOpen() const { return !appenders.empty(); }
+
+  /**
+   * Close the files, writing their pages back
+   */
+  void close();
+
+  /**
+   * Get the name of a file
+   */
+  const string& getFilename(int file) const { return filenames[file]; }
+
+  /**
+   * Get the number of pages of a closed file
+   */
+  int getNumPages(int file) const { return numPages[file]; }
+
+  /**
+   * Close the files and delete those still on disk, forgetting all of them
+   */
+  void remove();
+};
+
+}  // namespace badgerdb
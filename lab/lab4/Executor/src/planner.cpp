@@ -0,0 +1,146 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "storage.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+vector<JoinCost> JoinPlanner::estimateCosts(int leftPages,
+                                            int rightPages,
+                                            int numBufPages) {
+  // S is the smaller table, M the number of buffer pages
+  const double bs = min(leftPages, rightPages);
+  const double br = max(leftPages, rightPages);
+  const int m = numBufPages;
+  vector<JoinCost> costs;
+
+  // one pass: S is read into M - 1 pages, R streams through the last one
+  costs.push_back({ONE_PASS_JOIN, bs <= m - 1, true, bs + br});
+
+  // block nested loop: R is read once per M - 1 pages of S
+  costs.push_back(
+      {NESTED_LOOP_JOIN, m >= 2, true, bs + ceil(bs / max(m - 1, 1)) * br});
+
+  // Grace hash: every partitioning pass reads and writes both tables into
+  // M - 1 buckets, until a bucket of S fits in memory and is joined in a
+  // final pass
+  int passes = 1;
+  for (double bucket = ceil(bs / max(m - 1, 1)); bucket > m - 1 && m > 2;
+       bucket = ceil(bucket / (m - 1))) {
+    passes++;
+  }
+  costs.push_back({GRACE_HASH_JOIN, m >= 3, true, (2 * passes + 1) * (bs + br)});
+
+  // sort-merge: sorted runs of M pages are written, merged until all runs
+  // of both tables fit in M - 1 input pages and joined while merging
+  double io = 3 * (bs + br);
+  double runs_r = ceil(br / m), runs_s = ceil(bs / m);
+  while (runs_r + runs_s > m - 1 && m > 2) {
+    io += 2 * (runs_r > 1 ? br : 0) + 2 * (runs_s > 1 ? bs : 0);
+    runs_r = ceil(runs_r / (m - 1));
+    runs_s = ceil(runs_s / (m - 1));
+  }
+  costs.push_back({SORT_MERGE_JOIN, m >= 3, false, io});
+  return costs;
+}
+
+JoinPlan JoinPlanner::plan(const File& leftTableFile,
+                           const TableSchema& leftTableSchema,
+                           const File& rightTableFile,
+                           const TableSchema& rightTableSchema,
+                           int numAvailableBufPages) const {
+  JoinPlan plan;
+  plan.leftTableName = leftTableSchema.getTableName();
+  plan.rightTableName = rightTableSchema.getTableName();
+  plan.leftPages = HeapFileManager::getNumPages(leftTableFile, catalog);
+  plan.rightPages = HeapFileManager::getNumPages(rightTableFile, catalog);
+  plan.numBufPages = numAvailableBufPages;
+  plan.costs =
+      estimateCosts(plan.leftPages, plan.rightPages, numAvailableBufPages);
+
+  // ties go to the algorithm listed first, which needs less CPU
+  const JoinCost* best = nullptr;
+  for (const JoinCost& cost : plan.costs) {
+    if (cost.isFeasible && cost.isExecutable &&
+        (best == nullptr || cost.numIOs < best->numIOs))
+      best = &cost;
+  }
+  if (best == nullptr)
+    best = &plan.costs[NESTED_LOOP_JOIN];
+  plan.method = best->method;
+  plan.predictedIOs = best->numIOs;
+  return plan;
+}
+
+unique_ptr<JoinOperator> JoinPlanner::createJoinOperator(
+    const JoinPlan& plan,
+    File& leftTableFile,
+    File& rightTableFile,
+    const TableSchema& leftTableSchema,
+    const TableSchema& rightTableSchema) const {
+  switch (plan.method) {
+    case ONE_PASS_JOIN:
+      return unique_ptr<JoinOperator>(
+          new OnePassJoinOperator(leftTableFile, rightTableFile,
+                                  leftTableSchema, rightTableSchema, catalog,
+                                  bufMgr));
+    case GRACE_HASH_JOIN:
+      return unique_ptr<JoinOperator>(
+          new GraceHashJoinOperator(leftTableFile, rightTableFile,
+                                    leftTableSchema, rightTableSchema,
+                                    catalog, bufMgr));
+    default:
+      return unique_ptr<JoinOperator>(
+          new NestedLoopJoinOperator(leftTableFile, rightTableFile,
+                                     leftTableSchema, rightTableSchema,
+                                     catalog, bufMgr));
+  }
+}
+
+string JoinPlanner::getMethodName(JoinMethod method) {
+  switch (method) {
+    case ONE_PASS_JOIN:
+      return "ONE_PASS_JOIN";
+    case NESTED_LOOP_JOIN:
+      return "NESTED_LOOP_JOIN";
+    case GRACE_HASH_JOIN:
+      return "GRACE_HASH_JOIN";
+    case SORT_MERGE_JOIN:
+      return "SORT_MERGE_JOIN";
+  }
+  return "JOIN";
+}
+
+string JoinPlanner::explain(const JoinPlan& plan,
+                            const JoinOperator* joinOperator) {
+  stringstream ss;
+  ss << "EXPLAIN " << plan.leftTableName << " (" << plan.leftPages
+     << " pages) JOIN " << plan.rightTableName << " (" << plan.rightPages
+     << " pages), M = " << plan.numBufPages << ": "
+     << getMethodName(plan.method) << ", predicted I/Os "
+     << (long long)plan.predictedIOs;
+  if (joinOperator != nullptr && joinOperator->isCompleted())
+    ss << ", actual I/Os " << joinOperator->getNumIOs();
+  ss << " [";
+  for (size_t i = 0; i < plan.costs.size(); ++i) {
+    const JoinCost& cost = plan.costs[i];
+    ss << (i > 0 ? ", " : "") << getMethodName(cost.method) << " ";
+    if (!cost.isFeasible)
+      ss << "-";
+    else
+      ss << (long long)cost.numIOs << (cost.isExecutable ? "" : "*");
+  }
+  ss << "]";
+  return ss.str();
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,168 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "catalog.h"
+#include "executor.h"
+#include "file.h"
+#include "schema.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Join algorithms known to the planner
+ */
+enum JoinMethod {
+  ONE_PASS_JOIN,
+  NESTED_LOOP_JOIN,
+  GRACE_HASH_JOIN,
+  SORT_MERGE_JOIN
+};
+
+/**
+ * Estimated cost of a join algorithm
+ */
+struct JoinCost {
+  /**
+   * Join algorithm
+   */
+  JoinMethod method;
+
+  /**
+   * Can the algorithm run with the given buffer pages?
+   */
+  bool isFeasible;
+
+  /**
+   * Is there an operator implementing the algorithm?
+   */
+  bool isExecutable;
+
+  /**
+   * Estimated number of I/Os, not counting writing the result
+   */
+  double numIOs;
+};
+
+/**
+ * Join algorithm chosen by the planner
+ */
+struct JoinPlan {
+  /**
+   * Names of the input tables
+   */
+  string leftTableName;
+  string rightTableName;
+
+  /**
+   * Number of pages of the input tables
+   */
+  int leftPages;
+  int rightPages;
+
+  /**
+   * Number of buffer pages given to the operator
+   */
+  int numBufPages;
+
+  /**
+   * Chosen algorithm
+   */
+  JoinMethod method;
+
+  /**
+   * Estimated I/Os of the chosen algorithm
+   */
+  double predictedIOs;
+
+  /**
+   * Estimates of all algorithms considered
+   */
+  vector<JoinCost> costs;
+};
+
+/**
+ * Cost-based join planner. Page counts come from the catalog statistics and
+ * the I/O of every algorithm is estimated with the textbook formulas in
+ * terms of B(R), B(S) and the number of buffer pages M.
+ */
+class JoinPlanner {
+ private:
+  /**
+   * System catalog
+   */
+  const Catalog* catalog;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+ public:
+  /**
+   * Constructor
+   */
+  JoinPlanner(const Catalog* catalog, BufMgr* bufMgr)
+      : catalog(catalog), bufMgr(bufMgr) {
+    // nothing
+  }
+
+  /**
+   * Destructor
+   */
+  ~JoinPlanner() {
+    // nothing
+  }
+
+  /**
+   * Estimate the I/Os of every join algorithm
+   */
+  static vector<JoinCost> estimateCosts(int leftPages,
+                                        int rightPages,
+                                        int numBufPages);
+
+  /**
+   * Choose the cheapest executable join algorithm for two tables
+   */
+  JoinPlan plan(const File& leftTableFile,
+                const TableSchema& leftTableSchema,
+                const File& rightTableFile,
+                const TableSchema& rightTableSchema,
+                int numAvailableBufPages) const;
+
+  /**
+   * Create the operator carrying out a plan
+   */
+  unique_ptr<JoinOperator> createJoinOperator(
+      const JoinPlan& plan,
+      File& leftTableFile,
+      File& rightTableFile,
+      const TableSchema& leftTableSchema,
+      const TableSchema& rightTableSchema) const;
+
+  /**
+   * Get the name of a join algorithm, as returned by the operators'
+   * getOperatorName()
+   */
+  static string getMethodName(JoinMethod method);
+
+  /**
+   * Describe a plan in one line, with the actual I/Os of the operator if it
+   * has been executed. The estimates of all algorithms follow in brackets:
+   * "-" marks algorithms lacking buffer pages, "*" estimates without an
+   * operator.
+   */
+  static string explain(const JoinPlan& plan,
+                        const JoinOperator* joinOperator = nullptr);
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,246 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "predicate.h"
+
+#include "key_kernels.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+string Predicate::makeKey(const TableSchema& tableSchema,
+                          int attrNum,
+                          const string& value,
+                          string* stored) {
+  string token = value;
+  if (token.size() >= 2 && token[0] == '\'' && token.back() == '\'')
+    token = token.substr(1, token.size() - 2);
+  // built through a one-attribute tuple
+  vector<Attribute> attrs;
+  attrs.push_back(Attribute(tableSchema.getAttrName(attrNum),
+                            tableSchema.getAttrType(attrNum),
+                            tableSchema.getAttrMaxSize(attrNum)));
+  TableSchema value_schema("VALUE", attrs, true);
+  TupleLayout value_layout(value_schema);
+  string value_tuple =
+      HeapFileManager::createTupleFromValues(vector<string>(1, token),
+                                             value_schema);
+  AttrSlot slot = value_layout.locate(value_tuple.data(), 0);
+  if (stored != nullptr)
+    stored->assign(value_tuple, slot.offset, slot.length);
+  string key;
+  value_layout.appendNormalized(value_tuple.data(), slot, 0, key);
+  return key;
+}
+
+Predicate Predicate::compare(const TableSchema& tableSchema,
+                             const string& attrName,
+                             CompareOp op,
+                             const string& value) {
+  Node node;
+  node.kind = COMPARE;
+  node.left = node.right = -1;
+  node.op = op;
+  node.attrNum = tableSchema.getAttrNum(attrName);
+  node.attrType = tableSchema.getAttrType(node.attrNum);
+  node.fixedOffset = TupleLayout(tableSchema).getFixedOffset(node.attrNum);
+  // the constant is parsed once, into its key and its stored bytes
+  node.key = makeKey(tableSchema, node.attrNum, value, &node.value);
+  node.test = findTest(node.attrType, op);
+  Predicate predicate;
+  predicate.nodes.push_back(node);
+  return predicate;
+}
+
+int Predicate::appendNodes(const Predicate& other) {
+  const int base = nodes.size();
+  for (Node node : other.nodes) {
+    if (node.left >= 0)
+      node.left += base;
+    if (node.right >= 0)
+      node.right += base;
+    nodes.push_back(node);
+  }
+  return nodes.size() - 1;
+}
+
+Predicate Predicate::conjunction(const Predicate& left,
+                                 const Predicate& right) {
+  if (left.isTrue())
+    return right;
+  if (right.isTrue())
+    return left;
+  Predicate predicate;
+  Node node;
+  node.kind = AND;
+  node.left = predicate.appendNodes(left);
+  node.right = predicate.appendNodes(right);
+  predicate.nodes.push_back(node);
+  return predicate;
+}
+
+Predicate Predicate::disjunction(const Predicate& left,
+                                 const Predicate& right) {
+  if (left.isTrue() || right.isTrue())
+    return Predicate();
+  Predicate predicate;
+  Node node;
+  node.kind = OR;
+  node.left = predicate.appendNodes(left);
+  node.right = predicate.appendNodes(right);
+  predicate.nodes.push_back(node);
+  return predicate;
+}
+
+Predicate Predicate::negation(const Predicate& predicate) {
+  Predicate negated;
+  Node node;
+  node.kind = NOT;
+  node.left = predicate.isTrue() ? -1 : negated.appendNodes(predicate);
+  node.right = -1;
+  negated.nodes.push_back(node);
+  return negated;
+}
+
+bool Predicate::evaluateNode(int node,
+                             const TupleLayout& layout,
+                             const char* tuple) const {
+  const Node& n = nodes[node];
+  switch (n.kind) {
+    case AND:
+      return evaluateNode(n.left, layout, tuple) &&
+             evaluateNode(n.right, layout, tuple);
+    case OR:
+      return evaluateNode(n.left, layout, tuple) ||
+             evaluateNode(n.right, layout, tuple);
+    case NOT:
+      // the negation of true has no child
+      return n.left >= 0 && !evaluateNode(n.left, layout, tuple);
+    case COMPARE:
+      break;
+  }
+  return n.test(n, layout, tuple);
+}
+
+template <DataType TYPE, CompareOp OP>
+bool Predicate::testNode(const Node& node,
+                         const TupleLayout& layout,
+                         const char* tuple) {
+  AttrSlot slot =
+      AttrKernels<TYPE>::locate(layout, tuple, node.attrNum, node.fixedOffset);
+  // with OP known, satisfies folds into a single comparison
+  return satisfies(OP, AttrKernels<TYPE>::compare(
+                           tuple + slot.offset, slot.length,
+                           node.value.data(), node.value.size()));
+}
+
+Predicate::NodeTest Predicate::findTest(DataType type, CompareOp op) {
+  // indexed by DataType, then by CompareOp
+  static const NodeTest tests[3][6] = {
+      {&testNode<INT, EQUAL>, &testNode<INT, NOT_EQUAL>, &testNode<INT, LESS>,
+       &testNode<INT, LESS_EQUAL>, &testNode<INT, GREATER>,
+       &testNode<INT, GREATER_EQUAL>},
+      {&testNode<CHAR, EQUAL>, &testNode<CHAR, NOT_EQUAL>,
+       &testNode<CHAR, LESS>, &testNode<CHAR, LESS_EQUAL>,
+       &testNode<CHAR, GREATER>, &testNode<CHAR, GREATER_EQUAL>},
+      {&testNode<VARCHAR, EQUAL>, &testNode<VARCHAR, NOT_EQUAL>,
+       &testNode<VARCHAR, LESS>, &testNode<VARCHAR, LESS_EQUAL>,
+       &testNode<VARCHAR, GREATER>, &testNode<VARCHAR, GREATER_EQUAL>}};
+  return tests[type][op];
+}
+
+bool Predicate::getIntRange(int& offset,
+                            std::int32_t& low,
+                            std::int32_t& high) const {
+  if (nodes.empty())
+    return false;
+  low = INT32_MIN;
+  high = INT32_MAX;
+  bool empty = false;
+  const Node* first = nullptr;
+  for (const Node& n : nodes) {
+    if (n.kind == AND)
+      continue;
+    if (n.kind != COMPARE || n.attrType != INT || n.fixedOffset < 0 ||
+        n.op == NOT_EQUAL)
+      return false;
+    if (first == nullptr)
+      first = &n;
+    else if (n.attrNum != first->attrNum)
+      return false;
+    std::int32_t constant = TupleLayout::decodeInt(n.value.data());
+    switch (n.op) {
+      case EQUAL:
+        low = max(low, constant);
+        high = min(high, constant);
+        break;
+      case LESS:
+        if (constant == INT32_MIN)
+          empty = true;  // no value is less
+        else
+          high = min(high, constant - 1);
+        break;
+      case LESS_EQUAL:
+        high = min(high, constant);
+        break;
+      case GREATER:
+        if (constant == INT32_MAX)
+          empty = true;  // no value is greater
+        else
+          low = max(low, constant + 1);
+        break;
+      case GREATER_EQUAL:
+        low = max(low, constant);
+        break;
+      case NOT_EQUAL:
+        break;
+    }
+  }
+  if (empty) {
+    low = INT32_MAX;
+    high = INT32_MIN;
+  }
+  offset = first->fixedOffset;
+  return true;
+}
+
+bool Predicate::mayMatchNode(int node,
+                             const ZoneMap& zoneMap,
+                             std::uint32_t zone) const {
+  const Node& n = nodes[node];
+  switch (n.kind) {
+    case AND:
+      return mayMatchNode(n.left, zoneMap, zone) &&
+             mayMatchNode(n.right, zoneMap, zone);
+    case OR:
+      return mayMatchNode(n.left, zoneMap, zone) ||
+             mayMatchNode(n.right, zoneMap, zone);
+    case NOT:
+      return true;
+    case COMPARE:
+      break;
+  }
+  if (!zoneMap.hasAttr(n.attrNum))
+    return true;
+  const string unbounded;
+  switch (n.op) {
+    case EQUAL:
+      return zoneMap.mayMatch(zone, n.attrNum, n.key, true, n.key, true);
+    case LESS:
+      return zoneMap.mayMatch(zone, n.attrNum, unbounded, true, n.key, false);
+    case LESS_EQUAL:
+      return zoneMap.mayMatch(zone, n.attrNum, unbounded, true, n.key, true);
+    case GREATER:
+      return zoneMap.mayMatch(zone, n.attrNum, n.key, false, unbounded, true);
+    case GREATER_EQUAL:
+      return zoneMap.mayMatch(zone, n.attrNum, n.key, true, unbounded, true);
+    case NOT_EQUAL:
+      break;
+  }
+  return true;
+}
+
+}  // namespace badgerdb
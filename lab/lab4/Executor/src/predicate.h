@@ -0,0 +1,230 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "schema.h"
+#include "tuple.h"
+#include "zone_map.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Comparison of an attribute with a constant
+ */
+enum CompareOp { EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL };
+
+/**
+ * Predicate on the tuples of a table, compiled from comparisons of
+ * attributes with constants combined by AND, OR and NOT. It is evaluated on
+ * the stored bytes of a tuple, e.g. in a pinned page: INT values are decoded
+ * in place and CHAR and VARCHAR values compared against the constant
+ * prepared at compile time, without building the tuple or its keys. Each
+ * comparison is evaluated by a kernel instantiated for its attribute type
+ * and op, see AttrKernels.
+ *
+ * The nodes of the tree are stored in a vector, children before parents,
+ * and the last node is the root. A predicate without nodes is true.
+ */
+class Predicate {
+ private:
+  /**
+   * Kinds of nodes
+   */
+  enum NodeKind { COMPARE, AND, OR, NOT };
+
+  struct Node;
+
+  /**
+   * Kernel evaluating a comparison on a tuple
+   */
+  typedef bool (*NodeTest)(const Node& node,
+                           const TupleLayout& layout,
+                           const char* tuple);
+
+  /**
+   * A node of the tree
+   */
+  struct Node {
+    NodeKind kind;
+
+    /**
+     * Children of AND, OR and NOT nodes
+     */
+    int left;
+    int right;
+
+    /**
+     * Comparison of a COMPARE node
+     */
+    CompareOp op;
+    int attrNum;
+    DataType attrType;
+
+    /**
+     * Offset of the attribute in a tuple, or -1 if it depends on the tuple
+     */
+    int fixedOffset;
+
+    /**
+     * Constant: as stored for INT and CHAR, as the characters for VARCHAR,
+     * and as a normalized key
+     */
+    string value;
+    string key;
+
+    /**
+     * Kernel evaluating the comparison, for its type and op
+     */
+    NodeTest test;
+  };
+
+  /**
+   * Nodes, children before parents
+   */
+  vector<Node> nodes;
+
+  /**
+   * Append the nodes of another predicate, returning its root
+   */
+  int appendNodes(const Predicate& other);
+
+  /**
+   * Evaluate a comparison of an attribute of type TYPE by op OP on a tuple
+   */
+  template <DataType TYPE, CompareOp OP>
+  static bool testNode(const Node& node,
+                       const TupleLayout& layout,
+                       const char* tuple);
+
+  /**
+   * Get the kernel of comparisons of an attribute type by an op
+   */
+  static NodeTest findTest(DataType type, CompareOp op);
+
+  /**
+   * Evaluate the subtree of a node on a tuple
+   */
+  bool evaluateNode(int node,
+                    const TupleLayout& layout,
+                    const char* tuple) const;
+
+  /**
+   * May a zone hold a tuple satisfying the subtree of a node?
+   */
+  bool mayMatchNode(int node, const ZoneMap& zoneMap, std::uint32_t zone) const;
+
+ public:
+  /**
+   * Constructor of the predicate true
+   */
+  Predicate() {
+    // nothing
+  }
+
+  /**
+   * Comparison of an attribute with a constant, given as in an SQL
+   * statement, e.g. 42 or 'abc'
+   */
+  static Predicate compare(const TableSchema& tableSchema,
+                           const string& attrName,
+                           CompareOp op,
+                           const string& value);
+
+  /**
+   * Both predicates, the left one evaluated first
+   */
+  static Predicate conjunction(const Predicate& left, const Predicate& right);
+
+  /**
+   * Either predicate, the left one evaluated first
+   */
+  static Predicate disjunction(const Predicate& left, const Predicate& right);
+
+  /**
+   * Negation of a predicate
+   */
+  static Predicate negation(const Predicate& predicate);
+
+  /**
+   * Is the predicate true for every tuple?
+   */
+  bool isTrue() const { return nodes.empty(); }
+
+  /**
+   * Evaluate the predicate on a tuple in the layout of the table
+   */
+  bool evaluate(const TupleLayout& layout, const char* tuple) const {
+    return nodes.empty() || evaluateNode(nodes.size() - 1, layout, tuple);
+  }
+
+  /**
+   * May a zone of a zone map of the table hold a tuple satisfying the
+   * predicate? Comparisons on attributes the zone map does not summarize,
+   * NOT_EQUAL and NOT are taken as possibly true.
+   */
+  bool mayMatch(const ZoneMap& zoneMap, std::uint32_t zone) const {
+    return nodes.empty() || mayMatchNode(nodes.size() - 1, zoneMap, zone);
+  }
+
+  /**
+   * Is the predicate a range of one INT attribute at a fixed offset in the
+   * tuple, i.e. a conjunction of comparisons of it other than NOT_EQUAL? A
+   * scan then evaluates it a page at a time, see IntScanKernels.
+   * @param offset Receives the offset of the attribute
+   * @param low, high Receive the range, low > high if it is empty
+   */
+  bool getIntRange(int& offset, std::int32_t& low, std::int32_t& high) const;
+
+  /**
+   * Get the normalized key of a constant for an attribute, given as in an
+   * SQL statement
+   * @param stored If not null, receives the constant in the form compared
+   *               with the attribute values: as stored for INT and CHAR, as
+   *               the characters for VARCHAR
+   */
+  static string makeKey(const TableSchema& tableSchema,
+                        int attrNum,
+                        const string& value,
+                        string* stored = nullptr);
+
+  /**
+   * Compare characters like strcmp
+   */
+  static int compareChars(const char* chars, int length, const string& value) {
+    int cmp = memcmp(chars, value.data(), min<size_t>(length, value.size()));
+    return cmp != 0 ? cmp : length - (int)value.size();
+  }
+
+  /**
+   * Does the result of a comparison satisfy op?
+   */
+  static bool satisfies(CompareOp op, int cmp) {
+    switch (op) {
+      case EQUAL:
+        return cmp == 0;
+      case NOT_EQUAL:
+        return cmp != 0;
+      case LESS:
+        return cmp < 0;
+      case LESS_EQUAL:
+        return cmp <= 0;
+      case GREATER:
+        return cmp > 0;
+      case GREATER_EQUAL:
+        return cmp >= 0;
+    }
+    return false;
+  }
+};
+
+}  // namespace badgerdb
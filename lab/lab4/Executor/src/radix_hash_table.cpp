@@ -0,0 +1,125 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "radix_hash_table.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace badgerdb {
+
+const std::uint32_t RadixHashTable::CACHE_BYTES;
+const int RadixHashTable::MAX_PASS_BITS;
+
+void RadixHashTable::reset(int numWords) {
+  keyWords = numWords;
+  keys.clear();
+  entries.clear();
+  partitionDirs.clear();
+  partitionMasks.clear();
+  bucketStarts.clear();
+  firstPassBits = secondPassBits = 0;
+}
+
+void RadixHashTable::insert(const std::uint32_t* key) {
+  Entry entry = {hashKey(key, keyWords), (std::uint32_t)entries.size()};
+  entries.push_back(entry);
+  keys.insert(keys.end(), key, key + keyWords);
+}
+
+void RadixHashTable::scatter(const Entry* in,
+                             Entry* out,
+                             std::uint32_t size,
+                             int shift,
+                             int bits,
+                             vector<std::uint32_t>& counts) {
+  const std::uint32_t mask = (1u << bits) - 1;
+  counts.assign((1u << bits) + 1, 0);
+  for (std::uint32_t i = 0; i < size; ++i) {
+    counts[((in[i].hash >> shift) & mask) + 1]++;
+  }
+  for (std::uint32_t g = 1; g < counts.size(); ++g) {
+    counts[g] += counts[g - 1];
+  }
+  vector<std::uint32_t> next(counts.begin(), counts.end() - 1);
+  for (std::uint32_t i = 0; i < size; ++i) {
+    out[next[(in[i].hash >> shift) & mask]++] = in[i];
+  }
+}
+
+void RadixHashTable::build() {
+  const std::uint32_t n = entries.size();
+  // an entry and about one bucket per row; partition until the buckets of
+  // a partition fit in the cache
+  int bits = 0;
+  while ((size_t)(n >> bits) * (sizeof(Entry) + sizeof(std::uint32_t)) >
+             CACHE_BYTES &&
+         bits < 2 * MAX_PASS_BITS) {
+    bits++;
+  }
+  firstPassBits = min(bits, MAX_PASS_BITS);
+  secondPassBits = bits - firstPassBits;
+
+  vector<Entry> scratch(n);
+  vector<std::uint32_t> partition_starts;
+  if (bits == 0) {
+    partition_starts.push_back(0);
+  } else {
+    vector<std::uint32_t> first_counts, second_counts;
+    scatter(entries.data(), scratch.data(), n, 0, firstPassBits,
+            first_counts);
+    if (secondPassBits == 0) {
+      entries.swap(scratch);
+      partition_starts.assign(first_counts.begin(), first_counts.end() - 1);
+    } else {
+      // split every partition of the first pass again, back into entries
+      for (std::uint32_t p = 0; p + 1 < first_counts.size(); ++p) {
+        std::uint32_t start = first_counts[p];
+        scatter(scratch.data() + start, entries.data() + start,
+                first_counts[p + 1] - start, firstPassBits, secondPassBits,
+                second_counts);
+        for (std::uint32_t q = 0; q + 1 < second_counts.size(); ++q) {
+          partition_starts.push_back(start + second_counts[q]);
+        }
+      }
+    }
+  }
+  partition_starts.push_back(n);
+
+  // group the entries of every partition by bucket, about one per bucket
+  const std::uint32_t num_partitions = partition_starts.size() - 1;
+  partitionDirs.resize(num_partitions);
+  partitionMasks.resize(num_partitions);
+  bucketStarts.clear();
+  vector<std::uint32_t> bucket_counts;
+  for (std::uint32_t p = 0; p < num_partitions; ++p) {
+    std::uint32_t start = partition_starts[p];
+    std::uint32_t size = partition_starts[p + 1] - start;
+    int bucket_bits = 0;
+    while ((1u << bucket_bits) < size) {
+      bucket_bits++;
+    }
+    scatter(entries.data() + start, scratch.data(), size, bits, bucket_bits,
+            bucket_counts);
+    copy(scratch.begin(), scratch.begin() + size, entries.begin() + start);
+    partitionDirs[p] = bucketStarts.size();
+    partitionMasks[p] = (1u << bucket_bits) - 1;
+    for (std::uint32_t b = 0; b + 1 < bucket_counts.size(); ++b) {
+      bucketStarts.push_back(start + bucket_counts[b]);
+    }
+  }
+  // the end of the last bucket
+  bucketStarts.push_back(n);
+}
+
+void RadixHashTable::clear() {
+  reset(keyWords);
+  keys.shrink_to_fit();
+  entries.shrink_to_fit();
+  bucketStarts.shrink_to_fit();
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,206 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "key_kernels.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * In-memory hash table over fixed-width join keys of whole words, built
+ * once and then probed. The entries are radix-partitioned on the key hash in
+ * one or two passes, so that the buckets of a partition fit in the L2 cache,
+ * and every bucket is a contiguous run of compact (hash, row) entries. The
+ * rows themselves stay with the caller; a row is numbered by its insertion.
+ */
+class RadixHashTable {
+ public:
+  /**
+   * An entry: the hash of a key and the row holding it
+   */
+  struct Entry {
+    std::uint32_t hash;
+    std::uint32_t row;
+  };
+
+ private:
+  /**
+   * Number of words of a key
+   */
+  int keyWords;
+
+  /**
+   * Keys of the rows, keyWords words per row
+   */
+  vector<std::uint32_t> keys;
+
+  /**
+   * Entries in insertion order until build(), then grouped by partition and
+   * bucket
+   */
+  vector<Entry> entries;
+
+  /**
+   * Hash bits of the first and the second partitioning pass
+   */
+  int firstPassBits;
+  int secondPassBits;
+
+  /**
+   * Per partition: first bucket in bucketStarts, and mask of its buckets
+   */
+  vector<std::uint32_t> partitionDirs;
+  vector<std::uint32_t> partitionMasks;
+
+  /**
+   * First entry of every bucket, partition after partition, followed by the
+   * number of entries
+   */
+  vector<std::uint32_t> bucketStarts;
+
+  /**
+   * Scatter size entries from in to out, grouped by bits of the hash
+   * starting at shift and stable within a group
+   * @param counts Receives the first entry of every group, followed by size
+   */
+  static void scatter(const Entry* in,
+                      Entry* out,
+                      std::uint32_t size,
+                      int shift,
+                      int bits,
+                      vector<std::uint32_t>& counts);
+
+  /**
+   * Partition of a hash
+   */
+  std::uint32_t partitionOf(std::uint32_t hash) const {
+    std::uint32_t low = hash & ((1u << firstPassBits) - 1);
+    std::uint32_t high =
+        (hash >> firstPassBits) & ((1u << secondPassBits) - 1);
+    return (low << secondPassBits) | high;
+  }
+
+  /**
+   * Bucket, in bucketStarts, of a hash
+   */
+  std::uint32_t bucketOf(std::uint32_t hash) const {
+    std::uint32_t partition = partitionOf(hash);
+    return partitionDirs[partition] +
+           ((hash >> (firstPassBits + secondPassBits)) &
+            partitionMasks[partition]);
+  }
+
+ public:
+  /**
+   * Cache size the buckets of a partition should fit in
+   */
+  static const std::uint32_t CACHE_BYTES = 256 * 1024;
+
+  /**
+   * Max number of hash bits, i.e. log2 of the fan-out, of one partitioning
+   * pass, limited by the cache lines and TLB entries a scatter writes to
+   */
+  static const int MAX_PASS_BITS = 8;
+
+  /**
+   * Constructor
+   */
+  RadixHashTable() : keyWords(0), firstPassBits(0), secondPassBits(0) {
+    // nothing
+  }
+
+  /**
+   * Hash a key of whole words to 64 bits
+   */
+  static std::uint64_t hashKey64(const std::uint32_t* key, int numWords) {
+    return KeyWords<0>::hash(key, numWords);
+  }
+
+  /**
+   * Hash a key of whole words
+   */
+  static std::uint32_t hashKey(const std::uint32_t* key, int numWords) {
+    return (std::uint32_t)hashKey64(key, numWords);
+  }
+
+  /**
+   * Empty the table for keys of numWords words
+   */
+  void reset(int numWords);
+
+  /**
+   * Add the key of the next row; rows are numbered from 0 in insertion order
+   */
+  void insert(const std::uint32_t* key);
+
+  /**
+   * Partition the entries and set up the buckets; call after the last insert
+   */
+  void build();
+
+  /**
+   * Get the number of rows
+   */
+  std::uint32_t size() const { return entries.size(); }
+
+  /**
+   * Get the number of partitions
+   */
+  std::uint32_t getNumPartitions() const { return partitionDirs.size(); }
+
+  /**
+   * Prefetch where the bucket of a hash starts. A batch of probes first
+   * prefetches all of their buckets, then all of their entries, then looks
+   * them up, so that the cache misses of the batch overlap.
+   */
+  void prefetchBucket(std::uint32_t hash) const {
+#if defined(__GNUC__)
+    __builtin_prefetch(bucketStarts.data() + bucketOf(hash));
+#endif
+  }
+
+  /**
+   * Prefetch the first entries of the bucket of a hash
+   */
+  void prefetchEntries(std::uint32_t hash) const {
+#if defined(__GNUC__)
+    __builtin_prefetch(entries.data() + bucketStarts[bucketOf(hash)]);
+#endif
+  }
+
+  /**
+   * Get the entries of the bucket of a hash. Entries of other keys may be in
+   * the bucket, compare the hashes and then the keys.
+   */
+  void bucket(std::uint32_t hash,
+              const Entry*& first,
+              const Entry*& last) const {
+    std::uint32_t b = bucketOf(hash);
+    first = entries.data() + bucketStarts[b];
+    last = entries.data() + bucketStarts[b + 1];
+  }
+
+  /**
+   * Does a row hold the key? WORDS is the number of words of a key if fixed
+   * at compile time, see KeyWords.
+   */
+  template <int WORDS = 0>
+  bool keyEquals(std::uint32_t row, const std::uint32_t* key) const {
+    return KeyWords<WORDS>::equals(keys.data() + (size_t)row * keyWords, key,
+                                   keyWords);
+  }
+
+  /**
+   * Release the memory
+   */
+  void clear();
+};
+
+}  // namespace badgerdb
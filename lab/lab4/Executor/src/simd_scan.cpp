@@ -0,0 +1,340 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "simd_scan.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "tuple.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BADGERDB_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Kernels of one instruction set, on up to 64 rows at a time
+ */
+struct ScanKernels {
+  /**
+   * Get the bits of the rows with low <= value <= high
+   */
+  std::uint64_t (*between)(const std::int32_t* values,
+                           int numRows,
+                           std::int32_t low,
+                           std::int32_t high);
+
+  /**
+   * Decode the INT values stored at offset in records
+   */
+  void (*decode)(const char* const* records,
+                 int numRows,
+                 int offset,
+                 std::int32_t* values);
+};
+
+/**
+ * Bits of the first numRows rows of a bitmap word
+ */
+static std::uint64_t lowBits(int numRows) {
+  return numRows >= 64 ? ~0ULL : (1ULL << numRows) - 1;
+}
+
+static std::uint64_t betweenScalar(const std::int32_t* values,
+                                   int numRows,
+                                   std::int32_t low,
+                                   std::int32_t high) {
+  // one unsigned comparison tells whether value - low is within the range
+  const std::uint32_t span = (std::uint32_t)high - (std::uint32_t)low;
+  std::uint64_t bits = 0;
+  for (int i = 0; i < numRows; ++i) {
+    bits |= (std::uint64_t)((std::uint32_t)values[i] - (std::uint32_t)low <=
+                            span)
+            << i;
+  }
+  return bits;
+}
+
+static void decodeScalar(const char* const* records,
+                         int numRows,
+                         int offset,
+                         std::int32_t* values) {
+  for (int i = 0; i < numRows; ++i) {
+    values[i] = TupleLayout::decodeInt(records[i] + offset);
+  }
+}
+
+#ifdef BADGERDB_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+static std::uint64_t betweenSse42(const std::int32_t* values,
+                                  int numRows,
+                                  std::int32_t low,
+                                  std::int32_t high) {
+  const __m128i low_values = _mm_set1_epi32(low);
+  const __m128i high_values = _mm_set1_epi32(high);
+  std::uint64_t bits = 0;
+  int i = 0;
+  for (; i + 4 <= numRows; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    __m128i out = _mm_or_si128(_mm_cmpgt_epi32(low_values, x),
+                               _mm_cmpgt_epi32(x, high_values));
+    bits |= (std::uint64_t)(~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xf)
+            << i;
+  }
+  if (i < numRows)
+    bits |= betweenScalar(values + i, numRows - i, low, high) << i;
+  return bits;
+}
+
+__attribute__((target("avx2")))
+static std::uint64_t betweenAvx2(const std::int32_t* values,
+                                 int numRows,
+                                 std::int32_t low,
+                                 std::int32_t high) {
+  const __m256i low_values = _mm256_set1_epi32(low);
+  const __m256i high_values = _mm256_set1_epi32(high);
+  std::uint64_t bits = 0;
+  int i = 0;
+  for (; i + 8 <= numRows; i += 8) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(low_values, x),
+                                  _mm256_cmpgt_epi32(x, high_values));
+    bits |=
+        (std::uint64_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xff)
+        << i;
+  }
+  if (i < numRows)
+    bits |= betweenScalar(values + i, numRows - i, low, high) << i;
+  return bits;
+}
+
+#ifdef __x86_64__
+/**
+ * Gather the values of four records at a time through their addresses,
+ * then swap them from the stored byte order
+ */
+__attribute__((target("avx2")))
+static void decodeAvx2(const char* const* records,
+                       int numRows,
+                       int offset,
+                       std::int32_t* values) {
+  const __m256i offsets = _mm256_set1_epi64x(offset);
+  const __m128i byte_order =
+      _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  int i = 0;
+  for (; i + 4 <= numRows; i += 4) {
+    __m256i addresses = _mm256_add_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(records + i)),
+        offsets);
+    __m128i raw = _mm256_i64gather_epi32(nullptr, addresses, 1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i),
+                     _mm_shuffle_epi8(raw, byte_order));
+  }
+  decodeScalar(records + i, numRows - i, offset, values + i);
+}
+#else
+#define decodeAvx2 decodeScalar
+#endif
+
+#endif  // BADGERDB_X86_KERNELS
+
+/**
+ * Get the best instruction set the CPU supports
+ */
+static IntScanKernels::Isa detectIsa() {
+#ifdef BADGERDB_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return IntScanKernels::AVX2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return IntScanKernels::SSE42;
+#endif
+  return IntScanKernels::SCALAR;
+}
+
+/**
+ * Instruction set of the kernels in use
+ */
+static IntScanKernels::Isa& activeIsa() {
+  static IntScanKernels::Isa isa = detectIsa();
+  return isa;
+}
+
+/**
+ * Get the kernels of an instruction set
+ */
+static const ScanKernels& findKernels(IntScanKernels::Isa isa) {
+  // indexed by Isa
+  static const ScanKernels kernels[] = {
+      {&betweenScalar, &decodeScalar},
+#ifdef BADGERDB_X86_KERNELS
+      {&betweenSse42, &decodeScalar},
+      {&betweenAvx2, &decodeAvx2},
+#endif
+  };
+  return kernels[isa];
+}
+
+/**
+ * Turn value op constant into low <= value <= high, negated for NOT_EQUAL.
+ * A comparison no value satisfies gets low > high.
+ */
+static void toRange(CompareOp op,
+                    std::int32_t constant,
+                    std::int32_t& low,
+                    std::int32_t& high,
+                    bool& negated) {
+  low = INT32_MIN;
+  high = INT32_MAX;
+  negated = false;
+  switch (op) {
+    case EQUAL:
+      low = high = constant;
+      break;
+    case NOT_EQUAL:
+      low = high = constant;
+      negated = true;
+      break;
+    case LESS:
+      if (constant == INT32_MIN)
+        swap(low, high);  // no value is less
+      else
+        high = constant - 1;
+      break;
+    case LESS_EQUAL:
+      high = constant;
+      break;
+    case GREATER:
+      if (constant == INT32_MAX)
+        swap(low, high);  // no value is greater
+      else
+        low = constant + 1;
+      break;
+    case GREATER_EQUAL:
+      low = constant;
+      break;
+  }
+}
+
+/**
+ * Evaluate a range over values, or over the records holding them if values
+ * is null
+ */
+static void selectRange(const std::int32_t* values,
+                        const char* const* records,
+                        int numRows,
+                        int offset,
+                        std::int32_t low,
+                        std::int32_t high,
+                        bool negated,
+                        std::uint64_t* bitmap) {
+  const ScanKernels& kernels = findKernels(IntScanKernels::getIsa());
+  const std::uint64_t flip = negated ? ~0ULL : 0;
+  std::int32_t decoded[64];
+  for (int w = 0; w * 64 < numRows; ++w) {
+    const int num_rows = min(64, numRows - w * 64);
+    std::uint64_t bits = 0;
+    if (low <= high) {
+      const std::int32_t* word_values = decoded;
+      if (values != nullptr)
+        word_values = values + (size_t)w * 64;
+      else
+        kernels.decode(records + (size_t)w * 64, num_rows, offset, decoded);
+      bits = kernels.between(word_values, num_rows, low, high);
+    }
+    bitmap[w] = (bits ^ flip) & lowBits(num_rows);
+  }
+}
+
+void IntScanKernels::selectColumn(const std::int32_t* values,
+                                  int numRows,
+                                  CompareOp op,
+                                  std::int32_t constant,
+                                  std::uint64_t* bitmap) {
+  std::int32_t low, high;
+  bool negated;
+  toRange(op, constant, low, high, negated);
+  selectRange(values, nullptr, numRows, 0, low, high, negated, bitmap);
+}
+
+void IntScanKernels::selectColumnBetween(const std::int32_t* values,
+                                         int numRows,
+                                         std::int32_t low,
+                                         std::int32_t high,
+                                         std::uint64_t* bitmap) {
+  selectRange(values, nullptr, numRows, 0, low, high, false, bitmap);
+}
+
+void IntScanKernels::selectRecords(const char* const* records,
+                                   int numRows,
+                                   int offset,
+                                   CompareOp op,
+                                   std::int32_t constant,
+                                   std::uint64_t* bitmap) {
+  std::int32_t low, high;
+  bool negated;
+  toRange(op, constant, low, high, negated);
+  selectRange(nullptr, records, numRows, offset, low, high, negated, bitmap);
+}
+
+void IntScanKernels::selectRecordsBetween(const char* const* records,
+                                          int numRows,
+                                          int offset,
+                                          std::int32_t low,
+                                          std::int32_t high,
+                                          std::uint64_t* bitmap) {
+  selectRange(nullptr, records, numRows, offset, low, high, false, bitmap);
+}
+
+int IntScanKernels::toSelection(const std::uint64_t* bitmap,
+                                int numRows,
+                                std::uint16_t* selection) {
+  int num = 0;
+  for (int w = 0; w < getBitmapWords(numRows); ++w) {
+    std::uint64_t bits = bitmap[w];
+    while (bits != 0) {
+#if defined(__GNUC__)
+      int bit = __builtin_ctzll(bits);
+#else
+      int bit = 0;
+      while (((bits >> bit) & 1) == 0) {
+        bit++;
+      }
+#endif
+      selection[num++] = w * 64 + bit;
+      bits &= bits - 1;
+    }
+  }
+  return num;
+}
+
+IntScanKernels::Isa IntScanKernels::getIsa() {
+  return activeIsa();
+}
+
+void IntScanKernels::setIsa(Isa isa) {
+  activeIsa() = min(isa, detectIsa());
+}
+
+const char* IntScanKernels::getIsaName(Isa isa) {
+  switch (isa) {
+    case SCALAR:
+      return "scalar";
+    case SSE42:
+      return "SSE4.2";
+    case AVX2:
+      return "AVX2";
+  }
+  return "";
+}
+
+}  // namespace badgerdb
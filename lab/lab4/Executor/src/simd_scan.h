@@ -0,0 +1,105 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "predicate.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Kernels evaluating a comparison of an INT attribute with constants over
+ * many rows at once: `value op constant` or `value BETWEEN low AND high`.
+ * They read either a decoded column vector or the tuples of a page, where
+ * the attribute sits at a fixed offset, and set one bit per qualifying row
+ * in a selection bitmap: bit r % 64 of word r / 64 for row r. The rows are
+ * compared without a branch per row.
+ *
+ * Every kernel comes in an AVX2, an SSE4.2 and a scalar version. The best
+ * one the CPU supports is picked when the program starts.
+ */
+class IntScanKernels {
+ public:
+  /**
+   * Instruction set extensions of the kernels
+   */
+  enum Isa { SCALAR, SSE42, AVX2 };
+
+  /**
+   * Get the number of bitmap words of numRows rows
+   */
+  static int getBitmapWords(int numRows) { return (numRows + 63) / 64; }
+
+  /**
+   * Evaluate value op constant over an INT column
+   * @param bitmap Receives getBitmapWords(numRows) words
+   */
+  static void selectColumn(const std::int32_t* values,
+                           int numRows,
+                           CompareOp op,
+                           std::int32_t constant,
+                           std::uint64_t* bitmap);
+
+  /**
+   * Evaluate low <= value <= high over an INT column
+   */
+  static void selectColumnBetween(const std::int32_t* values,
+                                  int numRows,
+                                  std::int32_t low,
+                                  std::int32_t high,
+                                  std::uint64_t* bitmap);
+
+  /**
+   * Evaluate value op constant over tuples, e.g. those of a pinned page,
+   * whose INT attribute is stored at offset
+   */
+  static void selectRecords(const char* const* records,
+                            int numRows,
+                            int offset,
+                            CompareOp op,
+                            std::int32_t constant,
+                            std::uint64_t* bitmap);
+
+  /**
+   * Evaluate low <= value <= high over tuples whose INT attribute is stored
+   * at offset
+   */
+  static void selectRecordsBetween(const char* const* records,
+                                   int numRows,
+                                   int offset,
+                                   std::int32_t low,
+                                   std::int32_t high,
+                                   std::uint64_t* bitmap);
+
+  /**
+   * Write the rows set in a bitmap into a selection vector, in increasing
+   * order
+   * @return Number of rows written
+   */
+  static int toSelection(const std::uint64_t* bitmap,
+                         int numRows,
+                         std::uint16_t* selection);
+
+  /**
+   * Get the instruction set of the kernels in use
+   */
+  static Isa getIsa();
+
+  /**
+   * Use the kernels of an instruction set, or the best supported one below
+   * it, e.g. to compare them
+   */
+  static void setIsa(Isa isa);
+
+  /**
+   * Get the name of an instruction set
+   */
+  static const char* getIsaName(Isa isa);
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,125 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * 64-bit hash of a byte string: FNV-1a finished with the MurmurHash3 mixer,
+ * so that the high bits used to pick a register are well spread
+ */
+static std::uint64_t hashBytes(const char* data, size_t length) {
+  std::uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; ++i) {
+    h ^= (unsigned char)data[i];
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+void HyperLogLog::add(const char* value, size_t length) {
+  std::uint64_t h = hashBytes(value, length);
+  int index = h >> (64 - PRECISION);
+  std::uint64_t rest = h << PRECISION;
+  // position of the first 1 bit among the remaining bits
+  std::uint8_t rank =
+      rest == 0 ? 64 - PRECISION + 1 : __builtin_clzll(rest) + 1;
+  if (rank > registers[index])
+    registers[index] = rank;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+  for (int i = 0; i < NUM_REGISTERS; ++i) {
+    registers[i] = max(registers[i], other.registers[i]);
+  }
+}
+
+double HyperLogLog::estimate() const {
+  double sum = 0;
+  int zeros = 0;
+  for (std::uint8_t rank : registers) {
+    sum += ldexp(1.0, -rank);
+    if (rank == 0)
+      zeros++;
+  }
+  const double m = NUM_REGISTERS;
+  double e = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  if (e <= 2.5 * m && zeros > 0) {
+    e = m * log(m / zeros);  // linear counting for small cardinalities
+  }
+  return e;
+}
+
+void EquiDepthHistogram::build(const vector<string>& sortedValues,
+                               int numBuckets) {
+  bounds.clear();
+  size_t n = sortedValues.size();
+  numBuckets = min<size_t>(numBuckets, n);
+  for (int b = 1; b <= numBuckets; ++b) {
+    bounds.push_back(sortedValues[(size_t)((double)b * n / numBuckets) - 1]);
+  }
+}
+
+double EquiDepthHistogram::estimateLessEqual(const string& key) const {
+  if (bounds.empty())
+    return 0.5;
+  // buckets whose upper bound is <= key lie entirely below it
+  size_t full = upper_bound(bounds.begin(), bounds.end(), key) - bounds.begin();
+  if (full == bounds.size())
+    return 1.0;
+  // assume half of the bucket holding key is below it
+  return (full + 0.5) / bounds.size();
+}
+
+void SpaceSavingSketch::add(std::uint64_t value, std::uint64_t weight) {
+  auto it = positions.find(value);
+  if (it != positions.end()) {
+    counters[it->second].count += weight;
+    return;
+  }
+  if (counters.size() < numCounters) {
+    positions[value] = counters.size();
+    counters.push_back({value, weight, 0});
+    return;
+  }
+  // replace the smallest counter
+  size_t min_pos = 0;
+  for (size_t i = 1; i < counters.size(); ++i) {
+    if (counters[i].count < counters[min_pos].count)
+      min_pos = i;
+  }
+  Counter& counter = counters[min_pos];
+  positions.erase(counter.value);
+  positions[value] = min_pos;
+  counter.error = counter.count;
+  counter.count += weight;
+  counter.value = value;
+}
+
+vector<std::uint64_t> SpaceSavingSketch::getHeavyHitters(
+    std::uint64_t threshold) const {
+  vector<std::uint64_t> values;
+  for (const Counter& counter : counters) {
+    if (counter.count - counter.error >= threshold)
+      values.push_back(counter.value);
+  }
+  return values;
+}
+
+double AttrStats::getNumDistinct() const {
+  return max(numDistinct, sketch.estimate());
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,278 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * HyperLogLog sketch estimating the number of distinct values of an attribute
+ */
+class HyperLogLog {
+ public:
+  /**
+   * Number of hash bits selecting a register
+   */
+  static const int PRECISION = 10;
+
+  /**
+   * Number of registers
+   */
+  static const int NUM_REGISTERS = 1 << PRECISION;
+
+ private:
+  /**
+   * Max rank seen per register
+   */
+  vector<std::uint8_t> registers;
+
+ public:
+  /**
+   * Constructor
+   */
+  HyperLogLog() : registers(NUM_REGISTERS, 0) {
+    // nothing
+  }
+
+  /**
+   * Add a value to the sketch
+   */
+  void add(const char* value, size_t length);
+
+  /**
+   * Add all values of another sketch
+   */
+  void merge(const HyperLogLog& other);
+
+  /**
+   * Estimate the number of distinct values added
+   */
+  double estimate() const;
+
+  /**
+   * Get the registers, for persisting the sketch
+   */
+  const vector<std::uint8_t>& getRegisters() const { return registers; }
+
+  /**
+   * Restore the registers of a persisted sketch
+   */
+  void setRegisters(const vector<std::uint8_t>& saved) {
+    if (saved.size() == registers.size())
+      registers = saved;
+  }
+};
+
+/**
+ * Equi-depth histogram over normalized keys (see TupleLayout): every bucket
+ * holds about the same number of tuples.
+ */
+class EquiDepthHistogram {
+ public:
+  /**
+   * Number of buckets built by ANALYZE
+   */
+  static const int DEFAULT_NUM_BUCKETS = 32;
+
+ private:
+  /**
+   * Upper bound of each bucket, in increasing order
+   */
+  vector<string> bounds;
+
+ public:
+  /**
+   * Build the histogram from sorted values
+   */
+  void build(const vector<string>& sortedValues, int numBuckets);
+
+  /**
+   * Get the number of buckets
+   */
+  int getNumBuckets() const { return bounds.size(); }
+
+  /**
+   * Get the upper bounds of the buckets
+   */
+  const vector<string>& getBounds() const { return bounds; }
+
+  /**
+   * Restore the bounds of a persisted histogram
+   */
+  void setBounds(const vector<string>& saved) { bounds = saved; }
+
+  /**
+   * Estimate the fraction of tuples whose value is <= key
+   */
+  double estimateLessEqual(const string& key) const;
+};
+
+/**
+ * Space-Saving sketch finding the heavy hitters of a stream of hashed values
+ * in a fixed number of counters. A value not counted replaces the smallest
+ * counter and inherits its count as error, so a count overestimates the
+ * weight of its value by at most the error, and every value weighing more
+ * than the total over the number of counters has a counter.
+ */
+class SpaceSavingSketch {
+ public:
+  /**
+   * Default number of counters
+   */
+  static const int DEFAULT_NUM_COUNTERS = 64;
+
+  /**
+   * A counted value
+   */
+  struct Counter {
+    std::uint64_t value;
+    std::uint64_t count;
+    std::uint64_t error;
+  };
+
+ private:
+  /**
+   * Max number of counters
+   */
+  size_t numCounters;
+
+  /**
+   * Counters, in no order
+   */
+  vector<Counter> counters;
+
+  /**
+   * Position of every counted value in counters
+   */
+  unordered_map<std::uint64_t, size_t> positions;
+
+ public:
+  /**
+   * Constructor
+   */
+  explicit SpaceSavingSketch(int numCounters = DEFAULT_NUM_COUNTERS)
+      : numCounters(numCounters) {
+  }
+
+  /**
+   * Add a value with a weight, e.g. the size of its tuple
+   */
+  void add(std::uint64_t value, std::uint64_t weight = 1);
+
+  /**
+   * Get the values certainly weighing at least threshold, i.e. whose count
+   * minus error reaches it
+   */
+  vector<std::uint64_t> getHeavyHitters(std::uint64_t threshold) const;
+
+  /**
+   * Get the counters
+   */
+  const vector<Counter>& getCounters() const { return counters; }
+
+  /**
+   * Forget all values
+   */
+  void clear() {
+    counters.clear();
+    positions.clear();
+  }
+};
+
+/**
+ * Statistics of an attribute, collected by ANALYZE
+ */
+struct AttrStats {
+  /**
+   * Smallest value, as a normalized key
+   */
+  string minValue;
+
+  /**
+   * Largest value, as a normalized key
+   */
+  string maxValue;
+
+  /**
+   * Number of distinct values estimated by the last ANALYZE
+   */
+  double numDistinct;
+
+  /**
+   * Sketch of the distinct values, also fed by inserts after ANALYZE
+   */
+  HyperLogLog sketch;
+
+  /**
+   * Distribution of the values
+   */
+  EquiDepthHistogram histogram;
+
+  /**
+   * Constructor
+   */
+  AttrStats() : numDistinct(0) {
+    // nothing
+  }
+
+  /**
+   * Get the estimated number of distinct values
+   */
+  double getNumDistinct() const;
+};
+
+/**
+ * Statistics of a table kept in the system catalog. Page, tuple and byte
+ * counts are maintained by HeapFileManager; the attribute statistics are
+ * refreshed by HeapFileManager::analyzeTable.
+ */
+struct TableStats {
+  /**
+   * Number of pages in the table file
+   */
+  std::uint32_t numPages;
+
+  /**
+   * Number of tuples in the table
+   */
+  std::uint64_t numTuples;
+
+  /**
+   * Total size of the tuples in bytes
+   */
+  std::uint64_t numTupleBytes;
+
+  /**
+   * Per-attribute statistics in schema order, empty before ANALYZE
+   */
+  vector<AttrStats> attrStats;
+
+  /**
+   * Constructor
+   */
+  TableStats() : numPages(0), numTuples(0), numTupleBytes(0) {
+    // nothing
+  }
+
+  /**
+   * Get the average tuple width in bytes
+   */
+  double getAvgTupleWidth() const {
+    return numTuples > 0 ? (double)numTupleBytes / numTuples : 0;
+  }
+
+  /**
+   * Have the attribute statistics been collected?
+   */
+  bool isAnalyzed() const { return !attrStats.empty(); }
+};
+
+}  // namespace badgerdb
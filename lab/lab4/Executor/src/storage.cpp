@@ -5,18 +5,89 @@
  */
 
 #include "storage.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
 #include <regex>
+#include "exceptions/badgerdb_exception.h"
+#include "exceptions/insufficient_space_exception.h"
 #include "exceptions/invalid_record_exception.h"
 #include "file_iterator.h"
 #include "page_iterator.h"
+#include "tuple.h"
 
 using namespace std;
 
 namespace badgerdb {
 
+/**
+ * Account for the values of a tuple added to an analyzed table: min/max and
+ * the distinct value sketches are kept current until the next ANALYZE, the
+ * histograms are only rebuilt by ANALYZE
+ * @param slots, key Space for the attribute locations and a key
+ */
+static void addAttrValues(TableStats& stats,
+                          const TupleLayout& layout,
+                          const char* tuple,
+                          AttrSlot* slots,
+                          string& key) {
+  layout.locate(tuple, slots);
+  for (int i = 0; i < layout.getAttrCount(); ++i) {
+    AttrStats& attrStats = stats.attrStats[i];
+    key.clear();
+    layout.appendNormalized(tuple, slots[i], i, key);
+    attrStats.sketch.add(key.data(), key.size());
+    if (attrStats.minValue.empty() || key < attrStats.minValue)
+      attrStats.minValue = key;
+    if (key > attrStats.maxValue)
+      attrStats.maxValue = key;
+  }
+}
+
+/**
+ * Account for tuples added to the table stored in file
+ */
+static void recordInsertedTuples(Catalog* catalog,
+                                 const File& file,
+                                 const string* tuples,
+                                 size_t numTuples,
+                                 int numNewPages) {
+  TableId tableId;
+  if (catalog == nullptr ||
+      !catalog->getTableIdByFilename(file.filename(), tableId))
+    return;
+  TableStats& stats = catalog->getTableStats(tableId);
+  stats.numPages += numNewPages;
+  stats.numTuples += numTuples;
+  if (!stats.isAnalyzed()) {
+    for (size_t t = 0; t < numTuples; ++t)
+      stats.numTupleBytes += tuples[t].size();
+    return;
+  }
+  TupleLayout layout(catalog->getTableSchema(tableId));
+  vector<AttrSlot> slots(layout.getAttrCount());
+  string key;
+  for (size_t t = 0; t < numTuples; ++t) {
+    stats.numTupleBytes += tuples[t].size();
+    addAttrValues(stats, layout, tuples[t].data(), &slots[0], key);
+  }
+}
+
+/**
+ * Get the zone map of the table stored in file, or null
+ */
+static ZoneMap* findZoneMap(Catalog* catalog, const File& file) {
+  TableId tableId;
+  if (catalog == nullptr ||
+      !catalog->getTableIdByFilename(file.filename(), tableId))
+    return nullptr;
+  return catalog->getZoneMap(tableId);
+}
+
 RecordId HeapFileManager::insertTuple(const string& tuple,
                                       File& file,
-                                      BufMgr* bufMgr) {
+                                      BufMgr* bufMgr,
+                                      Catalog* catalog) {
   badgerdb::Page* buffered_page = nullptr;
   RecordId recordId = {};
   // iterate all the pages in the file
@@ -30,6 +101,9 @@ RecordId HeapFileManager::insertTuple(const string& tuple,
       bufMgr->unPinPage(&file, buffered_page->page_number(), true);
       // write the change back to the file
       bufMgr->flushFile(&file);
+      recordInsertedTuples(catalog, file, &tuple, 1, 0);
+      if (ZoneMap* zone_map = findZoneMap(catalog, file))
+        zone_map->addTuple(recordId.page_number, tuple.data());
       return recordId;
     }
   }
@@ -42,31 +116,379 @@ RecordId HeapFileManager::insertTuple(const string& tuple,
   bufMgr->unPinPage(&file, buffered_page->page_number(), true);
   // write the change back to the file
   bufMgr->flushFile(&file);
+  recordInsertedTuples(catalog, file, &tuple, 1, 1);
+  if (ZoneMap* zone_map = findZoneMap(catalog, file))
+    zone_map->addTuple(recordId.page_number, tuple.data());
   return recordId;
 }
 
+int HeapFileManager::bulkInsertTuples(const vector<string>& tuples,
+                                      File& file,
+                                      BufMgr* bufMgr,
+                                      Catalog* catalog) {
+  int num_pages = 0;
+  badgerdb::Page* buffered_page = nullptr;
+  PageId page_number = Page::INVALID_NUMBER;
+  ZoneMap* zone_map = findZoneMap(catalog, file);
+  size_t num_inserted = 0;
+  try {
+    for (const string& tuple : tuples) {
+      if (buffered_page == nullptr ||
+          !buffered_page->hasSpaceForRecord(tuple)) {
+        // a tuple too large for an empty page is refused before allocating
+        if (tuple.size() + sizeof(PageSlot) > Page::DATA_SIZE)
+          throw InsufficientSpaceException(Page::INVALID_NUMBER, tuple.size(),
+                                           Page::DATA_SIZE - sizeof(PageSlot));
+        // the current page is full, hand it back to the buffer pool and
+        // continue on a fresh one
+        if (buffered_page != nullptr) {
+          bufMgr->unPinPage(&file, page_number, true);
+          buffered_page = nullptr;
+        }
+        bufMgr->allocPage(&file, page_number, buffered_page);
+        num_pages++;
+      }
+      buffered_page->insertRecord(tuple);
+      num_inserted++;
+      if (zone_map != nullptr)
+        zone_map->addTuple(page_number, tuple.data());
+    }
+  } catch (...) {
+    // keep the tuples inserted so far, with the current page unpinned
+    if (buffered_page != nullptr)
+      bufMgr->unPinPage(&file, page_number, true);
+    bufMgr->flushFile(&file);
+    recordInsertedTuples(catalog, file, tuples.data(), num_inserted,
+                         num_pages);
+    throw;
+  }
+  if (buffered_page != nullptr) {
+    bufMgr->unPinPage(&file, page_number, true);
+  }
+  // write the change back to the file
+  bufMgr->flushFile(&file);
+  recordInsertedTuples(catalog, file, tuples.data(), tuples.size(), num_pages);
+  return num_pages;
+}
+
+HeapAppender::HeapAppender(File& file, BufMgr* bufMgr, Catalog* catalog)
+    : file(&file),
+      bufMgr(bufMgr),
+      stats(nullptr),
+      zoneMap(nullptr),
+      tailPage(nullptr),
+      tailPageNumber(Page::INVALID_NUMBER),
+      numPages(0),
+      numTuples(0) {
+  TableId tableId;
+  if (catalog == nullptr ||
+      !catalog->getTableIdByFilename(file.filename(), tableId))
+    return;
+  stats = &catalog->getTableStats(tableId);
+  zoneMap = catalog->getZoneMap(tableId);
+  layout.reset(new TupleLayout(catalog->getTableSchema(tableId)));
+  slots.resize(layout->getAttrCount());
+}
+
+void HeapAppender::resumeLastPage(const string& tuple) {
+  // the used pages are walked by their headers, only the last one is read
+  PageId last_page_number = Page::INVALID_NUMBER;
+  for (FileIterator iter = file->begin(); iter != file->end(); ++iter) {
+    last_page_number = iter.page_number();
+  }
+  if (last_page_number == Page::INVALID_NUMBER)
+    return;
+  bufMgr->readPage(file, last_page_number, tailPage);
+  if (!tailPage->hasSpaceForRecord(tuple)) {
+    bufMgr->unPinPage(file, last_page_number, false);
+    tailPage = nullptr;
+    return;
+  }
+  tailPageNumber = last_page_number;
+}
+
+RecordId HeapAppender::append(const string& tuple) {
+  int num_new_pages = 0;
+  if (tailPage == nullptr)
+    resumeLastPage(tuple);
+  if (tailPage == nullptr || !tailPage->hasSpaceForRecord(tuple)) {
+    // the tail page is full, hand it back to the buffer pool and continue
+    // on a fresh one
+    if (tailPage != nullptr) {
+      bufMgr->unPinPage(file, tailPageNumber, true);
+      tailPage = nullptr;
+    }
+    bufMgr->allocPage(file, tailPageNumber, tailPage);
+    numPages++;
+    num_new_pages = 1;
+  }
+  RecordId recordId = tailPage->insertRecord(tuple);
+  numTuples++;
+  if (stats != nullptr) {
+    stats->numPages += num_new_pages;
+    stats->numTuples++;
+    stats->numTupleBytes += tuple.size();
+    if (stats->isAnalyzed())
+      addAttrValues(*stats, *layout, tuple.data(), &slots[0], key);
+  }
+  if (zoneMap != nullptr)
+    zoneMap->addTuple(recordId.page_number, tuple.data());
+  return recordId;
+}
+
+void HeapAppender::close() {
+  if (tailPage != nullptr) {
+    bufMgr->unPinPage(file, tailPageNumber, true);
+    tailPage = nullptr;
+  }
+  // write the change back to the file
+  bufMgr->flushFile(file);
+}
+
+/**
+ * Get the statistics of the table stored in file, or null
+ */
+static TableStats* findTableStats(Catalog* catalog, const File& file) {
+  TableId tableId;
+  if (catalog == nullptr ||
+      !catalog->getTableIdByFilename(file.filename(), tableId))
+    return nullptr;
+  return &catalog->getTableStats(tableId);
+}
+
+/**
+ * Delete the tuples of a run of record IDs on one page
+ */
+static void deleteFromPage(const RecordId* rids,
+                           size_t numRids,
+                           File& file,
+                           BufMgr* bufMgr,
+                           TableStats* stats) {
+  PageId page_number = rids[0].page_number;
+  badgerdb::Page* page;
+  bufMgr->readPage(&file, page_number, page);
+  size_t num_deleted = 0;
+  try {
+    for (; num_deleted < numRids; ++num_deleted) {
+      std::uint16_t tuple_size;
+      page->getRecordData(rids[num_deleted], tuple_size);
+      page->deleteRecord(rids[num_deleted]);
+      if (stats != nullptr) {
+        stats->numTuples -= min<std::uint64_t>(stats->numTuples, 1);
+        stats->numTupleBytes -=
+            min<std::uint64_t>(stats->numTupleBytes, tuple_size);
+      }
+    }
+  } catch (InvalidRecordException& e) {
+    bufMgr->unPinPage(&file, page_number, num_deleted > 0);
+    throw;
+  }
+  bufMgr->unPinPage(&file, page_number, true);
+}
+
+string HeapFileManager::fetchTuple(const RecordId& rid,
+                                   File& file,
+                                   BufMgr* bufMgr) {
+  badgerdb::Page* page;
+  bufMgr->readPage(&file, rid.page_number, page);
+  string tuple;
+  try {
+    tuple = page->getRecord(rid);
+  } catch (InvalidRecordException& e) {
+    bufMgr->unPinPage(&file, rid.page_number, false);
+    throw;
+  }
+  bufMgr->unPinPage(&file, rid.page_number, false);
+  return tuple;
+}
+
+void HeapFileManager::updateTuple(const RecordId& rid,
+                                  const string& tuple,
+                                  File& file,
+                                  BufMgr* bufMgr,
+                                  Catalog* catalog) {
+  badgerdb::Page* page;
+  bufMgr->readPage(&file, rid.page_number, page);
+  std::uint16_t old_size;
+  try {
+    page->getRecordData(rid, old_size);
+    page->updateRecord(rid, tuple);
+  } catch (BadgerDbException& e) {
+    // both throw before the page is changed
+    bufMgr->unPinPage(&file, rid.page_number, false);
+    throw;
+  }
+  bufMgr->unPinPage(&file, rid.page_number, true);
+  // write the change back to the file
+  bufMgr->flushFile(&file);
+
+  TableStats* stats = findTableStats(catalog, file);
+  if (stats != nullptr) {
+    // counted as the old tuple deleted and the new one inserted
+    stats->numTupleBytes -= min<std::uint64_t>(stats->numTupleBytes, old_size);
+    stats->numTuples -= min<std::uint64_t>(stats->numTuples, 1);
+    recordInsertedTuples(catalog, file, &tuple, 1, 0);
+  }
+  if (ZoneMap* zone_map = findZoneMap(catalog, file))
+    zone_map->addTuple(rid.page_number, tuple.data());
+}
+
 void HeapFileManager::deleteTuple(const RecordId& rid,
                                   File& file,
-                                  BufMgr* bufMgr) {
-  // iterate all the pages in the file
-  for (auto page : file) {
-    badgerdb::Page* page_i;
-    bufMgr->readPage(&file, page.page_number(), page_i);
-    try {
-      page_i->deleteRecord(rid);
-    } catch (InvalidRecordException& e) {
-      // did not find the correspond rid in this page
-      bufMgr->unPinPage(&file, page_i->page_number(), false);
-      continue;  // try to find the record in the next page
-    };
-    // has deleted the record
-    bufMgr->unPinPage(&file, page_i->page_number(), true);
-    break;
+                                  BufMgr* bufMgr,
+                                  Catalog* catalog) {
+  try {
+    deleteFromPage(&rid, 1, file, bufMgr, findTableStats(catalog, file));
+  } catch (BadgerDbException& e) {
+    bufMgr->flushFile(&file);
+    throw;
   }
   // write the change back to the file
   bufMgr->flushFile(&file);
 }
 
+void HeapFileManager::deleteTuples(const vector<RecordId>& rids,
+                                   File& file,
+                                   BufMgr* bufMgr,
+                                   Catalog* catalog) {
+  // group the record IDs by page, dropping repeats
+  vector<RecordId> sorted = rids;
+  auto less = [](const RecordId& a, const RecordId& b) {
+    return a.page_number != b.page_number ? a.page_number < b.page_number
+                                          : a.slot_number < b.slot_number;
+  };
+  sort(sorted.begin(), sorted.end(), less);
+  sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+  TableStats* stats = findTableStats(catalog, file);
+  try {
+    for (size_t first = 0, last; first < sorted.size(); first = last) {
+      PageId page_number = sorted[first].page_number;
+      for (last = first + 1;
+           last < sorted.size() && sorted[last].page_number == page_number;
+           ++last)
+        ;
+      deleteFromPage(&sorted[first], last - first, file, bufMgr, stats);
+    }
+  } catch (BadgerDbException& e) {
+    bufMgr->flushFile(&file);
+    throw;
+  }
+  // write the change back to the file
+  bufMgr->flushFile(&file);
+}
+
+void HeapFileManager::buildZoneMap(Catalog* catalog,
+                                   const TableId& tableId,
+                                   BufMgr* bufMgr) {
+  File file = File::open(catalog->getTableFilename(tableId));
+  ZoneMap zoneMap(catalog->getTableSchema(tableId));
+  zoneMap.build(file, bufMgr);
+  catalog->setZoneMap(tableId, zoneMap);
+}
+
+int HeapFileManager::getNumPages(const File& file, const Catalog* catalog) {
+  TableId tableId;
+  if (catalog != nullptr &&
+      catalog->getTableIdByFilename(file.filename(), tableId))
+    return catalog->getTableStats(tableId).numPages;
+  int num_pages = 0;
+  File counted = file;
+  for (FileIterator iter = counted.begin(); iter != counted.end(); ++iter) {
+    num_pages++;
+  }
+  return num_pages;
+}
+
+void HeapFileManager::analyzeTable(Catalog* catalog,
+                                   const TableId& tableId,
+                                   BufMgr* bufMgr,
+                                   int numSamplePages) {
+  const TableSchema& tableSchema = catalog->getTableSchema(tableId);
+  File file = File::open(catalog->getTableFilename(tableId));
+  TupleLayout layout(tableSchema);
+  const int num_attrs = tableSchema.getAttrCount();
+
+  // the page list is taken from the page headers, pages are only read when
+  // they are sampled
+  vector<PageId> pages;
+  for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+    pages.push_back(iter.page_number());
+  }
+  vector<PageId> sample = pages;
+  if (numSamplePages > 0 && numSamplePages < (int)pages.size()) {
+    // pick pages uniformly at random and read them in file order
+    mt19937 rng(tableId);
+    shuffle(sample.begin(), sample.end(), rng);
+    sample.resize(numSamplePages);
+    sort(sample.begin(), sample.end());
+  }
+
+  TableStats stats;
+  stats.attrStats.resize(num_attrs);
+  vector<vector<string>> values(num_attrs);
+  vector<AttrSlot> slots(num_attrs);
+  std::uint64_t sample_tuples = 0, sample_bytes = 0;
+  for (PageId page_number : sample) {
+    badgerdb::Page* buffered_page;
+    bufMgr->readPage(&file, page_number, buffered_page);
+    for (PageIterator iter = buffered_page->begin();
+         iter != buffered_page->end(); ++iter) {
+      string tuple = *iter;
+      sample_tuples++;
+      sample_bytes += tuple.size();
+      layout.locate(tuple.data(), &slots[0]);
+      for (int i = 0; i < num_attrs; ++i) {
+        string key;
+        layout.appendNormalized(tuple.data(), slots[i], i, key);
+        stats.attrStats[i].sketch.add(key.data(), key.size());
+        values[i].push_back(std::move(key));
+      }
+    }
+    bufMgr->unPinPage(&file, page_number, false);
+  }
+  bufMgr->flushFile(&file);
+
+  // scale the sample up to the whole table
+  double scale = sample.empty() ? 0 : (double)pages.size() / sample.size();
+  stats.numPages = pages.size();
+  stats.numTuples = llround(sample_tuples * scale);
+  stats.numTupleBytes = llround(sample_bytes * scale);
+  for (int i = 0; i < num_attrs; ++i) {
+    vector<string>& attr_values = values[i];
+    AttrStats& attrStats = stats.attrStats[i];
+    if (attr_values.empty())
+      continue;
+    sort(attr_values.begin(), attr_values.end());
+    attrStats.minValue = attr_values.front();
+    attrStats.maxValue = attr_values.back();
+    attrStats.histogram.build(attr_values,
+                              EquiDepthHistogram::DEFAULT_NUM_BUCKETS);
+    // distinct values and values seen once in the sample
+    double distinct = 0, singletons = 0;
+    for (size_t j = 0, k; j < attr_values.size(); j = k) {
+      for (k = j + 1; k < attr_values.size() && attr_values[k] == attr_values[j];
+           ++k)
+        ;
+      distinct++;
+      if (k - j == 1)
+        singletons++;
+    }
+    if (sample.size() == pages.size()) {
+      attrStats.numDistinct = distinct;
+    } else if (singletons == attr_values.size()) {
+      // no value repeats in the sample, assume the attribute is a key
+      attrStats.numDistinct = stats.numTuples;
+    } else {
+      // GEE estimator: values seen once stand for sqrt(n/r) values each
+      attrStats.numDistinct =
+          min<double>(stats.numTuples,
+                      sqrt(scale) * singletons + (distinct - singletons));
+    }
+  }
+  catalog->setTableStats(tableId, stats);
+}
+
 string HeapFileManager::createTupleFromSQLStatement(const string& sql,
                                                     const Catalog* catalog) {
   smatch result;
@@ -155,4 +577,42 @@ string HeapFileManager::createTupleFromSQLStatement(const string& sql,
   }
   return tuple_layout;
 }
+
+string HeapFileManager::createTupleFromValues(const vector<string>& values,
+                                              const TableSchema& tableSchema) {
+  string tuple_layout;
+  for (int i = 0; i < tableSchema.getAttrCount(); ++i) {
+    const string& token = values[i];
+    switch (tableSchema.getAttrType(i)) {
+      case INT: {  // 4 bytes, most significant byte first
+        unsigned value = atoi(token.c_str());
+        for (int j = 3; j >= 0; --j) {
+          tuple_layout += (char)(value >> (8 * j));
+        }
+        break;
+      }
+      case CHAR: {  // padded with '0' up to the max length
+        int max_len = tableSchema.getAttrMaxSize(i);
+        tuple_layout += token.substr(0, max_len);
+        if ((int)token.size() < max_len) {
+          tuple_layout.append(max_len - token.size(), '0');
+        }
+        // align length to the multiple of 4
+        tuple_layout.append((4 - (max_len % 4)) % 4, '0');
+        break;
+      }
+      case VARCHAR: {  // length byte followed by the characters
+        // the length byte is read back as a signed char
+        unsigned true_len =
+            min<size_t>(token.size(), min(tableSchema.getAttrMaxSize(i), 127));
+        tuple_layout += (char)true_len;
+        tuple_layout.append(token, 0, true_len);
+        // align length to the multiple of 4
+        tuple_layout.append((4 - ((true_len + 1) % 4)) % 4, '0');
+        break;
+      }
+    }
+  }
+  return tuple_layout;
+}
 }  // namespace badgerdb
\ No newline at end of file
@@ -6,9 +6,14 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "buffer.h"
 #include "catalog.h"
 #include "file.h"
+#include "page.h"
+#include "tuple.h"
 #include "types.h"
 
 using namespace std;
@@ -16,24 +21,223 @@ using namespace std;
 namespace badgerdb {
 
 /**
- * Heap file manager for inserting and deleting tuples
+ * Heap file manager for inserting and deleting tuples. The writes take the
+ * catalog and keep the statistics and the zone map of the table stored in
+ * the file up to date; the catalog is null only for a file that is no table
+ * of it, such as a temporary file.
  */
 class HeapFileManager {
  public:
   /**
    * Insert a tuple to a table
    */
-  static RecordId insertTuple(const string& tuple, File& file, BufMgr* bufMgr);
+  static RecordId insertTuple(const string& tuple,
+                              File& file,
+                              BufMgr* bufMgr,
+                              Catalog* catalog);
+
+  /**
+   * Insert a batch of tuples to a table by packing them into newly allocated
+   * pages, without searching existing pages for free space. Every call
+   * starts a new page; append to a HeapAppender to fill pages across calls.
+   * @return Number of pages allocated
+   * @throws InsufficientSpaceException If a tuple does not fit in a page; the
+   *         tuples before it stay inserted
+   */
+  static int bulkInsertTuples(const vector<string>& tuples,
+                              File& file,
+                              BufMgr* bufMgr,
+                              Catalog* catalog);
+
+  /**
+   * Get a copy of a tuple of a table, reading only the page of its record ID.
+   * The page stays in the buffer pool keyed by file; flush the file before
+   * the handle goes away.
+   * @throws InvalidPageException If the page is not in the file
+   * @throws InvalidRecordException If the slot holds no tuple
+   */
+  static string fetchTuple(const RecordId& rid, File& file, BufMgr* bufMgr);
+
+  /**
+   * Replace a tuple of a table in place, keeping its record ID
+   * @throws InvalidPageException If the page is not in the file
+   * @throws InvalidRecordException If the slot holds no tuple
+   * @throws InsufficientSpaceException If the new tuple does not fit in the
+   *                                    page
+   */
+  static void updateTuple(const RecordId& rid,
+                          const string& tuple,
+                          File& file,
+                          BufMgr* bufMgr,
+                          Catalog* catalog);
+
+  /**
+   * Delete a tuple from a table, reading only the page of its record ID
+   * @throws InvalidPageException If the page is not in the file
+   * @throws InvalidRecordException If the slot holds no tuple
+   */
+  static void deleteTuple(const RecordId& rid,
+                          File& file,
+                          BufMgr* bufMgr,
+                          Catalog* catalog);
+
+  /**
+   * Delete a batch of tuples from a table, reading each of their pages once
+   * and flushing the file once. Record IDs may repeat. On an exception, the
+   * tuples of the pages before the failing one stay deleted.
+   * @throws InvalidPageException If a page is not in the file
+   * @throws InvalidRecordException If a slot holds no tuple
+   */
+  static void deleteTuples(const vector<RecordId>& rids,
+                           File& file,
+                           BufMgr* bufMgr,
+                           Catalog* catalog);
+
+  /**
+   * ANALYZE: recount the pages of a table and rebuild its tuple and
+   * attribute statistics (min/max, distinct values, histograms) from a
+   * sample of its pages
+   * @param numSamplePages Number of pages to sample, 0 for all pages
+   */
+  static void analyzeTable(Catalog* catalog,
+                           const TableId& tableId,
+                           BufMgr* bufMgr,
+                           int numSamplePages = 0);
+
+  /**
+   * Build the zone map of a table from all of its pages, replacing the
+   * previous one. The writes keep it up to date.
+   */
+  static void buildZoneMap(Catalog* catalog,
+                           const TableId& tableId,
+                           BufMgr* bufMgr);
 
   /**
-   * Delete a tuple from a table
+   * Get the number of pages of a table. The catalog statistics are used if
+   * the file belongs to a table in the catalog, otherwise the pages are
+   * counted.
    */
-  static void deleteTuple(const RecordId& rid, File& file, BufMgr* bufMgr);
+  static int getNumPages(const File& file, const Catalog* catalog = nullptr);
 
   /**
    * Create a tuple from an SQL statement
    */
   static string createTupleFromSQLStatement(const string& sql,
                                             const Catalog* catalog);
+
+  /**
+   * Create a tuple from attribute values listed in schema order. The values
+   * are taken verbatim (no quote or space stripping); NULL has no
+   * representation in the tuple layout and should be passed as an empty
+   * string.
+   */
+  static string createTupleFromValues(const vector<string>& values,
+                                      const TableSchema& tableSchema);
+};
+
+/**
+ * Sequential writer appending tuples to a heap file. The first tuple goes to
+ * the last page of the file if it has room, so that appenders opened one
+ * after the other fill the same page. The tail page stays pinned and is
+ * filled in order; when it is full a new page is allocated and the old one
+ * unpinned, so no other page is searched for free space. The file is
+ * flushed once, by close().
+ */
+class HeapAppender {
+ private:
+  /**
+   * File appended to, the buffer pool frames are keyed by its address
+   */
+  File* file;
+
+  /**
+   * Buffer pool manager
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Statistics of the table appended to, or null if the file is not that of
+   * a table in the catalog
+   */
+  TableStats* stats;
+
+  /**
+   * Zone map of the table, or null
+   */
+  ZoneMap* zoneMap;
+
+  /**
+   * Layout of the table, to keep its attribute statistics current, and
+   * space for the attribute locations and a key of a tuple
+   */
+  unique_ptr<TupleLayout> layout;
+  vector<AttrSlot> slots;
+  string key;
+
+  /**
+   * Pinned tail page, or null
+   */
+  Page* tailPage;
+
+  /**
+   * Page number of the tail page
+   */
+  PageId tailPageNumber;
+
+  /**
+   * Number of pages allocated
+   */
+  int numPages;
+
+  /**
+   * Number of tuples appended
+   */
+  int numTuples;
+
+  /**
+   * Pin the last page of the file as the tail page if it has room for tuple
+   */
+  void resumeLastPage(const string& tuple);
+
+ public:
+  /**
+   * Constructor. The file must outlive the appender. The statistics and the
+   * zone map of the table stored in file are looked up once in the catalog,
+   * which is null only for a file that is no table of it, and kept up to
+   * date; the table must not be dropped and its zone map not replaced while
+   * the appender is open.
+   */
+  HeapAppender(File& file, BufMgr* bufMgr, Catalog* catalog);
+
+  /**
+   * Not copyable, the tail page is unpinned once
+   */
+  HeapAppender(const HeapAppender&) = delete;
+  HeapAppender& operator=(const HeapAppender&) = delete;
+
+  /**
+   * Destructor
+   */
+  ~HeapAppender() { close(); }
+
+  /**
+   * Append a tuple
+   */
+  RecordId append(const string& tuple);
+
+  /**
+   * Unpin the tail page and write the appended pages back to the file
+   */
+  void close();
+
+  /**
+   * Get the number of pages allocated
+   */
+  int getNumPages() const { return numPages; }
+
+  /**
+   * Get the number of tuples appended
+   */
+  int getNumTuples() const { return numTuples; }
 };
 }  // namespace badgerdb
\ No newline at end of file
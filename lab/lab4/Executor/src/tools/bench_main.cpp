@@ -0,0 +1,921 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aggregate.h"
+#include "batch.h"
+#include "btree.h"
+#include "buffer.h"
+#include "catalog.h"
+#include "exceptions/badgerdb_exception.h"
+#include "executor.h"
+#include "file_iterator.h"
+#include "hash_index.h"
+#include "key_hash.h"
+#include "operator.h"
+#include "page_iterator.h"
+#include "simd_scan.h"
+#include "storage.h"
+
+using namespace badgerdb;
+
+/**
+ * Seconds elapsed since start
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Time loading a persisted catalog with numTables tables
+ */
+static void benchCatalogStartup(int numTables) {
+  Catalog catalog("bench");
+  for (int i = 0; i < numTables; i++) {
+    stringstream ss;
+    ss << "CREATE TABLE t" << i
+       << " (a CHAR(8) UNIQUE NOT NULL, b INT, c VARCHAR(16), d INT);";
+    catalog.addTableSchema(TableSchema::fromSQLStatement(ss.str()),
+                           "t" + to_string(i) + ".tbl");
+  }
+  auto start = chrono::steady_clock::now();
+  catalog.save();
+  double saveSeconds = secondsSince(start);
+
+  start = chrono::steady_clock::now();
+  Catalog loaded("bench");
+  loaded.load();
+  double loadSeconds = secondsSince(start);
+
+  // look every table up by name once
+  start = chrono::steady_clock::now();
+  long checksum = 0;
+  for (int i = 0; i < numTables; i++) {
+    checksum += loaded.getTableId("t" + to_string(i));
+  }
+  double lookupSeconds = secondsSince(start);
+  std::remove(loaded.getCatalogFilename().c_str());
+
+  cout << "# Tables: " << loaded.getTableCount() << endl;
+  cout << "# Save Seconds: " << saveSeconds << endl;
+  cout << "# Startup (Load) Seconds: " << loadSeconds << endl;
+  cout << "# Lookups/sec: " << (long)(numTables / lookupSeconds) << " ("
+       << checksum << ")" << endl;
+}
+
+/**
+ * Time SELECT * FROM r JOIN s WHERE a < numRows / 2, with numRows tuples in
+ * r and numRows / 100 in s, in the tuple-at-a-time and in the batch engine
+ */
+static void benchBatchExecution(int numRows) {
+  TableSchema leftSchema = TableSchema::fromSQLStatement(
+      "CREATE TABLE r (a INT, b INT, c VARCHAR(16));");
+  TableSchema rightSchema = TableSchema::fromSQLStatement(
+      "CREATE TABLE s (b INT, d CHAR(8));");
+  const string leftFilename = "bench_batch_r.tbl";
+  const string rightFilename = "bench_batch_s.tbl";
+  std::remove(leftFilename.c_str());
+  std::remove(rightFilename.c_str());
+  BufMgr bufMgr(256);
+  int numRightRows = max(1, numRows / 100);
+  {
+    File leftFile = File::create(leftFilename);
+    File rightFile = File::create(rightFilename);
+    vector<string> tuples;
+    for (int i = 0; i < numRows; i++) {
+      vector<string> values = {to_string(i), to_string(i % numRightRows),
+                               "row" + to_string(i)};
+      tuples.push_back(HeapFileManager::createTupleFromValues(values, leftSchema));
+    }
+    HeapFileManager::bulkInsertTuples(tuples, leftFile, &bufMgr, nullptr);
+    tuples.clear();
+    for (int i = 0; i < numRightRows; i++) {
+      vector<string> values = {to_string(i), "d" + to_string(i)};
+      tuples.push_back(
+          HeapFileManager::createTupleFromValues(values, rightSchema));
+    }
+    HeapFileManager::bulkInsertTuples(tuples, rightFile, &bufMgr, nullptr);
+    bufMgr.flushFile(&leftFile);
+    bufMgr.flushFile(&rightFile);
+  }
+  int bound = numRows / 2;
+  long long rowResults = 0, batchResults = 0;
+  double rowSeconds, batchSeconds;
+  {
+    File leftFile = File::open(leftFilename);
+    File rightFile = File::open(rightFilename);
+
+    // tuple at a time: Filter, then one-pass join
+    auto start = chrono::steady_clock::now();
+    {
+      unique_ptr<Operator> scan(
+          new TableScanOperator(leftFile, leftSchema, &bufMgr));
+      unique_ptr<Operator> filter(new FilterOperator(
+          std::move(scan),
+          [bound](const TupleView& tuple) {
+            return TupleLayout::decodeInt(tuple.data) < bound;
+          },
+          &bufMgr));
+      unique_ptr<Operator> rightScan(
+          new TableScanOperator(rightFile, rightSchema, &bufMgr));
+      OnePassJoinOperator join(std::move(filter), std::move(rightScan), nullptr,
+                               &bufMgr);
+      join.setNumAvailableBufPages(256);
+      TupleView tuple;
+      join.open();
+      while (join.next(tuple)) {
+        rowResults++;
+      }
+      join.close();
+    }
+    rowSeconds = secondsSince(start);
+
+    // batch at a time: BatchFilter, then batch hash join
+    start = chrono::steady_clock::now();
+    {
+      unique_ptr<BatchOperator> scan(
+          new BatchScanOperator(leftFile, leftSchema, &bufMgr));
+      unique_ptr<BatchOperator> filter(new BatchFilterOperator(
+          std::move(scan), "a", LESS, to_string(bound), &bufMgr));
+      unique_ptr<BatchOperator> rightScan(
+          new BatchScanOperator(rightFile, rightSchema, &bufMgr));
+      BatchHashJoinOperator join(std::move(filter), std::move(rightScan),
+                                 &bufMgr);
+      batchResults = join.count();
+    }
+    batchSeconds = secondsSince(start);
+  }
+  File::remove(leftFilename);
+  File::remove(rightFilename);
+
+  cout << "# Result Tuples: " << rowResults << " (row), " << batchResults
+       << " (batch)" << endl;
+  cout << "# Row Engine Rows/sec: " << (long)(numRows / rowSeconds) << endl;
+  cout << "# Batch Engine Rows/sec: " << (long)(numRows / batchSeconds) << endl;
+  cout << "# Speedup: " << rowSeconds / batchSeconds << endl;
+}
+
+/**
+ * Create the tables r and s of main.cpp, scaled to numRows tuples in r and
+ * numRows / 5 in s
+ */
+static void createJoinTables(int numRows,
+                             const TableSchema& leftSchema,
+                             const TableSchema& rightSchema,
+                             const string& leftFilename,
+                             const string& rightFilename,
+                             BufMgr* bufMgr) {
+  std::remove(leftFilename.c_str());
+  std::remove(rightFilename.c_str());
+  int numRightRows = max(1, numRows / 5);
+  File leftFile = File::create(leftFilename);
+  File rightFile = File::create(rightFilename);
+  HeapAppender leftAppender(leftFile, bufMgr, nullptr);
+  for (int i = 0; i < numRows; i++) {
+    vector<string> values = {"r" + to_string(i), to_string(i % numRightRows)};
+    leftAppender.append(
+        HeapFileManager::createTupleFromValues(values, leftSchema));
+  }
+  leftAppender.close();
+  HeapAppender rightAppender(rightFile, bufMgr, nullptr);
+  for (int i = 0; i < numRightRows; i++) {
+    vector<string> values = {to_string(i), "s" + to_string(i)};
+    rightAppender.append(
+        HeapFileManager::createTupleFromValues(values, rightSchema));
+  }
+  rightAppender.close();
+}
+
+/**
+ * Time the r JOIN s of createJoinTables in the parallel nested-loop join
+ * with 1, 2, 4, ... up to maxWorkers workers
+ */
+static void benchParallelJoin(int numRows, int maxWorkers) {
+  TableSchema leftSchema = TableSchema::fromSQLStatement(
+      "CREATE TABLE r (a CHAR(8) UNIQUE NOT NULL, b INT);");
+  TableSchema rightSchema = TableSchema::fromSQLStatement(
+      "CREATE TABLE s (b INT UNIQUE NOT NULL, c VARCHAR(8));");
+  const string leftFilename = "bench_pnlj_r.tbl";
+  const string rightFilename = "bench_pnlj_s.tbl";
+  BufMgr bufMgr(256);
+  createJoinTables(numRows, leftSchema, rightSchema, leftFilename,
+                   rightFilename, &bufMgr);
+
+  // the block keeps the same size, so every run does the same I/Os
+  const int numBlockPages = 8;
+  double oneWorkerSeconds = 0;
+  {
+    File leftFile = File::open(leftFilename);
+    File rightFile = File::open(rightFilename);
+    for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+      ParallelNestedLoopJoinOperator join(leftFile, rightFile, leftSchema,
+                                          rightSchema, nullptr, &bufMgr,
+                                          workers);
+      join.setNumAvailableBufPages(numBlockPages + 2 * workers);
+      auto start = chrono::steady_clock::now();
+      long long results = 0;
+      TupleView tuple;
+      join.open();
+      while (join.next(tuple)) {
+        results++;
+      }
+      join.close();
+      double seconds = secondsSince(start);
+      if (workers == 1)
+        oneWorkerSeconds = seconds;
+      cout << "# Workers: " << workers << ", Result Tuples: " << results
+           << ", I/Os: " << join.getNumIOs() << ", Seconds: " << seconds
+           << ", Speedup: " << oneWorkerSeconds / seconds << endl;
+    }
+  }
+  File::remove(leftFilename);
+  File::remove(rightFilename);
+}
+
+/**
+ * Time the r JOIN s of createJoinTables in the parallel Grace hash join with
+ * 1, 2, 4, ... up to maxWorkers workers sharing 64 buffer pages
+ */
+static void benchParallelHashJoin(int numRows, int maxWorkers) {
+  TableSchema leftSchema = TableSchema::fromSQLStatement(
+      "CREATE TABLE r (a CHAR(8) UNIQUE NOT NULL, b INT);");
+  TableSchema rightSchema = TableSchema::fromSQLStatement(
+      "CREATE TABLE s (b INT UNIQUE NOT NULL, c VARCHAR(8));");
+  const string leftFilename = "bench_pghj_r.tbl";
+  const string rightFilename = "bench_pghj_s.tbl";
+  BufMgr bufMgr(256);
+  createJoinTables(numRows, leftSchema, rightSchema, leftFilename,
+                   rightFilename, &bufMgr);
+
+  // the workers share the same buffer pages in every run
+  const int numBufPages = 64;
+  double oneWorkerSeconds = 0;
+  {
+    File leftFile = File::open(leftFilename);
+    File rightFile = File::open(rightFilename);
+    for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+      ParallelGraceHashJoinOperator join(leftFile, rightFile, leftSchema,
+                                         rightSchema, nullptr, &bufMgr,
+                                         workers);
+      join.setNumAvailableBufPages(numBufPages);
+      auto start = chrono::steady_clock::now();
+      long long results = 0;
+      TupleView tuple;
+      join.open();
+      while (join.next(tuple)) {
+        results++;
+      }
+      join.close();
+      double seconds = secondsSince(start);
+      if (workers == 1)
+        oneWorkerSeconds = seconds;
+      cout << "# Workers: " << join.getNumActiveWorkers()
+           << ", Buckets: " << join.getNumBuckets()
+           << ", Result Tuples: " << results << ", I/Os: " << join.getNumIOs()
+           << ", Seconds: " << seconds
+           << ", Speedup: " << oneWorkerSeconds / seconds << endl;
+    }
+  }
+  File::remove(leftFilename);
+  File::remove(rightFilename);
+}
+
+/**
+ * Time point lookups on a table of numRows tuples through a B+ tree index on
+ * its key, against full scans for the same keys
+ */
+static void benchIndexLookup(int numRows, int numLookups) {
+  TableSchema schema = TableSchema::fromSQLStatement(
+      "CREATE TABLE t (a INT UNIQUE NOT NULL, b VARCHAR(16));");
+  const string tableFilename = "bench_btree_t.tbl";
+  const string indexFilename = "bench_btree_t.a.idx";
+  std::remove(tableFilename.c_str());
+  std::remove(indexFilename.c_str());
+  BufMgr bufMgr(256);
+  {
+    File tableFile = File::create(tableFilename);
+    HeapAppender appender(tableFile, &bufMgr, nullptr);
+    for (int i = 0; i < numRows; i++) {
+      vector<string> values = {to_string(i), "b" + to_string(i)};
+      appender.append(HeapFileManager::createTupleFromValues(values, schema));
+    }
+    appender.close();
+
+    auto start = chrono::steady_clock::now();
+    BTreeIndex index(indexFilename, schema, "a", &bufMgr);
+    index.loadTable(tableFile);
+    cout << "# Bulk Load: " << index.getNumEntries() << " entries, height "
+         << index.getHeight() << ", Seconds: " << secondsSince(start) << endl;
+
+    // the same pseudo-random keys for both
+    vector<string> keys;
+    for (int i = 0; i < numLookups; i++) {
+      keys.push_back(index.makeKey(to_string((i * 7919LL) % numRows)));
+    }
+
+    start = chrono::steady_clock::now();
+    int found = 0;
+    for (const string& key : keys) {
+      RecordId rid;
+      if (!index.lookup(key, rid))
+        continue;
+      Page* page;
+      bufMgr.readPage(&tableFile, rid.page_number, page);
+      std::uint16_t length;
+      if (index.getKey(page->getRecordData(rid, length)) == key)
+        found++;
+      bufMgr.unPinPage(&tableFile, rid.page_number, false);
+    }
+    double indexSeconds = secondsSince(start);
+    double indexRate = keys.size() / indexSeconds;
+    cout << "# Index: " << found << " of " << keys.size()
+         << " found, Lookups/s: " << indexRate << endl;
+
+    // a scan stops at the first match, like a lookup on a unique key
+    const int numScans = min<int>(keys.size(), 50);
+    start = chrono::steady_clock::now();
+    found = 0;
+    for (int i = 0; i < numScans; i++) {
+      bool match = false;
+      for (FileIterator iter = tableFile.begin();
+           !match && iter.page_number() != Page::INVALID_NUMBER; ++iter) {
+        Page* page;
+        bufMgr.readPage(&tableFile, iter.page_number(), page);
+        for (PageIterator record = page->begin(); record != page->end();
+             ++record) {
+          std::uint16_t length;
+          if (index.getKey(record.data(length)) == keys[i]) {
+            match = true;
+            break;
+          }
+        }
+        bufMgr.unPinPage(&tableFile, iter.page_number(), false);
+      }
+      if (match)
+        found++;
+    }
+    double scanRate = numScans / secondsSince(start);
+    cout << "# Full Scan: " << found << " of " << numScans
+         << " found, Lookups/s: " << scanRate
+         << ", Index Speedup: " << indexRate / scanRate << endl;
+    bufMgr.flushFile(&tableFile);
+  }
+  File::remove(tableFilename);
+  File::remove(indexFilename);
+}
+
+/**
+ * Time inserts and point lookups of an extendible hash index against those
+ * of a B+ tree, both on a unique INT attribute and in a pseudo-random order
+ */
+static void benchHashIndex(int numRows, int numLookups) {
+  TableSchema schema = TableSchema::fromSQLStatement(
+      "CREATE TABLE t (a INT UNIQUE NOT NULL, b VARCHAR(16));");
+  const string hashFilename = "bench_hash_t.a.hidx";
+  const string treeFilename = "bench_hash_t.a.idx";
+  std::remove(hashFilename.c_str());
+  std::remove(treeFilename.c_str());
+  BufMgr bufMgr(256);
+  {
+    ExtendibleHashIndex hashIndex(hashFilename, schema, "a", &bufMgr);
+    BTreeIndex treeIndex(treeFilename, schema, "a", &bufMgr);
+    // record IDs as a heap file of 200 tuples per page would give them
+    vector<pair<string, RecordId>> entries;
+    for (int i = 0; i < numRows; i++) {
+      int row = (i * 7919LL) % numRows;
+      entries.push_back(make_pair(
+          hashIndex.makeKey(to_string(row)),
+          RecordId{(PageId)(row / 200 + 1), (SlotId)(row % 200 + 1)}));
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (const auto& entry : entries) {
+      hashIndex.insert(entry.first, entry.second);
+    }
+    double hashRate = entries.size() / secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (const auto& entry : entries) {
+      treeIndex.insert(entry.first, entry.second);
+    }
+    double treeRate = entries.size() / secondsSince(start);
+    cout << "# Inserts/s: hash " << hashRate << ", B+ tree " << treeRate
+         << ", Global Depth: " << hashIndex.getGlobalDepth()
+         << ", Buckets: " << hashIndex.getNumBuckets()
+         << ", Height: " << treeIndex.getHeight() << endl;
+
+    vector<string> keys;
+    for (int i = 0; i < numLookups; i++) {
+      keys.push_back(entries[(i * 104729LL) % numRows].first);
+    }
+    std::uint64_t hashReads = hashIndex.getNumPageReads();
+    start = chrono::steady_clock::now();
+    int found = 0;
+    for (const string& key : keys) {
+      RecordId rid;
+      if (hashIndex.lookup(key, rid))
+        found++;
+    }
+    hashRate = keys.size() / secondsSince(start);
+    hashReads = hashIndex.getNumPageReads() - hashReads;
+    std::uint64_t treeReads = treeIndex.getNumNodeReads();
+    start = chrono::steady_clock::now();
+    for (const string& key : keys) {
+      RecordId rid;
+      if (treeIndex.lookup(key, rid))
+        found++;
+    }
+    treeRate = keys.size() / secondsSince(start);
+    treeReads = treeIndex.getNumNodeReads() - treeReads;
+    cout << "# Lookups/s: hash " << hashRate << " ("
+         << (double)hashReads / keys.size() << " pages), B+ tree " << treeRate
+         << " (" << (double)treeReads / keys.size() << " pages), " << found
+         << " of " << keys.size() * 2 << " found" << endl;
+  }
+  File::remove(hashFilename);
+  File::remove(treeFilename);
+}
+
+/**
+ * Scan of tuples held in memory, so that a join is timed without the I/O of
+ * its inputs
+ */
+class MemoryScanOperator : public Operator {
+ private:
+  /**
+   * Tuples, and the next one to return
+   */
+  const vector<string>& tuples;
+  size_t nextTuple;
+
+ public:
+  MemoryScanOperator(const TableSchema& schema,
+                     const vector<string>& tuples,
+                     BufMgr* bufMgr)
+      : Operator(schema, bufMgr), tuples(tuples), nextTuple(0) {
+    // nothing
+  }
+
+  string getOperatorName() const { return "MEMORY_SCAN"; }
+
+  void open() { nextTuple = 0; }
+
+  bool next(TupleView& tuple) {
+    if (nextTuple == tuples.size())
+      return false;
+    tuple = TupleView(tuples[nextTuple++]);
+    return true;
+  }
+
+  void close() { nextTuple = tuples.size(); }
+
+  int getEstimatedPages() const {
+    size_t bytes = 0;
+    for (const string& tuple : tuples) {
+      bytes += tuple.size() + sizeof(PageSlot);
+    }
+    return bytes / Page::DATA_SIZE + 1;
+  }
+};
+
+/**
+ * CPU seconds of the best of five runs of a join, counting its results
+ */
+static double timeJoin(JoinOperator& join, long long& results) {
+  double best = 0;
+  for (int run = 0; run < 5; run++) {
+    clock_t start = clock();
+    results = 0;
+    TupleView tuple;
+    join.open();
+    while (join.next(tuple)) {
+      results++;
+    }
+    join.close();
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (run == 0 || seconds < best)
+      best = seconds;
+  }
+  return best;
+}
+
+/**
+ * Time the CPU cost of the one-pass hash and block nested-loop joins of
+ * r (k, a INT) with numRows tuples and s (k, b INT) with numRows / 5, held in
+ * memory, joining on an INT, a CHAR(12) and a VARCHAR(12) key k. The string
+ * keys are zero-padded to the full width, as CHAR pads with '0' and would
+ * otherwise make distinct keys equal, so every key type joins the same
+ * pairs.
+ * @throws BadgerDbException If the joins or the key types disagree on the
+ *                           number of results
+ */
+static void benchJoinCpu(int numRows) {
+  const int numRightRows = max(1, numRows / 5);
+  BufMgr bufMgr(16);
+  static const string keyTypes[] = {"INT", "CHAR(12)", "VARCHAR(12)"};
+  long long intResults = -1;
+  for (const string& keyType : keyTypes) {
+    TableSchema leftSchema = TableSchema::fromSQLStatement(
+        "CREATE TABLE r (k " + keyType + ", a INT);");
+    TableSchema rightSchema = TableSchema::fromSQLStatement(
+        "CREATE TABLE s (k " + keyType + ", b INT);");
+    const bool isInt = keyType == "INT";
+    auto keyOf = [isInt](int k) {
+      if (isInt)
+        return to_string(k);
+      char key[16];
+      snprintf(key, sizeof(key), "k%011d", k);
+      return string(key);
+    };
+    vector<string> leftTuples;
+    for (int i = 0; i < numRows; i++) {
+      int k = (i * 7919LL) % numRightRows;
+      vector<string> values = {keyOf(k), to_string(i)};
+      leftTuples.push_back(
+          HeapFileManager::createTupleFromValues(values, leftSchema));
+    }
+    vector<string> rightTuples;
+    for (int i = 0; i < numRightRows; i++) {
+      vector<string> values = {keyOf(i), to_string(i)};
+      rightTuples.push_back(
+          HeapFileManager::createTupleFromValues(values, rightSchema));
+    }
+
+    long long onePassResults, results;
+    OnePassJoinOperator onePass(
+        unique_ptr<Operator>(
+            new MemoryScanOperator(leftSchema, leftTuples, &bufMgr)),
+        unique_ptr<Operator>(
+            new MemoryScanOperator(rightSchema, rightTuples, &bufMgr)),
+        nullptr, &bufMgr);
+    onePass.setNumAvailableBufPages(1 << 20);
+    double onePassSeconds = timeJoin(onePass, onePassResults);
+    NestedLoopJoinOperator nestedLoop(
+        unique_ptr<Operator>(
+            new MemoryScanOperator(leftSchema, leftTuples, &bufMgr)),
+        unique_ptr<Operator>(
+            new MemoryScanOperator(rightSchema, rightTuples, &bufMgr)),
+        nullptr, &bufMgr);
+    nestedLoop.setNumAvailableBufPages(1 << 20);
+    double nestedLoopSeconds = timeJoin(nestedLoop, results);
+    cout << "# Key " << keyType << ": " << results
+         << " Result Tuples, CPU Seconds: one-pass " << onePassSeconds
+         << ", nested-loop " << nestedLoopSeconds << endl;
+    if (isInt)
+      intResults = results;
+    if (onePassResults != results || results != intResults)
+      throw BadgerDbException("join " + keyType + ": " +
+                              to_string(onePassResults) + " and " +
+                              to_string(results) +
+                              " result tuples, expected " +
+                              to_string(intResults));
+  }
+}
+
+/**
+ * Time INT predicates evaluated by the scan kernels of every instruction set
+ * against a branch per row: value < bound and BETWEEN, selecting about half
+ * of the rows, over an in-memory column of numRows values in batches of
+ * RowBatch::CAPACITY rows, then over the pages of a table
+ */
+static void benchIntScan(int numRows) {
+  const int batchRows = RowBatch::CAPACITY;
+  // random values in [0, 1000), so that a branch per row is unpredictable
+  vector<std::int32_t> values(numRows);
+  std::uint64_t seed = 42;
+  for (int i = 0; i < numRows; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    values[i] = (seed >> 33) % 1000;
+  }
+  vector<std::uint64_t> bitmap(IntScanKernels::getBitmapWords(batchRows));
+  vector<std::uint16_t> selection(batchRows);
+  const IntScanKernels::Isa bestIsa = IntScanKernels::getIsa();
+  const IntScanKernels::Isa isas[] = {IntScanKernels::SCALAR,
+                                      IntScanKernels::SSE42,
+                                      IntScanKernels::AVX2};
+
+  // best CPU seconds of five runs of a selection over the column
+  auto timeColumn = [&](const function<int(int, int)>& select) {
+    double best = 0;
+    long long selected = 0;
+    for (int run = 0; run < 5; run++) {
+      clock_t start = clock();
+      selected = 0;
+      for (int first = 0; first < numRows; first += batchRows) {
+        selected += select(first, min(batchRows, numRows - first));
+      }
+      double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+      if (run == 0 || seconds < best)
+        best = seconds;
+    }
+    cout << selected << " Rows, " << (long)(numRows / best) << " Rows/sec"
+         << endl;
+  };
+  cout << "# Column, branch per row: ";
+  timeColumn([&](int first, int num) {
+    int selected = 0;
+    for (int i = 0; i < num; i++) {
+      if (values[first + i] < 500)
+        selection[selected++] = i;
+    }
+    return selected;
+  });
+  for (IntScanKernels::Isa isa : isas) {
+    IntScanKernels::setIsa(isa);
+    if (IntScanKernels::getIsa() != isa)
+      continue;  // not supported by the CPU
+    cout << "# Column, " << IntScanKernels::getIsaName(isa) << " less: ";
+    timeColumn([&](int first, int num) {
+      IntScanKernels::selectColumn(&values[first], num, LESS, 500,
+                                   bitmap.data());
+      return IntScanKernels::toSelection(bitmap.data(), num,
+                                         selection.data());
+    });
+    cout << "# Column, " << IntScanKernels::getIsaName(isa) << " between: ";
+    timeColumn([&](int first, int num) {
+      IntScanKernels::selectColumnBetween(&values[first], num, 250, 749,
+                                          bitmap.data());
+      return IntScanKernels::toSelection(bitmap.data(), num,
+                                         selection.data());
+    });
+  }
+
+  // a filtered scan of a table, its pages held by the buffer pool
+  TableSchema schema = TableSchema::fromSQLStatement(
+      "CREATE TABLE r (a INT, b INT, c VARCHAR(16));");
+  const string filename = "bench_simd_r.tbl";
+  std::remove(filename.c_str());
+  BufMgr bufMgr(numRows / 100 + 64);
+  File file = File::create(filename);
+  {
+    vector<string> tuples;
+    for (int i = 0; i < numRows; i++) {
+      vector<string> tupleValues = {to_string(values[i]), to_string(i),
+                                    "row" + to_string(i)};
+      tuples.push_back(
+          HeapFileManager::createTupleFromValues(tupleValues, schema));
+    }
+    HeapFileManager::bulkInsertTuples(tuples, file, &bufMgr, nullptr);
+  }
+  Predicate predicate = Predicate::conjunction(
+      Predicate::compare(schema, "a", GREATER_EQUAL, "250"),
+      Predicate::compare(schema, "a", LESS_EQUAL, "749"));
+  TupleLayout layout(schema);
+  auto timeScan = [&](Operator& scan) {
+    double best = 0;
+    long long selected = 0;
+    for (int run = 0; run < 5; run++) {
+      clock_t start = clock();
+      selected = 0;
+      TupleView tuple;
+      scan.open();
+      while (scan.next(tuple)) {
+        selected++;
+      }
+      scan.close();
+      double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+      if (run == 0 || seconds < best)
+        best = seconds;
+    }
+    cout << selected << " Tuples, " << (long)(numRows / best)
+         << " Tuples/sec" << endl;
+  };
+  cout << "# Table, predicate per tuple: ";
+  FilterOperator filter(
+      unique_ptr<Operator>(new TableScanOperator(file, schema, &bufMgr)),
+      [&](const TupleView& tuple) {
+        return predicate.evaluate(layout, tuple.data);
+      },
+      &bufMgr);
+  timeScan(filter);
+  for (IntScanKernels::Isa isa : isas) {
+    IntScanKernels::setIsa(isa);
+    if (IntScanKernels::getIsa() != isa)
+      continue;
+    cout << "# Table, " << IntScanKernels::getIsaName(isa) << " between: ";
+    FilteredScanOperator scan(file, schema, predicate, {}, &bufMgr);
+    timeScan(scan);
+  }
+  IntScanKernels::setIsa(bestIsa);
+}
+
+/**
+ * Time mapping numKeys join keys of 4 and 12 bytes to buckets: std::hash of
+ * a string copy modulo the bucket count, against KeyHash one key and eight
+ * keys at a time with multiply-shift
+ */
+static void benchKeyHash(int numKeys) {
+  const std::uint32_t numBuckets = 1000;
+  const std::uint64_t seed = KeyHash::seedOf(1);
+  cout << "# KeyHash: " << (KeyHash::usesCrc32c() ? "CRC32C" : "wyhash-style")
+       << endl;
+  for (int width : {4, 12}) {
+    // INT keys as stored, big-endian, or zero-padded strings
+    vector<char> keys((size_t)numKeys * width, 0);
+    for (int i = 0; i < numKeys; i++) {
+      char* key = &keys[(size_t)i * width];
+      if (width == 4) {
+        key[0] = (char)(i >> 24);
+        key[1] = (char)(i >> 16);
+        key[2] = (char)(i >> 8);
+        key[3] = (char)i;
+      } else {
+        string chars = "k" + to_string(i);
+        memcpy(key, chars.data(), chars.size());
+      }
+    }
+    vector<std::uint32_t> buckets(numKeys);
+    // best CPU seconds of five runs of a way of bucketing all keys
+    auto timeBuckets = [&](const char* name, const function<void()>& run) {
+      double best = 0;
+      for (int r = 0; r < 5; r++) {
+        clock_t start = clock();
+        run();
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (r == 0 || seconds < best)
+          best = seconds;
+      }
+      std::uint64_t check = 0;
+      for (std::uint32_t bucket : buckets) {
+        check += bucket;
+      }
+      cout << "# " << width << "-byte keys, " << name << ": "
+           << (long)(numKeys / best) << " Keys/sec (bucket sum " << check
+           << ")" << endl;
+    };
+    timeBuckets("std::hash", [&]() {
+      std::hash<string> strHash;
+      for (int i = 0; i < numKeys; i++) {
+        buckets[i] =
+            strHash(string(&keys[(size_t)i * width], width)) % numBuckets;
+      }
+    });
+    timeBuckets("KeyHash", [&]() {
+      for (int i = 0; i < numKeys; i++) {
+        buckets[i] = KeyHash::toBucket(
+            KeyHash::hash(&keys[(size_t)i * width], width, seed), numBuckets);
+      }
+    });
+    timeBuckets("KeyHash batch", [&]() {
+      const void* batch[KeyHash::MAX_BATCH];
+      std::uint64_t hashes[KeyHash::MAX_BATCH];
+      for (int i = 0; i < numKeys; i += KeyHash::MAX_BATCH) {
+        int num = min(KeyHash::MAX_BATCH, numKeys - i);
+        for (int k = 0; k < num; k++) {
+          batch[k] = &keys[(size_t)(i + k) * width];
+        }
+        KeyHash::hashBatch(batch, num, width, seed, hashes);
+        for (int k = 0; k < num; k++) {
+          buckets[i + k] = KeyHash::toBucket(hashes[k], numBuckets);
+        }
+      }
+    });
+  }
+}
+
+/**
+ * Time hash aggregation of numRows SC tuples: AVG(Grade) per course, whose
+ * groups fit in memory, and COUNT(*) per student and course, nearly one
+ * group per tuple, in a budget of buffer pages small enough to partition
+ */
+static void benchHashAggregate(int numRows) {
+  TableSchema schema = TableSchema::fromSQLStatement(
+      "CREATE TABLE SC (Sno CHAR(8), Cno CHAR(4), Grade INT);");
+  const string filename = "bench_agg_SC.tbl";
+  std::remove(filename.c_str());
+  BufMgr bufMgr(256);
+  {
+    File file = File::create(filename);
+    {
+      // numbers of a fixed width, as CHAR values are padded with '0'
+      auto fixedWidth = [](char prefix, long number, int width) {
+        string digits = to_string(number);
+        return prefix + string(width - 1 - digits.size(), '0') + digits;
+      };
+      vector<string> tuples;
+      std::uint64_t seed = 42;
+      for (int i = 0; i < numRows; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        vector<string> values = {fixedWidth('S', i / 3, 8),
+                                 fixedWidth('C', (seed >> 33) % 1000, 4),
+                                 to_string((seed >> 20) % 101)};
+        tuples.push_back(
+            HeapFileManager::createTupleFromValues(values, schema));
+      }
+      HeapFileManager::bulkInsertTuples(tuples, file, &bufMgr, nullptr);
+    }
+    auto timeAggregate = [&](const char* name,
+                             const vector<string>& groupAttrNames,
+                             const vector<Aggregate>& aggregates,
+                             int numBufPages) {
+      HashAggregateOperator aggregate(
+          unique_ptr<Operator>(new TableScanOperator(file, schema, &bufMgr)),
+          groupAttrNames, aggregates, &bufMgr);
+      aggregate.setNumAvailableBufPages(numBufPages);
+      double best = 0;
+      for (int run = 0; run < 5; run++) {
+        clock_t start = clock();
+        TupleView tuple;
+        aggregate.open();
+        while (aggregate.next(tuple)) {
+          // nothing
+        }
+        aggregate.close();
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (run == 0 || seconds < best)
+          best = seconds;
+      }
+      cout << "# " << name << ", " << numBufPages << " pages: "
+           << aggregate.getNumGroups() << " Groups, "
+           << aggregate.getNumPartitionFiles() << " Partition Files, "
+           << aggregate.getNumUsedBufPages() << " Used Pages, "
+           << (long)(numRows / best) << " Tuples/sec" << endl;
+    };
+    timeAggregate("AVG(Grade) GROUP BY Cno", {"Cno"},
+                  {Aggregate(AGG_AVG, "Grade")},
+                  HashAggregateOperator::DEFAULT_NUM_BUF_PAGES);
+    timeAggregate("COUNT(*) GROUP BY Sno, Cno", {"Sno", "Cno"},
+                  {Aggregate(AGG_COUNT)},
+                  HashAggregateOperator::DEFAULT_NUM_BUF_PAGES);
+    timeAggregate("COUNT(*) GROUP BY Sno, Cno", {"Sno", "Cno"},
+                  {Aggregate(AGG_COUNT)}, 10);
+    bufMgr.flushFile(&file);
+  }
+  File::remove(filename);
+}
+
+static void usage() {
+  cerr << "Usage: badgerdb_bench <benchmark> [args]" << endl;
+  cerr << "  catalog [tables]    startup time of a persisted catalog" << endl;
+  cerr << "  batch [rows]        row vs. batch engine on a filtered join"
+       << endl;
+  cerr << "  pnlj [rows] [workers]  parallel nested-loop join speedup" << endl;
+  cerr << "  pghj [rows] [workers]  parallel Grace hash join speedup" << endl;
+  cerr << "  btree [rows] [lookups]  B+ tree vs. full scan point lookups"
+       << endl;
+  cerr << "  hash [rows] [lookups]  extendible hash vs. B+ tree inserts and "
+          "lookups"
+       << endl;
+  cerr << "  join [rows]         CPU cost of the joins per key type" << endl;
+  cerr << "  simd [rows]         INT scan kernels vs. a branch per row" << endl;
+  cerr << "  keyhash [keys]      join key hashing into buckets" << endl;
+  cerr << "  agg [rows]          hash aggregation in memory and partitioned"
+       << endl;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+  string name = argv[1];
+  try {
+    if (name == "catalog") {
+      benchCatalogStartup(argc > 2 ? atoi(argv[2]) : 10000);
+    } else if (name == "pnlj") {
+      benchParallelJoin(argc > 2 ? atoi(argv[2]) : 200000,
+                        argc > 3 ? atoi(argv[3])
+                                 : max<int>(thread::hardware_concurrency(), 1));
+    } else if (name == "pghj") {
+      benchParallelHashJoin(argc > 2 ? atoi(argv[2]) : 1000000,
+                            argc > 3 ? atoi(argv[3])
+                                     : max<int>(thread::hardware_concurrency(),
+                                                1));
+    } else if (name == "btree") {
+      benchIndexLookup(argc > 2 ? atoi(argv[2]) : 1000000,
+                       argc > 3 ? atoi(argv[3]) : 100000);
+    } else if (name == "hash") {
+      benchHashIndex(argc > 2 ? atoi(argv[2]) : 1000000,
+                     argc > 3 ? atoi(argv[3]) : 1000000);
+    } else if (name == "join") {
+      benchJoinCpu(argc > 2 ? atoi(argv[2]) : 1000000);
+    } else if (name == "agg") {
+      benchHashAggregate(argc > 2 ? atoi(argv[2]) : 1000000);
+    } else if (name == "keyhash") {
+      benchKeyHash(argc > 2 ? atoi(argv[2]) : 1000000);
+    } else if (name == "simd") {
+      benchIntScan(argc > 2 ? atoi(argv[2]) : 1000000);
+    } else if (name == "batch") {
+      benchBatchExecution(argc > 2 ? atoi(argv[2]) : 1000000);
+    } else {
+      usage();
+      return 1;
+    }
+  } catch (BadgerDbException& e) {
+    cerr << e.message() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "buffer.h"
+#include "catalog.h"
+#include "exceptions/badgerdb_exception.h"
+#include "loader.h"
+
+using namespace badgerdb;
+
+static void usage() {
+  cerr << "Usage: badgerdb_load [-n database] [-j workers] [-c chunk_kb]"
+       << " [-b buf_pages] [-s delimiter] [-H] [-a sample_pages] [-z]"
+       << " <dump.sql | table=data.csv> ..."
+       << endl;
+  cerr << "  Files are loaded in order, a CSV file is loaded into a table"
+       << " created by a dump or an earlier run." << endl;
+  cerr << "  -n  database whose catalog (<database>.cat) is extended,"
+       << " default badgerdb" << endl;
+  cerr << "  -H  CSV files start with a header line" << endl;
+  cerr << "  -a  analyze the loaded tables, sampling at most sample_pages"
+       << " pages each (0 for all)" << endl;
+  cerr << "  -z  build zone maps of the loaded tables" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  string dbName = "badgerdb";
+  int numWorkers = 0;
+  size_t chunkSize = 1 << 20;
+  int bufPages = 100;
+  char delimiter = ',';
+  bool hasHeader = false;
+  int numSamplePages = -1;
+  bool buildZoneMaps = false;
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; ++i) {
+    string opt = argv[i];
+    if (opt == "-H") {
+      hasHeader = true;
+    } else if (opt == "-z") {
+      buildZoneMaps = true;
+    } else if (i + 1 < argc && opt == "-n") {
+      dbName = argv[++i];
+    } else if (i + 1 < argc && opt == "-j") {
+      numWorkers = atoi(argv[++i]);
+    } else if (i + 1 < argc && opt == "-c") {
+      chunkSize = (size_t)atoi(argv[++i]) << 10;
+    } else if (i + 1 < argc && opt == "-b") {
+      bufPages = atoi(argv[++i]);
+    } else if (i + 1 < argc && opt == "-a") {
+      numSamplePages = atoi(argv[++i]);
+    } else if (i + 1 < argc && opt == "-s") {
+      delimiter = argv[++i][0];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (i >= argc || chunkSize == 0 || bufPages <= 0 || numSamplePages < -1) {
+    usage();
+    return 1;
+  }
+
+  BufMgr* bufMgr = new BufMgr(bufPages);
+  Catalog* catalog = new Catalog(dbName);
+  try {
+    catalog->load();
+  } catch (BadgerDbException& e) {
+    cerr << e.message() << endl;
+    delete bufMgr;
+    delete catalog;
+    return 1;
+  }
+
+  BulkLoader loader(catalog, bufMgr, numWorkers, chunkSize);
+  int status = 0;
+  try {
+    for (; i < argc; ++i) {
+      string arg = argv[i];
+      size_t eq = arg.find('=');
+      if (eq == string::npos) {
+        cout << "Loading " << arg << " ..." << endl;
+        loader.loadSQLFile(arg);
+      } else {
+        cout << "Loading " << arg.substr(eq + 1) << " into "
+             << arg.substr(0, eq) << " ..." << endl;
+        loader.loadCSVFile(arg.substr(eq + 1), arg.substr(0, eq), delimiter,
+                           hasHeader);
+      }
+    }
+    if (numSamplePages >= 0) {
+      cout << "Analyzing loaded tables ..." << endl;
+      loader.analyzeTables(numSamplePages);
+    }
+    if (buildZoneMaps) {
+      cout << "Building zone maps of loaded tables ..." << endl;
+      loader.buildZoneMaps();
+    }
+  } catch (BadgerDbException& e) {
+    cerr << e.message() << endl;
+    status = 1;
+  }
+  loader.printStats();
+  try {
+    // keep the tables created before a failure
+    catalog->save();
+  } catch (BadgerDbException& e) {
+    cerr << e.message() << endl;
+    status = 1;
+  }
+
+  delete bufMgr;
+  delete catalog;
+  return status;
+}
@@ -0,0 +1,166 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "tuple.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace badgerdb {
+
+TupleLayout::TupleLayout(const TableSchema& tableSchema) {
+  int offset = 0;
+  for (int i = 0; i < tableSchema.getAttrCount(); ++i) {
+    attrTypes.push_back(tableSchema.getAttrType(i));
+    attrMaxSizes.push_back(tableSchema.getAttrMaxSize(i));
+    fixedOffsets.push_back(offset);
+    if (offset < 0)
+      continue;
+    switch (tableSchema.getAttrType(i)) {
+      case INT:
+        offset += 4;
+        break;
+      case CHAR: {
+        int max_len = tableSchema.getAttrMaxSize(i);
+        offset += max_len + (4 - (max_len % 4)) % 4;
+        break;
+      }
+      case VARCHAR:
+        offset = -1;  // the rest depends on the actual length
+        break;
+    }
+  }
+}
+
+int TupleLayout::getNormalizedWidth(int num) const {
+  return attrTypes[num] == INT ? 4 : attrMaxSizes[num];
+}
+
+void TupleLayout::locate(const char* tuple, AttrSlot* slots) const {
+  int pos = 0;
+  for (int i = 0; i < getAttrCount(); ++i) {
+    switch (attrTypes[i]) {
+      case INT:
+        slots[i].offset = pos;
+        slots[i].length = 4;
+        pos += 4;
+        break;
+      case CHAR: {
+        int max_len = attrMaxSizes[i];
+        slots[i].offset = pos;
+        slots[i].length = max_len;
+        pos += max_len + (4 - (max_len % 4)) % 4;  // align to the multiple of 4
+        break;
+      }
+      case VARCHAR: {
+        int actual_len = (unsigned char)tuple[pos];
+        slots[i].offset = pos + 1;
+        slots[i].length = actual_len;
+        pos += 1 + actual_len +
+               (4 - ((actual_len + 1) % 4)) % 4;  // align to the multiple of 4
+        break;
+      }
+    }
+  }
+}
+
+AttrSlot TupleLayout::locate(const char* tuple, int num) const {
+  AttrSlot slot;
+  int offset = fixedOffsets[num];
+  if (offset < 0) {
+    // walk the attributes behind the last VARCHAR at a fixed offset
+    int i = num;
+    while (fixedOffsets[i] < 0) {
+      i--;
+    }
+    offset = fixedOffsets[i];
+    for (; i < num; ++i) {
+      if (attrTypes[i] == INT) {
+        offset += 4;
+      } else if (attrTypes[i] == CHAR) {
+        offset += attrMaxSizes[i] + (4 - (attrMaxSizes[i] % 4)) % 4;
+      } else {
+        int actual_len = (unsigned char)tuple[offset];
+        offset += 1 + actual_len + (4 - ((actual_len + 1) % 4)) % 4;
+      }
+    }
+  }
+  switch (attrTypes[num]) {
+    case INT:
+      slot.offset = offset;
+      slot.length = 4;
+      break;
+    case CHAR:
+      slot.offset = offset;
+      slot.length = attrMaxSizes[num];
+      break;
+    case VARCHAR:
+      slot.offset = offset + 1;
+      slot.length = (unsigned char)tuple[offset];
+      break;
+  }
+  return slot;
+}
+
+void TupleLayout::appendNormalized(const char* tuple,
+                                   const AttrSlot& slot,
+                                   int num,
+                                   string& key) const {
+  const char* value = tuple + slot.offset;
+  switch (attrTypes[num]) {
+    case INT:
+      // flipping the sign bit makes negative numbers sort first
+      key += (char)(value[0] ^ 0x80);
+      key.append(value + 1, 3);
+      break;
+    case CHAR:
+      key.append(value, slot.length);
+      break;
+    case VARCHAR: {
+      int len = min(slot.length, attrMaxSizes[num]);
+      key.append(value, len);
+      key.append(attrMaxSizes[num] - len, '\0');
+      break;
+    }
+  }
+}
+
+void TupleLayout::appendStored(const char* tuple,
+                               const AttrSlot& slot,
+                               int num,
+                               string& out) const {
+  switch (attrTypes[num]) {
+    case INT:
+      out.append(tuple + slot.offset, 4);
+      break;
+    case CHAR:
+      out.append(tuple + slot.offset,
+                 slot.length + (4 - (slot.length % 4)) % 4);
+      break;
+    case VARCHAR:
+      out.append(tuple + slot.offset - 1,
+                 1 + slot.length + (4 - ((slot.length + 1) % 4)) % 4);
+      break;
+  }
+}
+
+string TupleLayout::formatNormalized(DataType type, const string& key) {
+  switch (type) {
+    case INT: {
+      if (key.size() < 4)
+        return "";
+      string bytes = key;
+      bytes[0] ^= 0x80;
+      return to_string(decodeInt(bytes.data()));
+    }
+    case CHAR:
+      return key;
+    case VARCHAR:
+      return key.substr(0, key.find('\0'));
+  }
+  return key;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,170 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "schema.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Location of an attribute value inside a tuple
+ */
+struct AttrSlot {
+  /**
+   * Offset of the first byte of the value
+   */
+  int offset;
+
+  /**
+   * Length of the value, without the VARCHAR length byte and the padding
+   */
+  int length;
+};
+
+/**
+ * Read-only view of a tuple stored elsewhere, e.g. on a pinned page or in the
+ * buffer of an operator
+ */
+struct TupleView {
+  /**
+   * First byte of the tuple
+   */
+  const char* data;
+
+  /**
+   * Length of the tuple in bytes
+   */
+  int size;
+
+  /**
+   * Constructor
+   */
+  TupleView() : data(nullptr), size(0) {
+    // nothing
+  }
+
+  /**
+   * Constructor
+   */
+  TupleView(const char* data, int size) : data(data), size(size) {
+    // nothing
+  }
+
+  /**
+   * Constructor, viewing a tuple held in a string
+   */
+  explicit TupleView(const string& tuple)
+      : data(tuple.data()), size(tuple.size()) {
+    // nothing
+  }
+
+  /**
+   * Copy the tuple out of the view
+   */
+  string toString() const { return string(data, size); }
+};
+
+/**
+ * Layout of the tuples of a table, as written by
+ * HeapFileManager::createTupleFromValues: an INT is 4 bytes with the most
+ * significant byte first, a CHAR(n) is n bytes, a VARCHAR(n) is a length byte
+ * followed by the characters. Every value is padded to a multiple of 4 bytes.
+ *
+ * Values can also be turned into normalized keys: fixed-width byte strings
+ * (4 bytes for INT, n bytes for CHAR(n) and VARCHAR(n)) whose memcmp order is
+ * the order of the values.
+ */
+class TupleLayout {
+ private:
+  /**
+   * Attribute types
+   */
+  vector<DataType> attrTypes;
+
+  /**
+   * Attribute max sizes
+   */
+  vector<int> attrMaxSizes;
+
+  /**
+   * Offset of each attribute, or -1 if it follows a VARCHAR
+   */
+  vector<int> fixedOffsets;
+
+ public:
+  /**
+   * Constructor
+   */
+  explicit TupleLayout(const TableSchema& tableSchema);
+
+  /**
+   * Get the number of attributes
+   */
+  int getAttrCount() const { return attrTypes.size(); }
+
+  /**
+   * Get the type of the num-th attribute
+   */
+  DataType getAttrType(int num) const { return attrTypes[num]; }
+
+  /**
+   * Get the offset of the num-th attribute, or -1 if it depends on the tuple
+   */
+  int getFixedOffset(int num) const { return fixedOffsets[num]; }
+
+  /**
+   * Get the width of the normalized key of the num-th attribute
+   */
+  int getNormalizedWidth(int num) const;
+
+  /**
+   * Locate all attributes of a tuple, slots must hold getAttrCount() entries
+   */
+  void locate(const char* tuple, AttrSlot* slots) const;
+
+  /**
+   * Locate the num-th attribute of a tuple
+   */
+  AttrSlot locate(const char* tuple, int num) const;
+
+  /**
+   * Append the normalized key of the num-th attribute located at slot
+   */
+  void appendNormalized(const char* tuple,
+                        const AttrSlot& slot,
+                        int num,
+                        string& key) const;
+
+  /**
+   * Append the num-th attribute located at slot as it is stored, with the
+   * VARCHAR length byte and the padding
+   */
+  void appendStored(const char* tuple,
+                    const AttrSlot& slot,
+                    int num,
+                    string& out) const;
+
+  /**
+   * Decode a 4-byte INT value
+   */
+  static int decodeInt(const char* bytes) {
+    return (int)(((unsigned)(unsigned char)bytes[0] << 24) |
+                 ((unsigned)(unsigned char)bytes[1] << 16) |
+                 ((unsigned)(unsigned char)bytes[2] << 8) |
+                 (unsigned)(unsigned char)bytes[3]);
+  }
+
+  /**
+   * Get a printable form of a normalized key of the given type
+   */
+  static string formatNormalized(DataType type, const string& key);
+};
+
+}  // namespace badgerdb
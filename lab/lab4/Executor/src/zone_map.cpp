@@ -0,0 +1,185 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#include "zone_map.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "exceptions/badgerdb_exception.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Zone map file layout, all integers in native byte order:
+ *
+ *   magic, bytes of a zone, number of zones
+ *   per zone: page number, number of tuples, minimum and maximum of every
+ *   summarized attribute
+ */
+static const std::uint32_t ZONE_MAP_MAGIC = 0x5a424442;  // "BDBZ"
+
+ZoneMap::ZoneMap(const TableSchema& tableSchema)
+    : layout(tableSchema),
+      zoneOffsets(tableSchema.getAttrCount(), -1),
+      zoneBytes(0) {
+  for (int i = 0; i < layout.getAttrCount(); ++i) {
+    DataType type = layout.getAttrType(i);
+    if (type != INT && type != CHAR)
+      continue;
+    attrNums.push_back(i);
+    zoneOffsets[i] = zoneBytes;
+    zoneBytes += 2 * layout.getNormalizedWidth(i);
+  }
+}
+
+std::uint32_t ZoneMap::findZone(PageId pageNumber) {
+  auto it = zoneOfPage.find(pageNumber);
+  if (it != zoneOfPage.end())
+    return it->second;
+  std::uint32_t zone = pageNumbers.size();
+  zoneOfPage[pageNumber] = zone;
+  pageNumbers.push_back(pageNumber);
+  numTuples.push_back(0);
+  bounds.append(zoneBytes, '\0');
+  return zone;
+}
+
+bool ZoneMap::getZone(PageId pageNumber, std::uint32_t& zone) const {
+  auto it = zoneOfPage.find(pageNumber);
+  if (it == zoneOfPage.end())
+    return false;
+  zone = it->second;
+  return true;
+}
+
+void ZoneMap::addTuple(PageId pageNumber, const char* tuple) {
+  std::uint32_t zone = findZone(pageNumber);
+  char* bytes = &bounds[(size_t)zone * zoneBytes];
+  bool first = numTuples[zone]++ == 0;
+  string key;
+  for (int num : attrNums) {
+    key.clear();
+    layout.appendNormalized(tuple, layout.locate(tuple, num), num, key);
+    char* min_key = bytes + zoneOffsets[num];
+    char* max_key = min_key + key.size();
+    if (first || memcmp(key.data(), min_key, key.size()) < 0)
+      memcpy(min_key, key.data(), key.size());
+    if (first || memcmp(key.data(), max_key, key.size()) > 0)
+      memcpy(max_key, key.data(), key.size());
+  }
+}
+
+void ZoneMap::build(File& tableFile, BufMgr* bufMgr) {
+  pageNumbers.clear();
+  numTuples.clear();
+  bounds.clear();
+  zoneOfPage.clear();
+  for (FileIterator iter = tableFile.begin(); iter != tableFile.end();
+       ++iter) {
+    PageId page_number = iter.page_number();
+    findZone(page_number);
+    Page* page;
+    bufMgr->readPage(&tableFile, page_number, page);
+    for (PageIterator record = page->begin(); record != page->end();
+         ++record) {
+      std::uint16_t length;
+      addTuple(page_number, record.data(length));
+    }
+    bufMgr->unPinPage(&tableFile, page_number, false);
+  }
+  // the frames are keyed by the caller's file handle
+  bufMgr->flushFile(&tableFile);
+}
+
+bool ZoneMap::mayMatch(std::uint32_t zone,
+                       int attrNum,
+                       const string& low,
+                       bool lowInclusive,
+                       const string& high,
+                       bool highInclusive) const {
+  if (numTuples[zone] == 0)
+    return false;
+  const int width = layout.getNormalizedWidth(attrNum);
+  const char* min_key = bounds.data() + (size_t)zone * zoneBytes +
+                        zoneOffsets[attrNum];
+  const char* max_key = min_key + width;
+  if (!low.empty()) {
+    int cmp = memcmp(max_key, low.data(), width);
+    if (cmp < 0 || (cmp == 0 && !lowInclusive))
+      return false;
+  }
+  if (!high.empty()) {
+    int cmp = memcmp(min_key, high.data(), width);
+    if (cmp > 0 || (cmp == 0 && !highInclusive))
+      return false;
+  }
+  return true;
+}
+
+void ZoneMap::save(const string& filename) const {
+  string out;
+  std::uint32_t header[3] = {ZONE_MAP_MAGIC, (std::uint32_t)zoneBytes,
+                             (std::uint32_t)pageNumbers.size()};
+  out.append(reinterpret_cast<const char*>(header), sizeof(header));
+  for (size_t zone = 0; zone < pageNumbers.size(); ++zone) {
+    out.append(reinterpret_cast<const char*>(&pageNumbers[zone]),
+               sizeof(PageId));
+    out.append(reinterpret_cast<const char*>(&numTuples[zone]),
+               sizeof(std::uint32_t));
+    out.append(bounds, zone * zoneBytes, zoneBytes);
+  }
+
+  // like the catalog, replace the old file only once the new one is written
+  const string tmpFilename = filename + ".tmp";
+  {
+    ofstream file(tmpFilename, ios::binary | ios::trunc);
+    file.write(out.data(), out.size());
+    if (!file.flush())
+      throw BadgerDbException("Cannot write zone map file " + tmpFilename);
+  }
+  if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    throw BadgerDbException("Cannot replace zone map file " + filename);
+}
+
+bool ZoneMap::load(const string& filename) {
+  ifstream file(filename, ios::binary | ios::ate);
+  if (!file)
+    return false;
+  string buffer(file.tellg(), '\0');
+  file.seekg(0, ios::beg);
+  file.read(&buffer[0], buffer.size());
+
+  std::uint32_t header[3];
+  const size_t zone_record = sizeof(PageId) + sizeof(std::uint32_t) +
+                             zoneBytes;
+  if (buffer.size() < sizeof(header))
+    throw BadgerDbException("Not a zone map file: " + filename);
+  memcpy(header, buffer.data(), sizeof(header));
+  if (header[0] != ZONE_MAP_MAGIC || (int)header[1] != zoneBytes ||
+      buffer.size() != sizeof(header) + header[2] * zone_record)
+    throw BadgerDbException("Not a zone map of this table: " + filename);
+
+  pageNumbers.resize(header[2]);
+  numTuples.resize(header[2]);
+  bounds.resize((size_t)header[2] * zoneBytes);
+  zoneOfPage.clear();
+  const char* pos = buffer.data() + sizeof(header);
+  for (std::uint32_t zone = 0; zone < header[2]; ++zone) {
+    memcpy(&pageNumbers[zone], pos, sizeof(PageId));
+    memcpy(&numTuples[zone], pos + sizeof(PageId), sizeof(std::uint32_t));
+    memcpy(&bounds[(size_t)zone * zoneBytes],
+           pos + sizeof(PageId) + sizeof(std::uint32_t), zoneBytes);
+    zoneOfPage[pageNumbers[zone]] = zone;
+    pos += zone_record;
+  }
+  return true;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,152 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "schema.h"
+#include "tuple.h"
+#include "types.h"
+
+using namespace std;
+
+namespace badgerdb {
+
+/**
+ * Zone map of a table: the smallest and largest value of every INT and CHAR
+ * attribute on each page of the table file, as normalized keys. A scan with
+ * a range predicate on such an attribute skips the pages whose range cannot
+ * match without reading them.
+ *
+ * Inserts and updates only widen the range of a page and deletes leave it
+ * as it is, so the ranges stay conservative until the map is rebuilt. The
+ * zone map of a table is owned by the catalog, saved next to the table file
+ * and kept up to date by the HeapFileManager writes, like the table
+ * statistics.
+ */
+class ZoneMap {
+ private:
+  /**
+   * Layout of the table
+   */
+  TupleLayout layout;
+
+  /**
+   * Summarized attributes, in schema order
+   */
+  vector<int> attrNums;
+
+  /**
+   * Per attribute of the table: offset of its minimum in a zone, or -1 if
+   * it is not summarized. The maximum follows the minimum.
+   */
+  vector<int> zoneOffsets;
+
+  /**
+   * Bytes of a zone: minimum and maximum of every summarized attribute
+   */
+  int zoneBytes;
+
+  /**
+   * Page of every zone, in the order the pages were added
+   */
+  vector<PageId> pageNumbers;
+
+  /**
+   * Number of tuples added to every zone; a zone without any never matches
+   */
+  vector<std::uint32_t> numTuples;
+
+  /**
+   * Zones, zoneBytes each
+   */
+  string bounds;
+
+  /**
+   * Zone of every page
+   */
+  unordered_map<PageId, std::uint32_t> zoneOfPage;
+
+  /**
+   * Get the zone of a page, adding an empty one if the page is new
+   */
+  std::uint32_t findZone(PageId pageNumber);
+
+ public:
+  /**
+   * Constructor of an empty zone map of a table
+   */
+  explicit ZoneMap(const TableSchema& tableSchema);
+
+  /**
+   * Get the name of the file the zone map of a table file is saved in
+   */
+  static string getFilename(const string& tableFilename) {
+    return tableFilename + ".zmap";
+  }
+
+  /**
+   * Is an attribute summarized?
+   */
+  bool hasAttr(int attrNum) const { return zoneOffsets[attrNum] >= 0; }
+
+  /**
+   * Widen the zone of a page to the values of a tuple stored in it, adding
+   * the zone if the page is new
+   */
+  void addTuple(PageId pageNumber, const char* tuple);
+
+  /**
+   * Rebuild the zones from every page of the table file
+   */
+  void build(File& tableFile, BufMgr* bufMgr);
+
+  /**
+   * Get the number of zones
+   */
+  std::uint32_t getNumZones() const { return pageNumbers.size(); }
+
+  /**
+   * Get the page of a zone
+   */
+  PageId getPageNumber(std::uint32_t zone) const { return pageNumbers[zone]; }
+
+  /**
+   * Find the zone of a page
+   * @return False if the page has none
+   */
+  bool getZone(PageId pageNumber, std::uint32_t& zone) const;
+
+  /**
+   * May a zone hold a value of a summarized attribute between low and high?
+   * The bounds are normalized keys; an empty one is unbounded.
+   */
+  bool mayMatch(std::uint32_t zone,
+                int attrNum,
+                const string& low,
+                bool lowInclusive,
+                const string& high,
+                bool highInclusive) const;
+
+  /**
+   * Write the zone map to a file
+   * @throws BadgerDbException If the file cannot be written
+   */
+  void save(const string& filename) const;
+
+  /**
+   * Replace the zones by those saved in a file
+   * @return False if there is no such file
+   * @throws BadgerDbException If the file holds no zone map of this table
+   */
+  bool load(const string& filename);
+};
+
+}  // namespace badgerdb